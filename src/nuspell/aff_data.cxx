@@ -23,14 +23,23 @@
 
 #include "aff_data.hxx"
 
+#include "load_stats.hxx"
 #include "locale_utils.hxx"
 #include "string_utils.hxx"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <regex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <fstream> // Only here for logging.
 #include <iomanip> // Only here for logging.
@@ -165,35 +174,23 @@ auto parse_vector_of_T(istream& in, size_t line_num, const string& command,
 	}
 }
 
+const auto flags_non_ascii_err_message =
+    "Nuspell warning: bytes above 127 in UTF-8 stream should not be treated "
+    "alone as flags, please update dictionary to use FLAG UTF-8 and make the "
+    "file valid UTF-8";
+
 /**
- * Decodes flags.
+ * Decodes flags from a single whitespace delimited token.
  *
- * Expects that there are flags in the stream.
- * If there are no flags in the stream (eg, stream is at eof)
- * or if the format of the flags is incorrect the stream failbit will be set.
+ * Used for all flag types except FLAG_NUMBER.
  */
-auto decode_flags(istream& in, size_t line_num, Flag_Type t,
-                  const Encoding& enc) -> u16string
+auto decode_flags_token(const string& s, size_t line_num, Flag_Type t,
+                        const Encoding& enc, u16string& ret) -> void
 {
-	string s;
-	u16string ret;
-	const auto err_message = "Nuspell warning: bytes above 127 in UTF-8 "
-	                         "stream should not be treated alone as "
-	                         "flags, please update dictionary to use "
-	                         "FLAG UTF-8 and make the file valid UTF-8";
 	switch (t) {
 	case FLAG_SINGLE_CHAR:
-		in >> s;
-		if (in.fail()) {
-			// err no flag at all
-			cerr << "Nuspell error: missing single-character flag "
-			        "in line "
-			     << line_num << endl;
-			exit(0);
-			break;
-		}
 		if (enc.is_utf8() && !is_all_ascii(s)) {
-			cerr << err_message << "\n";
+			cerr << flags_non_ascii_err_message << "\n";
 			cerr << "Nuspell warning in line " << line_num << "\n"
 			     << endl;
 			// This error will be triggered in Hungarian.
@@ -208,16 +205,8 @@ auto decode_flags(istream& in, size_t line_num, Flag_Type t,
 		latin1_to_ucs2(s, ret);
 		break;
 	case FLAG_DOUBLE_CHAR: {
-		in >> s;
-		if (in.fail()) {
-			// err no flag at all
-			cerr << "Nuspell error: missing double-character flag "
-			        "in line "
-			     << line_num << endl;
-			break;
-		}
 		if (enc.is_utf8() && !is_all_ascii(s)) {
-			cerr << err_message << "\n";
+			cerr << flags_non_ascii_err_message << "\n";
 			cerr << "Nuspell warning in line " << line_num << endl;
 		}
 		auto i = s.begin();
@@ -236,44 +225,8 @@ auto decode_flags(istream& in, size_t line_num, Flag_Type t,
 		break;
 	}
 	case FLAG_NUMBER:
-		unsigned short flag;
-		in >> flag;
-		if (in.fail()) {
-			// err no flag at all
-			cerr << "Nuspell error: missing numerical flag in line "
-			     << line_num << endl;
-			break;
-		}
-		ret.push_back(flag);
-		// peek can set failbit
-		while (in.good() && in.peek() == ',') {
-			in.get();
-			if (in >> flag) {
-				ret.push_back(flag);
-			}
-			else {
-				// err, comma and no number after that
-				cerr << "Nuspell error: long flag, no number "
-				        "after comma"
-				     << endl;
-				break;
-			}
-		}
 		break;
 	case FLAG_UTF8: {
-		in >> s;
-		if (!enc.is_utf8()) {
-			// err
-			cerr << "Nuspell error: file encoding is not UTF-8, "
-			        "yet flags are"
-			     << endl;
-		}
-		if (in.fail()) {
-			// err no flag at all
-			cerr << "Nuspell error: missing UTF-8 flag in line "
-			     << line_num << endl;
-			break;
-		}
 		auto u32flags = boost::locale::conv::utf_to_utf<char32_t>(s);
 		if (!is_all_bmp(u32flags)) {
 			cerr << "Nuspell warning: flags must be in BMP, "
@@ -284,9 +237,172 @@ auto decode_flags(istream& in, size_t line_num, Flag_Type t,
 		break;
 	}
 	}
+}
+
+auto report_missing_flags(size_t line_num, Flag_Type t) -> void
+{
+	switch (t) {
+	case FLAG_SINGLE_CHAR:
+		// err no flag at all
+		cerr << "Nuspell error: missing single-character flag "
+		        "in line "
+		     << line_num << endl;
+		exit(0);
+		break;
+	case FLAG_DOUBLE_CHAR:
+		cerr << "Nuspell error: missing double-character flag "
+		        "in line "
+		     << line_num << endl;
+		break;
+	case FLAG_NUMBER:
+		cerr << "Nuspell error: missing numerical flag in line "
+		     << line_num << endl;
+		break;
+	case FLAG_UTF8:
+		cerr << "Nuspell error: missing UTF-8 flag in line "
+		     << line_num << endl;
+		break;
+	}
+}
+
+/**
+ * Decodes flags.
+ *
+ * Expects that there are flags in the stream.
+ * If there are no flags in the stream (eg, stream is at eof)
+ * or if the format of the flags is incorrect the stream failbit will be set.
+ */
+auto decode_flags(istream& in, size_t line_num, Flag_Type t,
+                  const Encoding& enc) -> u16string
+{
+	string s;
+	u16string ret;
+	if (t == FLAG_UTF8 && !enc.is_utf8()) {
+		// err
+		cerr << "Nuspell error: file encoding is not UTF-8, "
+		        "yet flags are"
+		     << endl;
+	}
+	if (t != FLAG_NUMBER) {
+		in >> s;
+		if (in.fail())
+			report_missing_flags(line_num, t);
+		else
+			decode_flags_token(s, line_num, t, enc, ret);
+		return ret;
+	}
+	unsigned short flag;
+	in >> flag;
+	if (in.fail()) {
+		report_missing_flags(line_num, t);
+		return ret;
+	}
+	ret.push_back(flag);
+	// peek can set failbit
+	while (in.good() && in.peek() == ',') {
+		in.get();
+		if (in >> flag) {
+			ret.push_back(flag);
+		}
+		else {
+			// err, comma and no number after that
+			cerr << "Nuspell error: long flag, no number "
+			        "after comma"
+			     << endl;
+			break;
+		}
+	}
 	return ret;
 }
 
+/**
+ * Skips whitespace as std::ws does with the classic locale.
+ */
+auto skip_space(const char*& first, const char* last) -> void
+{
+	while (first != last && (*first == ' ' || ('\t' <= *first &&
+	                                            *first <= '\r')))
+		++first;
+}
+
+/**
+ * Parses unsigned integer in the way operator>> does with the classic locale.
+ *
+ * @return false if there is no number or if it is larger than @p max.
+ */
+auto parse_unsigned(const char*& first, const char* last, size_t max,
+                    size_t& out) -> bool
+{
+	skip_space(first, last);
+	auto p = first;
+	size_t x = 0;
+	for (; p != last && '0' <= *p && *p <= '9'; ++p) {
+		size_t d = *p - '0';
+		if (x > (max - d) / 10)
+			return false;
+		x = x * 10 + d;
+	}
+	if (p == first)
+		return false;
+	first = p;
+	out = x;
+	return true;
+}
+
+/**
+ * Decodes flags from a range of characters.
+ *
+ * Same as decode_flags() for streams but without the overhead of a stream.
+ * The range is advanced past the decoded flags.
+ *
+ * @return false on the same conditions that set failbit in decode_flags().
+ */
+auto decode_flags(const char*& first, const char* last, size_t line_num,
+                  Flag_Type t, const Encoding& enc, u16string& out) -> bool
+{
+	out.clear();
+	if (t == FLAG_UTF8 && !enc.is_utf8()) {
+		// err
+		cerr << "Nuspell error: file encoding is not UTF-8, "
+		        "yet flags are"
+		     << endl;
+	}
+	if (t != FLAG_NUMBER) {
+		skip_space(first, last);
+		auto token_end = first;
+		while (token_end != last && *token_end != ' ' &&
+		       !('\t' <= *token_end && *token_end <= '\r'))
+			++token_end;
+		if (token_end == first) {
+			report_missing_flags(line_num, t);
+			return false;
+		}
+		// the token is almost always short, no allocation due to SSO
+		auto s = string(first, token_end);
+		first = token_end;
+		decode_flags_token(s, line_num, t, enc, out);
+		return true;
+	}
+	size_t flag;
+	if (!parse_unsigned(first, last, 0xFFFF, flag)) {
+		report_missing_flags(line_num, t);
+		return false;
+	}
+	out.push_back(flag);
+	while (first != last && *first == ',') {
+		++first;
+		if (!parse_unsigned(first, last, 0xFFFF, flag)) {
+			// err, comma and no number after that
+			cerr << "Nuspell error: long flag, no number "
+			        "after comma"
+			     << endl;
+			return false;
+		}
+		out.push_back(flag);
+	}
+	return true;
+}
+
 /**
  * Decodes a single flag from an input stream.
  *
@@ -324,6 +440,25 @@ auto decode_flags_possible_alias(istream& in, size_t line_num, Flag_Type t,
 	return {};
 }
 
+auto decode_flags_possible_alias(const char*& first, const char* last,
+                                 size_t line_num, Flag_Type t,
+                                 const Encoding& enc,
+                                 const vector<Flag_Set>& flag_aliases,
+                                 u16string& out) -> bool
+{
+	if (flag_aliases.empty())
+		return decode_flags(first, last, line_num, t, enc, out);
+	out.clear();
+	size_t i;
+	if (!parse_unsigned(first, last, SIZE_MAX, i))
+		return false;
+	if (0 < i && i <= flag_aliases.size())
+		out = flag_aliases[i - 1];
+	else
+		cerr << "Nuspell error: invalid flag alias index\n";
+	return true;
+}
+
 /**
  * Parses morhological fields.
  *
@@ -529,14 +664,92 @@ auto Aff_Data::set_encoding_and_language(const string& enc, const string& lang)
 	install_ctype_facets_inplace(locale_aff);
 }
 
+/**
+ * @brief Splits a MAP entry into the related characters.
+ *
+ * Related strings of more than one character are in parentheses, e.g. the
+ * entry "(ss)ß" relates "ss" and "ß".
+ */
+template <class CharT>
+auto split_map_entry(const basic_string<CharT>& e)
+    -> vector<basic_string<CharT>>
+{
+	auto ret = vector<basic_string<CharT>>();
+	for (size_t i = 0; i != e.size(); ++i) {
+		auto j = e.npos;
+		if (e[i] == '(')
+			j = e.find(')', i);
+		if (j == e.npos) {
+			ret.emplace_back(1, e[i]);
+			continue;
+		}
+		if (j != i + 1)
+			ret.push_back(e.substr(i + 1, j - i - 1));
+		i = j;
+	}
+	return ret;
+}
+
+template <class CharT>
+auto fill_suggest_structures(const Aff_Data& a, Aff_Structures<CharT>& s)
+    -> void
+{
+	using StrT = basic_string<CharT>;
+	auto cvt = [](auto& x) {
+		return StrT(from_dict_to_wide_encoding<CharT>(x));
+	};
+	s.try_chars = cvt(a.try_chars);
+
+	s.keyboard_table = cvt(a.keyboard_layout);
+
+	// underscore in REP stands for space
+	auto replacements = vector<pair<StrT, StrT>>();
+	for (auto& r : a.replacements) {
+		auto from = cvt(r.first);
+		auto to = cvt(r.second);
+		replace(begin(from), end(from), CharT('_'), CharT(' '));
+		replace(begin(to), end(to), CharT('_'), CharT(' '));
+		replacements.emplace_back(move(from), move(to));
+	}
+	s.replacement_table = replacements;
+
+	s.map_related_chars.clear();
+	for (auto& m : a.map_related_chars)
+		s.map_related_chars.push_back(split_map_entry(cvt(m)));
+
+	auto phone = vector<pair<StrT, StrT>>();
+	for (auto& r : a.phonetic_replacements)
+		phone.emplace_back(cvt(r.first), cvt(r.second));
+	s.phonetic_table = phone;
+}
+
+/**
+ * Converts the suggestion options to the encoding of the affix structures.
+ *
+ * Fills the suggestion members of the structures that match the encoding of
+ * the dictionary, from the options as they were read from the affix file.
+ * It must be called after the options or the encoding change.
+ */
+auto Aff_Data::set_suggest_structures() -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		fill_suggest_structures(*this, wide_structures);
+	else
+		fill_suggest_structures(*this, structures);
+}
+
 /**
  * Parses an input stream offering affix information.
  *
+ * Adds its timings and counts to the Load_Stats of the thread, if enabled.
+ *
  * @param in input stream to parse from.
  * @return true on success.
  */
 auto Aff_Data::parse_aff(istream& in) -> bool
 {
+	auto stats = get_load_stats();
+	Load_Timer timer(stats ? &stats->aff_seconds : nullptr);
 	Encoding encoding;
 	string language_code;
 	string ignore_chars;
@@ -549,6 +762,10 @@ auto Aff_Data::parse_aff(istream& in) -> bool
 	bool break_exists = false;
 
 	flag_type = FLAG_SINGLE_CHAR;
+	// as in Hunspell, 0 turns the n-gram suggestions off
+	max_ngram_suggestions = -1;
+	// as in Hunspell, a negative value is the default of MAXDIFF
+	max_diff_factor = -1;
 
 	unordered_map<string, string*> command_strings = {
 	    {"LANG", &language_code},
@@ -772,6 +989,8 @@ auto Aff_Data::parse_aff(istream& in) -> bool
 			    << line_num << ": " << line << endl;
 		}
 	}
+	Load_Timer structures_timer(stats ? &stats->aff_structures_seconds
+	                                  : nullptr);
 	// default BREAK definition
 	if (!break_exists) {
 		break_patterns.push_back("-");
@@ -831,6 +1050,14 @@ auto Aff_Data::parse_aff(istream& in) -> bool
 		}
 	}
 
+	set_suggest_structures();
+
+	if (stats) {
+		stats->aff_lines += line_num;
+		stats->prefixes += prefixes.size();
+		stats->suffixes += suffixes.size();
+		stats->flag_aliases += flag_aliases.size();
+	}
 	cerr.flush();
 	return in.eof(); // success when eof is reached
 }
@@ -841,7 +1068,7 @@ auto Aff_Data::parse_aff(istream& in) -> bool
  *
  * @returns the end of the word before the morph field, or npos
  */
-auto dic_find_end_of_word_heuristics(const string& line)
+auto dic_find_end_of_word_heuristics(my_string_view<char> line)
 {
 	if (line.size() < 4)
 		return line.npos;
@@ -864,154 +1091,1040 @@ auto dic_find_end_of_word_heuristics(const string& line)
 }
 
 /**
- * Parses an input stream offering dictionary information.
+ * @brief Classifies casing of byte strings with a precomputed table.
  *
- * @param in input stream to read from.
- * @param aff affix data to retrive locale and flag settings from.
- * @return true on success.
+ * Gives the same results as classify_casing() for std::string, but queries
+ * the ctype facet only once instead of twice per byte.
  */
-auto Aff_Data::parse_dic(istream& in) -> bool
-{
-	size_t line_number = 1;
-	size_t approximate_size;
-	istringstream ss;
-	string line;
-
-	// locale must be without thousands separator.
-	auto loc = locale::classic();
-	in.imbue(loc);
-	ss.imbue(loc);
-	strip_bom(in);
-	if (!getline(in, line)) {
-		return false;
+class Byte_Casing_Classifier {
+	ctype_base::mask masks[256];
+
+      public:
+	Byte_Casing_Classifier(const locale& loc)
+	{
+		char chars[256];
+		for (size_t i = 0; i != 256; ++i)
+			chars[i] = static_cast<char>(i);
+		use_facet<ctype<char>>(loc).is(begin(chars), end(chars), masks);
 	}
-	auto encoding =
-	    Encoding(use_facet<boost::locale::info>(locale_aff).encoding());
-	if (encoding.is_utf8() && !validate_utf8(line)) {
-		cerr << "Invalid utf in dic file" << endl;
+	auto is_upper(char c) const
+	{
+		return (masks[static_cast<unsigned char>(c)] &
+		        ctype_base::upper) != 0;
 	}
-	ss.str(line);
-	if (ss >> approximate_size) {
-		words.reserve(approximate_size);
+	auto is_lower(char c) const
+	{
+		return (masks[static_cast<unsigned char>(c)] &
+		        ctype_base::lower) != 0;
 	}
-	else {
-		return false;
+	auto operator()(my_string_view<char> s) const -> Casing
+	{
+		size_t upper = 0;
+		size_t lower = 0;
+		for (auto c : s) {
+			if (is_upper(c))
+				upper++;
+			else if (is_lower(c))
+				lower++;
+		}
+		if (upper == 0)
+			return Casing::SMALL;
+		auto first_capital = is_upper(s[0]);
+		if (first_capital && upper == 1)
+			return Casing::INIT_CAPITAL;
+		if (lower == 0)
+			return Casing::ALL_CAPITAL;
+		if (first_capital)
+			return Casing::PASCAL;
+		else
+			return Casing::CAMEL;
+	}
+};
+
+/**
+ * @brief Finds the word in a line of a .dic file.
+ *
+ * @return the size of the word, and the position of the flags after the
+ * slash, or npos if there are no flags.
+ */
+auto split_dic_line(my_string_view<char> line) -> pair<size_t, size_t>
+{
+	size_t slash_pos = 0;
+	for (;;) {
+		slash_pos = line.find('/', slash_pos);
+		if (slash_pos == line.npos)
+			break;
+		if (slash_pos == 0)
+			break;
+		if (line[slash_pos - 1] != '\\')
+			break;
+		++slash_pos;
 	}
+	if (slash_pos != line.npos) {
+		// slash found, word until slash
+		return {slash_pos, slash_pos + 1};
+	}
+	auto tab_pos = line.find('\t');
+	if (tab_pos != line.npos) {
+		// Tab found, word until tab. No flags.
+		// After tab follow morphological fields
+		return {tab_pos, line.npos};
+	}
+	auto end = dic_find_end_of_word_heuristics(line);
+	return {min(end, line.size()), line.npos};
+}
 
+/**
+ * @brief Parses the lines of a .dic file in the range [first, last).
+ *
+ * The range must start at the beginning of a line. Calls
+ * f(word, flags, casing) for each word that should be added.
+ *
+ * @param line_number line number of the line before the first one.
+ */
+template <class Func>
+auto parse_dic_lines(const char* first, const char* last, size_t line_number,
+                     Flag_Type flag_type, const Encoding& encoding,
+                     const vector<Flag_Set>& flag_aliases,
+                     const Byte_Casing_Classifier& is_casing, Func f) -> void
+{
 	string word;
-	string morph;
-	vector<string> morphs;
 	u16string flags;
-
-	while (getline(in, line)) {
+	for (const char* next; first != last; first = next) {
+		auto line_end = find(first, last, '\n');
+		next = line_end == last ? last : line_end + 1;
 		line_number++;
-		ss.str(line);
-		ss.clear();
-		word.clear();
-		morph.clear();
+		auto line = my_string_view<char>(first, line_end - first);
 		flags.clear();
-		morphs.clear();
 
-		if (encoding.is_utf8() && !validate_utf8(line)) {
-			cerr << "Invalid utf in dic file" << endl;
-		}
-		size_t slash_pos = 0;
-		for (;;) {
-			slash_pos = line.find('/', slash_pos);
-			if (slash_pos == line.npos)
-				break;
-			if (slash_pos == 0)
-				break;
-			if (line[slash_pos - 1] != '\\')
-				break;
-			++slash_pos;
-		}
-		if (slash_pos != line.npos) {
-			// slash found, word until slash
-			word.assign(line, 0, slash_pos);
-			ss.ignore(slash_pos + 1);
-			flags = decode_flags_possible_alias(
-			    ss, line_number, flag_type, encoding, flag_aliases);
-			if (ss.fail())
+		auto split = split_dic_line(line);
+		word.assign(first, split.first);
+		if (split.second != line.npos) {
+			auto p = first + split.second;
+			if (!decode_flags_possible_alias(p, line_end,
+			                                 line_number, flag_type,
+			                                 encoding, flag_aliases,
+			                                 flags))
 				continue;
 		}
-		else if (line.find('\t') != line.npos) {
-			// Tab found, word until tab. No flags.
-			// After tab follow morphological fields
-			getline(ss, word, '\t');
+		if (word.empty()) {
+			continue;
+		}
+		// parse_morhological_fields(ss, morphs);
+		f(word, flags, is_casing(word));
+	}
+}
+
+/**
+ * @brief Adds the ph: fields of the lines of a .dic file to @p out.
+ *
+ * A ph: field gives a pronunciation or a common misspelling of the word,
+ * e.g. "xxxxxxxxxx ph:Brasilia", used by the n-gram suggestions. The fields
+ * are rare, so the text is searched for them instead of parsing each line.
+ * The result is sorted.
+ */
+auto parse_pronunciations(const char* first, const char* last,
+                          vector<pair<string, string>>& out) -> void
+{
+	auto text = my_string_view<char>(first, last - first);
+	for (auto i = text.find("ph:"); i != text.npos;
+	     i = text.find("ph:", i + 3)) {
+		if (i == 0 || (text[i - 1] != ' ' && text[i - 1] != '\t'))
+			continue;
+		auto line_first = text.rfind('\n', i);
+		line_first = line_first == text.npos ? 0 : line_first + 1;
+		auto line = text.substr(line_first);
+		line = line.substr(0, line.find('\n'));
+		auto word_size = split_dic_line(line).first;
+		if (word_size == 0 || line_first + word_size > i)
+			continue;
+		auto value = line.substr(i + 3 - line_first);
+		value = value.substr(0, value.find_first_of(" \t\r"));
+		if (value.empty())
+			continue;
+		out.emplace_back(string(line.data(), word_size),
+		                 string(value.data(), value.size()));
+	}
+	sort(begin(out), end(out));
+}
+
+/**
+ * @brief Adds the hidden homonym in upper case of a Pascal or camel case word.
+ *
+ * Nothing is added if there is already a hidden homonym.
+ */
+auto add_hidden_homonym(Dic_Data_Base& words, string& upper, u16string& flags)
+    -> void
+{
+	auto hom = words.equal_range(upper);
+	auto h = find_if(hom.first, hom.second, [&](auto& w) {
+		return w.second.contains(HIDDEN_HOMONYM_FLAG);
+	});
+	if (h == hom.second) { // if not found
+		flags += HIDDEN_HOMONYM_FLAG;
+		words.emplace(move(upper), move(flags));
+	}
+}
+
+/**
+ * @brief Adds a word of the .dic file to the word list.
+ *
+ * All-caps words replace the hidden homonym added for a previous word, if
+ * there is one. Pascal and camel case words add a hidden homonym in upper
+ * case. The result depends on the order of the calls, thus the words must
+ * be added in the order of the file.
+ *
+ * @param upper the word in upper case, only used for PASCAL and CAMEL.
+ */
+auto add_dic_word(Dic_Data_Base& words, string& word, u16string& flags,
+                  Casing casing, string& upper) -> void
+{
+	switch (casing) {
+	case Casing::ALL_CAPITAL: {
+		// check for hidden homonym
+		auto hom = words.equal_range(word);
+		auto h = find_if(hom.first, hom.second, [&](auto& w) {
+			return w.second.contains(HIDDEN_HOMONYM_FLAG);
+		});
+
+		if (h != hom.second) {
+			// replace if found
+			h->second = move(flags);
 		}
 		else {
-			auto end = dic_find_end_of_word_heuristics(line);
-			word.assign(line, 0, end);
-			ss.ignore(end);
+			words.emplace(move(word), move(flags));
 		}
-		if (word.empty()) {
+	} break;
+	case Casing::PASCAL:
+	case Casing::CAMEL:
+		words.emplace(move(word), flags);
+		// add the hidden homonym directly in uppercase
+		add_hidden_homonym(words, upper, flags);
+		break;
+	default:
+		words.emplace(move(word), move(flags));
+		break;
+	}
+}
+
+/**
+ * @brief Gets the heap memory owned by an object, without the object itself.
+ */
+template <class T>
+auto heap_size(const T&) -> enable_if_t<is_trivially_copyable<T>::value, size_t>
+{
+	return 0;
+}
+
+template <class CharT>
+auto heap_size(const basic_string<CharT>& s) -> size_t
+{
+	// short strings are stored inside the object
+	if (s.capacity() <= basic_string<CharT>().capacity())
+		return 0;
+	return (s.capacity() + 1) * sizeof(CharT);
+}
+
+template <class CharT>
+auto heap_size(const String_Set<CharT>& s) -> size_t
+{
+	return heap_size(s.data());
+}
+
+auto heap_size(const Compound_Check_Pattern& p) -> size_t
+{
+	return heap_size(p.first_word_end) + heap_size(p.second_word_begin) +
+	       heap_size(p.replacement);
+}
+
+template <class T, class U>
+auto heap_size(const pair<T, U>& p) -> size_t
+{
+	return heap_size(p.first) + heap_size(p.second);
+}
+
+template <class T>
+auto heap_size(const vector<T>& v) -> size_t
+{
+	auto ret = v.capacity() * sizeof(T);
+	for (auto& x : v)
+		ret += heap_size(x);
+	return ret;
+}
+
+/**
+ * @brief Adds the heap memory of a word table to the memory usage.
+ */
+auto add_memory_usage(const Dic_Data_Base& words, Memory_Usage& m) -> void
+{
+	// node: next pointer, key, value and the cached hash
+	const size_t node_size = sizeof(void*) +
+	                         sizeof(Dic_Data_Base::value_type) +
+	                         sizeof(size_t);
+	m.word_buckets += words.bucket_count() * sizeof(void*);
+	m.word_nodes += words.size() * node_size;
+	for (auto& w : words) {
+		m.word_strings += heap_size(w.first);
+		m.word_flag_sets += heap_size(w.second);
+	}
+	m.flag_sets += words.size();
+}
+
+/**
+ * @brief Estimates the heap memory used by a word table.
+ */
+auto estimate_memory(const Dic_Data_Base& words) -> size_t
+{
+	auto m = Memory_Usage();
+	add_memory_usage(words, m);
+	return m.total();
+}
+
+auto count_hidden_homonyms(const Dic_Data_Base& words) -> size_t
+{
+	return count_if(begin(words), end(words), [](auto& w) {
+		return w.second.contains(HIDDEN_HOMONYM_FLAG);
+	});
+}
+
+/**
+ * @brief Reads the rest of a stream into a string.
+ *
+ * The stream buffer is read directly, thus an exception from it, e.g. on
+ * corrupted .hz data, is not turned into badbit. It is caught here.
+ *
+ * @return false if the stream went bad or its buffer threw.
+ */
+auto read_dic_text(istream& in, string& out) -> bool
+{
+	try {
+		out.assign(istreambuf_iterator<char>(in), {});
+	}
+	catch (const ios_base::failure&) {
+		return false;
+	}
+	return !in.bad();
+}
+
+/**
+ * @brief State of a lazily loaded .dic file.
+ *
+ * The file is kept in memory while there are regions to parse. Each region
+ * lists the lines, by offset in the file, whose word or hidden homonym
+ * hashes into the region. The lower two bits of an offset tell which of the
+ * two belong to the region, so a region can be parsed independently of the
+ * others, in the order of the file. The line number is kept next to the
+ * offset for the warnings of the parser.
+ */
+struct Lazy_Dic {
+	enum : uint32_t { HAS_WORD = 1, HAS_HIDDEN_HOMONYM = 2, TAG_BITS = 2 };
+	struct Line {
+		uint32_t offset;
+		uint32_t number;
+	};
+	struct Region {
+		vector<Line> lines;
+		once_flag once;
+		Dic_Data_Base words;
+	};
+
+	string buf;
+	unique_ptr<Region[]> regions;
+	size_t region_count;
+	size_t word_lines = 0;
+	Flag_Type flag_type;
+	Encoding encoding;
+	vector<Flag_Set> flag_aliases;
+	locale loc;
+	Byte_Casing_Classifier is_casing;
+
+	Lazy_Dic_Stats stats;
+	mutex stats_mutex;
+
+	Lazy_Dic(const locale& loc) : loc(loc), is_casing(loc) {}
+
+	// offsets must fit in 32 bits, together with the tag bits
+	auto static can_index(size_t file_size)
+	{
+		return file_size < (size_t(1) << (32 - TAG_BITS));
+	}
+	auto region_of(my_string_view<char> word) const
+	{
+		return Dic_Data::hash_word(word) & (region_count - 1);
+	}
+	auto materialize(size_t i) -> const Dic_Data_Base&;
+};
+
+/**
+ * @brief Parses the lines of a region, once.
+ *
+ * Thread-safe. The words of the region are not modified afterwards.
+ */
+auto Lazy_Dic::materialize(size_t i) -> const Dic_Data_Base&
+{
+	auto& r = regions[i];
+	call_once(r.once, [&]() {
+		auto t1 = chrono::steady_clock::now();
+		r.words.reserve(r.lines.size());
+		auto upper = string();
+		for (auto& line : r.lines) {
+			auto x = line.offset;
+			auto first = buf.data() + (x >> TAG_BITS);
+			auto last = buf.data() + buf.size();
+			last = find(first, last, '\n');
+			parse_dic_lines(
+			    first, last, line.number - 1, flag_type, encoding,
+			    flag_aliases, is_casing,
+			    [&](auto& word, auto& flags, auto casing) {
+				    if (casing != Casing::PASCAL &&
+				        casing != Casing::CAMEL) {
+					    add_dic_word(r.words, word, flags,
+					                 casing, upper);
+					    return;
+				    }
+				    if (x & HAS_WORD)
+					    r.words.emplace(word, flags);
+				    if (x & HAS_HIDDEN_HOMONYM) {
+					    upper = to_upper(word, loc);
+					    add_hidden_homonym(r.words, upper,
+					                       flags);
+				    }
+			    });
+		}
+		auto t2 = chrono::steady_clock::now();
+		auto bytes = estimate_memory(r.words);
+		lock_guard<mutex> lock(stats_mutex);
+		stats.regions_materialized++;
+		stats.words_materialized += r.words.size();
+		stats.materialized_bytes += bytes;
+		stats.materialize_seconds +=
+		    chrono::duration<double>(t2 - t1).count();
+	});
+	return r.words;
+}
+
+/**
+ * Parses an input stream offering dictionary information.
+ *
+ * The whole stream is read into memory at once and the lines are scanned
+ * directly in the buffer.
+ *
+ * With more than one thread, the words are split in regions by hash as in
+ * parse_dic_lazy() and all regions are parsed at load, see
+ * parse_dic_regions(). Only reading the stream and checking the encoding
+ * stay sequential, on synthetic dictionaries of 1 and 4 million words that
+ * is about 12% of the one-thread time. One thread is used if there are
+ * words already or if the file is too large for the index of regions.
+ *
+ * Adds its timings and counts to the Load_Stats of the thread, if enabled.
+ *
+ * @param in input stream to read from.
+ * @param thread_count number of threads to use, 0 means one per hardware
+ * thread.
+ * @return true on success.
+ */
+auto Aff_Data::parse_dic(istream& in, size_t thread_count) -> bool
+{
+	auto stats = get_load_stats();
+	Load_Timer timer(stats ? &stats->dic_seconds : nullptr);
+	auto buf = string();
+	{
+		Load_Timer read_timer(stats ? &stats->dic_read_seconds
+		                            : nullptr);
+		if (!read_dic_text(in, buf))
+			return false;
+	}
+
+	if (thread_count == 0)
+		thread_count = max(1u, thread::hardware_concurrency());
+	// below this, starting threads costs more than it gains
+	const size_t min_chunk_size = 64 * 1024;
+	thread_count = min(thread_count, buf.size() / min_chunk_size);
+	if (thread_count > 1 && words.empty() &&
+	    Lazy_Dic::can_index(buf.size()))
+		return parse_dic_regions(buf, SIZE_MAX, thread_count);
+
+	auto first = buf.data();
+	auto last = first + buf.size();
+	if (buf.compare(0, 3, "\xEF\xBB\xBF") == 0)
+		first += 3;
+	if (first == last)
+		return false;
+
+	auto encoding =
+	    Encoding(use_facet<boost::locale::info>(locale_aff).encoding());
+	if (encoding.is_utf8() && !validate_utf8(first, last)) {
+		cerr << "Invalid utf in dic file" << endl;
+	}
+
+	auto line_end = find(first, last, '\n');
+	size_t approximate_size;
+	if (!parse_unsigned(first, line_end, SIZE_MAX, approximate_size))
+		return false;
+	first = line_end == last ? last : line_end + 1;
+
+	// the counting is done only if the statistics are enabled
+	auto& owned = words.owned_words();
+	auto old_size = owned.size();
+	auto old_hidden = stats ? count_hidden_homonyms(owned) : 0;
+
+	// The count in the first line is often wrong, the number of lines is
+	// exact and cheap to get.
+	auto line_count = size_t(count(first, last, '\n'));
+	owned.reserve(max(approximate_size, line_count));
+	auto is_casing = Byte_Casing_Classifier(locale_aff);
+	auto upper = string();
+	parse_pronunciations(first, last, pronunciations);
+	parse_dic_lines(first, last, 1, flag_type, encoding, flag_aliases,
+	                is_casing, [&](auto& word, auto& flags, auto casing) {
+		                if (casing == Casing::PASCAL ||
+		                    casing == Casing::CAMEL)
+			                upper = to_upper(word, locale_aff);
+		                add_dic_word(owned, word, flags, casing, upper);
+	                });
+
+	timer.stop();
+	if (!stats)
+		return true;
+	if (first != last && last[-1] != '\n')
+		++line_count;
+	stats->dic_lines += line_count;
+	stats->words_inserted += owned.size() - old_size;
+	stats->hidden_homonyms += count_hidden_homonyms(owned) - old_hidden;
+	stats->dic_bytes = estimate_memory(owned);
+	stats->word_count = owned.size();
+	stats->word_buckets = owned.bucket_count();
+	return true;
+}
+
+/**
+ * @brief Locates the words of the lines of a .dic file, for Lazy_Dic.
+ *
+ * Calls add(region, line) for the region of the word and for the region of
+ * the hidden homonym of a Pascal or camel case word, once if they are the
+ * same.
+ *
+ * @param first the first line, in Lazy_Dic::buf.
+ * @param line_number the number of the line before the first one.
+ * @return the number of lines with a word.
+ */
+template <class Func>
+auto index_dic_lines(const Lazy_Dic& d, const char* first, const char* last,
+                     uint32_t line_number, Func add) -> size_t
+{
+	size_t ret = 0;
+	auto upper = string();
+	for (const char* next; first != last; first = next) {
+		auto line_end = find(first, last, '\n');
+		next = line_end == last ? last : line_end + 1;
+		line_number++;
+		auto line = my_string_view<char>(first, line_end - first);
+		auto word = line.substr(0, split_dic_line(line).first);
+		if (word.empty())
+			continue;
+		++ret;
+		auto x = uint32_t(first - d.buf.data()) << Lazy_Dic::TAG_BITS;
+		auto r1 = d.region_of(word);
+		auto casing = d.is_casing(word);
+		if (casing != Casing::PASCAL && casing != Casing::CAMEL) {
+			add(r1, {x | Lazy_Dic::HAS_WORD, line_number});
 			continue;
 		}
-		// parse_morhological_fields(ss, morphs);
+		upper.assign(word.data(), word.size());
+		upper = to_upper(upper, d.loc);
+		auto r2 = d.region_of(upper);
+		if (r1 == r2) {
+			x |= Lazy_Dic::HAS_WORD | Lazy_Dic::HAS_HIDDEN_HOMONYM;
+			add(r1, {x, line_number});
+			continue;
+		}
+		add(r1, {x | Lazy_Dic::HAS_WORD, line_number});
+		add(r2, {x | Lazy_Dic::HAS_HIDDEN_HOMONYM, line_number});
+	}
+	return ret;
+}
 
-		auto casing = classify_casing(word, locale_aff);
-		const char16_t HIDDEN_HOMONYM_FLAG = -1;
-		switch (casing) {
-		case Casing::ALL_CAPITAL: {
-			// check for hidden homonym
-			auto hom = words.equal_range(word);
-			auto h = find_if(hom.first, hom.second, [&](auto& w) {
-				return w.second.contains(HIDDEN_HOMONYM_FLAG);
-			});
-
-			if (h != hom.second) {
-				// replace if found
-				h->second = flags;
-			}
-			else {
-				words.emplace(word, flags);
-			}
-		} break;
-		case Casing::PASCAL:
-		case Casing::CAMEL: {
-			words.emplace(word, flags);
-
-			// add the hidden homonym directly in uppercase
-			auto up = boost::locale::to_upper(word, locale_aff);
-			auto hom = words.equal_range(up);
-			auto h = find_if(hom.first, hom.second, [&](auto& w) {
-				return w.second.contains(HIDDEN_HOMONYM_FLAG);
-			});
-			if (h == hom.second) { // if not found
-				flags += HIDDEN_HOMONYM_FLAG;
-				words.emplace(up, flags);
+/**
+ * Indexes the text of a .dic file in regions and parses them at load.
+ *
+ * The words are split in regions by their hash. A region holds the lines
+ * whose word or hidden homonym hashes into it and is parsed from them in
+ * the order of the file, so the lookups give the same as after parsing the
+ * whole file in order, see Lazy_Dic. The word list is then read-only.
+ *
+ * With one thread, regions are parsed in order as long as the estimated
+ * memory of the parsed regions stays under preload_bytes, the others on the
+ * first lookup into them.
+ *
+ * With more than one thread, all regions are parsed at load. The threads
+ * first index chunks of whole lines, then each takes whole regions, so it
+ * owns the words of its regions and there is no merge. The text and the
+ * index are freed at the end.
+ *
+ * Adds its counts, not the time, to the Load_Stats of the thread.
+ *
+ * @param text the text of the file, it is moved from.
+ * @param preload_bytes estimated bytes of words to parse at load with one
+ * thread.
+ * @param thread_count number of threads that index and parse.
+ * @return true on success.
+ */
+auto Aff_Data::parse_dic_regions(string& text, size_t preload_bytes,
+                                 size_t thread_count) -> bool
+{
+	auto t1 = chrono::steady_clock::now();
+	auto d = make_shared<Lazy_Dic>(locale_aff);
+	auto& buf = d->buf;
+	buf = move(text);
+	auto first = buf.data();
+	auto last = first + buf.size();
+	if (buf.compare(0, 3, "\xEF\xBB\xBF") == 0)
+		first += 3;
+	if (first == last)
+		return false;
+
+	d->encoding =
+	    Encoding(use_facet<boost::locale::info>(locale_aff).encoding());
+	if (d->encoding.is_utf8() && !validate_utf8(first, last)) {
+		cerr << "Invalid utf in dic file" << endl;
+	}
+	auto line_end = find(first, last, '\n');
+	size_t approximate_size;
+	if (!parse_unsigned(first, line_end, SIZE_MAX, approximate_size))
+		return false;
+	first = line_end == last ? last : line_end + 1;
+	parse_pronunciations(first, last, pronunciations);
+
+	// about 256 lines per region
+	auto line_count = size_t(count(first, last, '\n'));
+	if (first != last && last[-1] != '\n')
+		++line_count;
+	d->region_count = 1;
+	while (d->region_count * 256 < line_count)
+		d->region_count *= 2;
+	d->regions.reset(new Lazy_Dic::Region[d->region_count]);
+	d->flag_type = flag_type;
+	d->flag_aliases = flag_aliases;
+	auto& stats = d->stats;
+	stats.regions = d->region_count;
+	stats.lines_indexed = line_count;
+
+	if (thread_count > 1) {
+		auto in_parallel = [&](size_t n, auto f) {
+			atomic<size_t> next(0);
+			auto work = [&]() {
+				for (size_t i; (i = next++) < n;)
+					f(i);
+			};
+			auto others = vector<future<void>>();
+			for (size_t i = 1; i != thread_count; ++i)
+				others.push_back(async(launch::async, work));
+			work();
+			for (auto& x : others)
+				x.get();
+		};
+		struct Chunk {
+			const char* first;
+			const char* last;
+			uint32_t line_number;
+			size_t word_lines;
+			vector<vector<Lazy_Dic::Line>> region_lines;
+		};
+		auto chunks = vector<Chunk>(thread_count);
+		uint32_t line_number = 1;
+		for (size_t i = 0; i != thread_count; ++i) {
+			auto& c = chunks[i];
+			auto chunk_last =
+			    first + (last - first) / (thread_count - i);
+			chunk_last = find(chunk_last, last, '\n');
+			if (chunk_last != last)
+				++chunk_last;
+			c.first = first;
+			c.last = chunk_last;
+			c.line_number = line_number;
+			line_number += uint32_t(count(first, chunk_last, '\n'));
+			first = chunk_last;
+		}
+		in_parallel(thread_count, [&](size_t i) {
+			auto& c = chunks[i];
+			c.region_lines.resize(d->region_count);
+			c.word_lines = index_dic_lines(
+			    *d, c.first, c.last, c.line_number,
+			    [&](size_t r, Lazy_Dic::Line line) {
+				    c.region_lines[r].push_back(line);
+			    });
+		});
+		for (auto& c : chunks)
+			d->word_lines += c.word_lines;
+		auto t2 = chrono::steady_clock::now();
+		stats.index_seconds = chrono::duration<double>(t2 - t1).count();
+
+		in_parallel(d->region_count, [&](size_t r) {
+			// the lines of the region, in the order of the file
+			auto& lines = d->regions[r].lines;
+			for (auto& c : chunks) {
+				auto& x = c.region_lines[r];
+				lines.insert(lines.end(), x.begin(), x.end());
+				x = vector<Lazy_Dic::Line>();
 			}
+			d->materialize(r);
+			lines = vector<Lazy_Dic::Line>();
+		});
+		// no region is parsed again
+		buf = string();
+		stats.index_bytes = sizeof(Lazy_Dic) +
+		                    d->region_count * sizeof(Lazy_Dic::Region);
+	}
+	else {
+		d->word_lines = index_dic_lines(
+		    *d, first, last, 1, [&](size_t r, Lazy_Dic::Line line) {
+			    d->regions[r].lines.push_back(line);
+		    });
+		stats.index_bytes = buf.capacity() + sizeof(Lazy_Dic) +
+		                    d->region_count * sizeof(Lazy_Dic::Region);
+		for (size_t i = 0; i != d->region_count; ++i)
+			stats.index_bytes += d->regions[i].lines.capacity() *
+			                     sizeof(Lazy_Dic::Line);
+		auto t2 = chrono::steady_clock::now();
+		stats.index_seconds = chrono::duration<double>(t2 - t1).count();
+
+		for (size_t i = 0; i != d->region_count; ++i) {
+			// estimate the region from the average so far, or guess
+			auto average = stats.regions_materialized
+			                   ? stats.materialized_bytes /
+			                         stats.regions_materialized
+			                   : d->regions[i].lines.size() * 64;
+			if (stats.materialized_bytes + average > preload_bytes)
+				break;
+			d->materialize(i);
+		}
+	}
+	if (auto load_stats = get_load_stats()) {
+		load_stats->dic_lines += line_count;
+		load_stats->words_inserted += stats.words_materialized;
+		load_stats->dic_bytes =
+		    stats.index_bytes + stats.materialized_bytes;
+		load_stats->word_count = stats.words_materialized;
+		load_stats->word_buckets = 0;
+	}
+	words.set_lazy(move(d));
+	return true;
+}
 
-		} break;
-		default:
-			words.emplace(word, flags);
-			break;
+/**
+ * Indexes an input stream offering dictionary information, for lazy loading.
+ *
+ * Only the words are located at load time, not parsed. The words are split
+ * in regions by their hash and each region is parsed on the first lookup
+ * into it, after that it stays in memory. The result of all lookups is the
+ * same as after parse_dic().
+ *
+ * Regions are parsed during the load too, in order, as long as the
+ * estimated memory of the parsed regions stays under preload_bytes. Use 0
+ * to parse nothing at load, or a large value to parse everything. This does
+ * not bound the memory afterwards, a parsed region is never dropped.
+ *
+ * Statistics are available with Dic_Data::lazy_stats(). The Load_Stats of
+ * the thread, if enabled, get only the indexing and the regions parsed at
+ * load.
+ *
+ * @param in input stream to read from.
+ * @param preload_bytes estimated bytes of words to parse at load.
+ * @return true on success.
+ */
+auto Aff_Data::parse_dic_lazy(istream& in, size_t preload_bytes) -> bool
+{
+	auto stats = get_load_stats();
+	Load_Timer timer(stats ? &stats->dic_seconds : nullptr);
+	auto buf = string();
+	{
+		Load_Timer read_timer(stats ? &stats->dic_read_seconds
+		                            : nullptr);
+		if (!read_dic_text(in, buf))
+			return false;
+	}
+	if (!Lazy_Dic::can_index(buf.size())) {
+		timer.stop();
+		in.clear();
+		auto ss = istringstream(move(buf));
+		return parse_dic(ss);
+	}
+	return parse_dic_regions(buf, preload_bytes, 1);
+}
+
+/**
+ * @brief Hashes a word of the compiled word table, FNV-1a.
+ */
+auto Dic_Data::hash_word(my_string_view<char> word) -> std::uint32_t
+{
+	std::uint32_t h = 2166136261u;
+	for (auto c : word) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * @brief Switches to a compiled word table.
+ *
+ * The owned words are dropped. The table must point into storage, which is
+ * kept alive as long as the table is used.
+ *
+ * @param storage owner of the memory of the table, e.g. a file mapping.
+ * @param table the word table.
+ * @param flag_sets the distinct flag sets, indexed by the table entries.
+ */
+auto Dic_Data::set_compiled(std::shared_ptr<const char> storage,
+                            const Compiled_Table& table,
+                            std::vector<Flag_Set> flag_sets) -> void
+{
+	owned = Dic_Data_Base();
+	this->storage = move(storage);
+	this->table = table;
+	this->flag_sets = move(flag_sets);
+}
+
+/**
+ * @brief Switches to a lazily loaded word list.
+ *
+ * The owned words are dropped.
+ */
+auto Dic_Data::set_lazy(std::shared_ptr<Lazy_Dic> lazy) -> void
+{
+	owned = Dic_Data_Base();
+	this->lazy = move(lazy);
+}
+
+/**
+ * @brief Gets the load statistics of the lazy mode.
+ *
+ * @return the statistics, all zero if the word list is not lazy.
+ */
+auto Dic_Data::lazy_stats() const -> Lazy_Dic_Stats
+{
+	if (!lazy)
+		return {};
+	lock_guard<mutex> lock(lazy->stats_mutex);
+	return lazy->stats;
+}
+
+/**
+ * @brief Estimates the memory of the word list.
+ *
+ * The flag sets are counted only if the list is owned or compiled. In the
+ * lazy mode, the parsed regions are not split by component.
+ *
+ * @return the memory usage, only the fields of the word list are set.
+ */
+auto Dic_Data::memory_usage() const -> Memory_Usage
+{
+	auto m = Memory_Usage();
+	if (is_compiled()) {
+		m.word_buckets = (table.bucket_count + size_t(1)) *
+		                 sizeof(*table.bucket_begin);
+		m.word_nodes = table.entry_count * sizeof(Compiled_Entry);
+		for (auto e = table.entries;
+		     e != table.entries + table.entry_count; ++e)
+			m.word_strings += e->word_size;
+		m.word_flag_sets = heap_size(flag_sets);
+		m.flag_sets = table.entry_count;
+		m.distinct_flag_sets = flag_sets.size();
+		return m;
+	}
+	if (is_lazy()) {
+		auto stats = lazy_stats();
+		m.word_index = stats.index_bytes + heap_size(lazy->flag_aliases);
+		m.word_nodes = stats.materialized_bytes;
+		m.flag_sets = stats.words_materialized;
+		return m;
+	}
+	add_memory_usage(owned, m);
+	auto distinct = unordered_set<u16string>();
+	for (auto& w : owned)
+		distinct.insert(w.second.data());
+	m.distinct_flag_sets = distinct.size();
+	return m;
+}
+
+auto Dic_Data::lazy_size() const -> size_t
+{
+	size_t ret = 0;
+	for (size_t i = 0; i != lazy->region_count; ++i)
+		ret += lazy->materialize(i).size();
+	return ret;
+}
+
+/**
+ * @brief Tests if no line of the lazy .dic file has a word.
+ *
+ * A line with a word counts even if its flags turn out to be invalid when
+ * the region is parsed, then this is false for an empty list.
+ */
+auto Dic_Data::lazy_empty() const -> bool { return lazy->word_lines == 0; }
+
+/**
+ * @brief Throws if the words are not owned, thus can not be modified.
+ *
+ * The lookups of a compiled or lazy word list never see the owned words.
+ */
+auto Dic_Data::check_owned() const -> void
+{
+	if (is_compiled() || is_lazy())
+		throw logic_error("The words of a compiled or lazily loaded "
+		                  "dictionary can not be modified.");
+}
+
+/**
+ * @brief Moves a lazy iterator past empty regions.
+ *
+ * Past the last region, the iterator equals the one from Dic_Data::end().
+ */
+auto skip_empty_regions(Lazy_Dic& d, size_t& region,
+                        Dic_Data_Base::const_iterator& it) -> void
+{
+	while (it == d.regions[region].words.end()) {
+		if (++region == d.region_count) {
+			it = Dic_Data_Base::const_iterator();
+			return;
 		}
+		it = d.materialize(region).begin();
 	}
-	return in.eof(); // success if we reached eof
 }
 
-auto Dic_Data::find(const wstring& word) -> iterator
+auto Dic_Data::lazy_next(size_t& region,
+                         Dic_Data_Base::const_iterator& it) const -> void
 {
-	return find(boost::locale::conv::utf_to_utf<char>(word));
+	++it;
+	skip_empty_regions(*lazy, region, it);
 }
 
-auto Dic_Data::find(const wstring& word) const -> const_iterator
+auto Dic_Data::begin() const -> const_iterator
 {
-	return find(boost::locale::conv::utf_to_utf<char>(word));
+	if (is_lazy()) {
+		size_t region = 0;
+		auto it = lazy->materialize(0).begin();
+		skip_empty_regions(*lazy, region, it);
+		return {it, this, region};
+	}
+	if (is_compiled())
+		return {table.entries, this};
+	return owned.begin();
 }
-auto Dic_Data::equal_range(const std::wstring& word)
-    -> std::pair<iterator, iterator>
+
+auto Dic_Data::end() const -> const_iterator
 {
-	return equal_range(boost::locale::conv::utf_to_utf<char>(word));
+	if (is_lazy())
+		return {Dic_Data_Base::const_iterator(), this,
+		        lazy->region_count};
+	if (is_compiled())
+		return {table.entries + table.entry_count, this};
+	return owned.end();
 }
+
+auto Dic_Data::compiled_equal_range(const std::string& word) const
+    -> std::pair<const_iterator, const_iterator>
+{
+	auto b = hash_word(word) & (table.bucket_count - 1);
+	auto first = table.entries + table.bucket_begin[b];
+	auto last = table.entries + table.bucket_begin[b + 1];
+	auto is_word = [&](const Compiled_Entry& e) {
+		return word.size() == e.word_size &&
+		       word.compare(0, word.npos, table.strings + e.word_offset,
+		                    e.word_size) == 0;
+	};
+	// homonyms are consecutive in the bucket
+	first = find_if(first, last, is_word);
+	last = find_if_not(first, last, is_word);
+	return {{first, this}, {last, this}};
+}
+
+auto Dic_Data::equal_range(const std::string& word) const
+    -> std::pair<const_iterator, const_iterator>
+{
+	if (is_lazy())
+		return lazy->materialize(lazy->region_of(word)).equal_range(word);
+	if (is_compiled())
+		return compiled_equal_range(word);
+	return owned.equal_range(word);
+}
+
 auto Dic_Data::equal_range(const std::wstring& word) const
     -> std::pair<const_iterator, const_iterator>
 {
 	return equal_range(boost::locale::conv::utf_to_utf<char>(word));
 }
 
+template <class CharT>
+auto heap_size(const Break_Table<CharT>& b) -> size_t
+{
+	size_t ret = 0;
+	for (auto r : {b.start_word_breaks(), b.end_word_breaks(),
+	               b.middle_word_breaks()})
+		for (auto& x : r)
+			ret += sizeof(x) + heap_size(x);
+	return ret;
+}
+
+/**
+ * @brief Adds the memory of a table of prefixes or suffixes.
+ *
+ * @param t the table.
+ * @param affixes where to add the memory of the table and of the affixes.
+ * @param conditions where to add the memory of the conditions.
+ */
+template <class Table>
+auto add_affix_memory(const Table& t, size_t& affixes, size_t& conditions)
+    -> void
+{
+	// node: the value and the two links of the hashed index
+	const size_t node_size =
+	    sizeof(typename Table::value_type) + 2 * sizeof(void*);
+	affixes += t.bucket_count() * sizeof(void*) + t.size() * node_size;
+	for (auto& a : t) {
+		affixes += heap_size(a.stripping) + heap_size(a.appending) +
+		           heap_size(a.cont_flags);
+		auto& spans = a.condition.span_data();
+		conditions += heap_size(a.condition.str()) +
+		              spans.capacity() * sizeof(spans[0]);
+	}
+}
+
+/**
+ * @brief Estimates the heap memory of the loaded dictionary by component.
+ *
+ * The sizes of containers are computed from their capacities and the usual
+ * layout of the standard library, so they are close but not exact.
+ *
+ * @return the memory usage.
+ */
+auto Aff_Data::memory_usage() const -> Memory_Usage
+{
+	auto m = words.memory_usage();
+	auto add_structures = [&](auto& s) {
+		add_affix_memory(s.prefixes, m.prefixes, m.conditions);
+		add_affix_memory(s.suffixes, m.suffixes, m.conditions);
+		m.substr_replacers += heap_size(s.input_substr_replacer.data()) +
+		                      heap_size(s.output_substr_replacer.data());
+		m.break_tables += heap_size(s.break_table);
+		m.other += heap_size(s.ignored_chars) + heap_size(s.try_chars) +
+		           heap_size(s.keyboard_table.data()) +
+		           s.replacement_table.memory_usage() +
+		           heap_size(s.map_related_chars);
+	};
+	add_structures(structures);
+	add_structures(wide_structures);
+	m.flag_aliases = heap_size(flag_aliases);
+	m.other += heap_size(keyboard_layout) + heap_size(try_chars) +
+	           heap_size(replacements) + heap_size(map_related_chars) +
+	           heap_size(phonetic_replacements) +
+	           heap_size(pronunciations) + heap_size(compound_rules) +
+	           heap_size(compound_check_patterns) +
+	           heap_size(compound_syllable_vowels) +
+	           heap_size(compound_syllable_num) + heap_size(wordchars);
+	return m;
+}
+
 void Aff_Data::log(const string& affpath)
 {
 	std::ofstream log_file;
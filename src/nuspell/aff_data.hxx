@@ -24,7 +24,10 @@
 #ifndef NUSPELL_AFF_DATA_HXX
 #define NUSPELL_AFF_DATA_HXX
 
+#include <cstdint>
 #include <iosfwd>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -68,6 +71,14 @@ struct Aff_Structures {
 	String_Set<CharT> ignored_chars;
 	Prefix_Table<CharT> prefixes;
 	Suffix_Table<CharT> suffixes;
+
+	// suggestion options, see Aff_Data::set_suggest_structures()
+	using StrT = std::basic_string<CharT>;
+	StrT try_chars;
+	Keyboard_Table<CharT> keyboard_table;
+	Replacement_Table<CharT> replacement_table;
+	std::vector<std::vector<StrT>> map_related_chars;
+	Phonetic_Table<CharT> phonetic_table;
 };
 
 struct Affix {
@@ -95,27 +106,262 @@ struct Compound_Check_Pattern {
 };
 
 using Dic_Data_Base = std::unordered_multimap<std::string, Flag_Set>;
+
+// marks the upper case homonym of a word in Pascal or camel case
+const char16_t HIDDEN_HOMONYM_FLAG = -1;
+struct Lazy_Dic;
+
+/**
+ * @brief Load statistics of a lazily loaded word list.
+ *
+ * The byte counts are estimates.
+ */
+struct Lazy_Dic_Stats {
+	size_t regions = 0;
+	size_t regions_materialized = 0;
+	size_t lines_indexed = 0;
+	size_t words_materialized = 0;
+	size_t index_bytes = 0;
+	size_t materialized_bytes = 0;
+	double index_seconds = 0;
+	double materialize_seconds = 0;
+};
+
+/**
+ * @brief Heap memory of the dictionary data, in bytes, by component.
+ *
+ * The sizes are estimates, the overhead of the allocator is not included.
+ * For a compiled dictionary the word list is in the file mapping or in the
+ * shared buffer. In the lazy mode, word_index has the .dic buffer and the
+ * line index, and word_nodes has the parsed regions as a whole.
+ */
+struct Memory_Usage {
+	// the word list
+	size_t word_buckets = 0;
+	size_t word_nodes = 0;
+	size_t word_strings = 0;
+	size_t word_flag_sets = 0; // Flag_Set payloads
+	size_t word_index = 0;
+
+	// affixing data, of both narrow and wide structures
+	size_t prefixes = 0;
+	size_t suffixes = 0;
+	size_t conditions = 0; // of prefixes and suffixes
+	size_t substr_replacers = 0;
+	size_t break_tables = 0;
+	size_t flag_aliases = 0;
+	size_t other = 0;
+
+	// counts of the flag sets of the words, distinct is 0 if unknown
+	size_t flag_sets = 0;
+	size_t distinct_flag_sets = 0;
+
+	auto total() const -> size_t
+	{
+		return word_buckets + word_nodes + word_strings +
+		       word_flag_sets + word_index + prefixes + suffixes +
+		       conditions + substr_replacers + break_tables +
+		       flag_aliases + other;
+	}
+};
+
 /**
  * @brief Map between words and word_flags.
  *
  * Flags are stored as part of the container. Maybe for the future flags should
  * be stored elsewhere (flag aliases) and this should store pointers.
  *
+ * The words are either owned in a hash multimap, or they are in the word table
+ * of a compiled dictionary, used in place from the file mapping. In the later
+ * case only the distinct flag sets are stored in this object and the
+ * container is read-only.
+ *
+ * In the lazy mode, the .dic file is only indexed at load time. The words
+ * are split in regions by hash and each region is parsed on the first lookup
+ * into it, see Aff_Data::parse_dic_lazy(). This mode is read-only too.
+ *
  * Does not store morphological data as is low priority feature and is out of
  * scope.
  */
-class Dic_Data : public Dic_Data_Base {
+class Dic_Data {
+      public:
+	/**
+	 * @brief Entry of the word table of a compiled dictionary.
+	 */
+	struct Compiled_Entry {
+		std::uint32_t word_offset;
+		std::uint32_t word_size;
+		std::uint32_t flag_set;
+	};
+	/**
+	 * @brief Word table of a compiled dictionary.
+	 *
+	 * The entries of bucket i are [bucket_begin[i], bucket_begin[i+1]),
+	 * where i is hash_word() of the word masked with bucket_count - 1.
+	 */
+	struct Compiled_Table {
+		const char* strings;
+		const std::uint32_t* bucket_begin;
+		std::uint32_t bucket_count;
+		const Compiled_Entry* entries;
+		std::uint32_t entry_count;
+	};
+	struct Word_Ref {
+		my_string_view<char> first;
+		const Flag_Set& second;
+	};
+	using value_type = Word_Ref;
+	using reference = Word_Ref;
+	using const_reference = Word_Ref;
+	class const_iterator;
+	using iterator = const_iterator;
+
+      private:
+	Dic_Data_Base owned;
+	std::shared_ptr<const char> storage;
+	Compiled_Table table = {};
+	std::vector<Flag_Set> flag_sets;
+	std::shared_ptr<Lazy_Dic> lazy;
+
+	auto compiled_equal_range(const std::string& word) const
+	    -> std::pair<const_iterator, const_iterator>;
+	auto lazy_size() const -> size_t;
+	auto lazy_empty() const -> bool;
+	auto check_owned() const -> void;
+	auto lazy_next(size_t& region, Dic_Data_Base::const_iterator& it) const
+	    -> void;
+
       public:
-	using Dic_Data_Base::find;
-	auto find(const std::wstring& word) -> iterator;
-	auto find(const std::wstring& word) const -> const_iterator;
-	using Dic_Data_Base::equal_range;
-	auto equal_range(const std::wstring& word)
-	    -> std::pair<iterator, iterator>;
+	auto static hash_word(my_string_view<char> word) -> std::uint32_t;
+
+	auto is_compiled() const { return table.entries != nullptr; }
+	auto set_compiled(std::shared_ptr<const char> storage,
+	                  const Compiled_Table& table,
+	                  std::vector<Flag_Set> flag_sets) -> void;
+	auto is_lazy() const { return lazy != nullptr; }
+	auto set_lazy(std::shared_ptr<Lazy_Dic> lazy) -> void;
+	auto lazy_stats() const -> Lazy_Dic_Stats;
+	auto memory_usage() const -> Memory_Usage;
+
+	// modifiers, only for the owned words, they throw std::logic_error if
+	// the words are compiled or lazy
+	auto owned_words() -> Dic_Data_Base&
+	{
+		check_owned();
+		return owned;
+	}
+	template <class... Args>
+	auto emplace(Args&&... args)
+	{
+		check_owned();
+		return owned.emplace(std::forward<Args>(args)...);
+	}
+	auto insert(const Dic_Data_Base::value_type& x)
+	{
+		check_owned();
+		return owned.insert(x);
+	}
+	auto reserve(size_t n)
+	{
+		check_owned();
+		owned.reserve(n);
+	}
+
+	/**
+	 * @brief Gets the number of words.
+	 *
+	 * In the lazy mode this parses all regions that are not parsed yet,
+	 * so the whole word list ends up in memory. Use empty() to only test
+	 * for words.
+	 */
+	auto size() const -> size_t
+	{
+		if (is_lazy())
+			return lazy_size();
+		return is_compiled() ? table.entry_count : owned.size();
+	}
+	/**
+	 * @brief Tests if there are no words, without parsing lazy regions.
+	 */
+	auto empty() const -> bool
+	{
+		if (is_lazy())
+			return lazy_empty();
+		return size() == 0;
+	}
+	auto begin() const -> const_iterator;
+	auto end() const -> const_iterator;
+	auto equal_range(const std::string& word) const
+	    -> std::pair<const_iterator, const_iterator>;
 	auto equal_range(const std::wstring& word) const
 	    -> std::pair<const_iterator, const_iterator>;
 };
 
+/**
+ * @brief Iterator of Dic_Data, dereferences to Dic_Data::Word_Ref.
+ *
+ * In the lazy mode, the iterators from begin() walk over all regions and
+ * materialize them as they go.
+ */
+class Dic_Data::const_iterator {
+	Dic_Data_Base::const_iterator it;
+	const Compiled_Entry* e = nullptr;
+	const Dic_Data* d = nullptr;
+	size_t region = 0;
+
+      public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = Word_Ref;
+	using difference_type = std::ptrdiff_t;
+	using pointer = void;
+	using reference = Word_Ref;
+
+	const_iterator() = default;
+	const_iterator(Dic_Data_Base::const_iterator it) : it(it) {}
+	const_iterator(const Compiled_Entry* e, const Dic_Data* d)
+	    : e(e), d(d)
+	{
+	}
+	const_iterator(Dic_Data_Base::const_iterator it, const Dic_Data* d,
+	               size_t region)
+	    : it(it), d(d), region(region)
+	{
+	}
+	auto operator*() const -> Word_Ref
+	{
+		if (e)
+			return {{d->table.strings + e->word_offset,
+			         e->word_size},
+			        d->flag_sets[e->flag_set]};
+		return {it->first, it->second};
+	}
+	auto& operator++()
+	{
+		if (e)
+			++e;
+		else if (d)
+			d->lazy_next(region, it);
+		else
+			++it;
+		return *this;
+	}
+	auto operator++(int)
+	{
+		auto old = *this;
+		++*this;
+		return old;
+	}
+	auto operator==(const const_iterator& other) const
+	{
+		return e == other.e && region == other.region &&
+		       it == other.it;
+	}
+	auto operator!=(const const_iterator& other) const
+	{
+		return !(*this == other);
+	}
+};
+
 struct Aff_Data {
 	// types
 	using string = std::string;
@@ -148,6 +394,8 @@ struct Aff_Data {
 	vector<pair<string, string>> replacements;
 	vector<string> map_related_chars; // vector<vector<string>>?
 	vector<pair<string, string>> phonetic_replacements;
+	// the ph: fields of the .dic file, word and pronunciation, sorted
+	vector<pair<string, string>> pronunciations;
 	char16_t warn_flag;
 	bool forbid_warn;
 
@@ -190,13 +438,24 @@ struct Aff_Data {
 	auto set_encoding_and_language(const string& enc,
 	                               const string& lang = "") -> void;
 	auto parse_aff(istream& in) -> bool;
-	auto parse_dic(istream& in) -> bool;
-	auto parse_aff_dic(std::istream& aff, std::istream& dic)
+	auto parse_dic(istream& in, size_t thread_count = 1) -> bool;
+	auto parse_aff_dic(std::istream& aff, std::istream& dic,
+	                   size_t thread_count = 1)
 	{
 		if (parse_aff(aff))
-			return parse_dic(dic);
+			return parse_dic(dic, thread_count);
 		return false;
 	}
+	auto parse_dic_lazy(istream& in, size_t preload_bytes = 0) -> bool;
+	auto parse_dic_regions(string& text, size_t preload_bytes,
+	                       size_t thread_count) -> bool;
+	auto parse_compiled(istream& in) -> bool;
+	auto parse_compiled(std::shared_ptr<const char> data, size_t size)
+	    -> bool;
+	auto map_compiled(const string& file_path) -> bool;
+	auto write_compiled(std::ostream& out) const -> bool;
+	auto set_suggest_structures() -> void;
+	auto memory_usage() const -> Memory_Usage;
 	void log(const string& affpath);
 	template <class CharT>
 	auto get_structures() const -> const Aff_Structures<CharT>&;
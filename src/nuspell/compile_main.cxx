@@ -0,0 +1,110 @@
+/* Copyright 2016-2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file compile_main.cxx
+ * Command line tool that compiles .aff/.dic pair into binary dictionary.
+ */
+
+#include "dictionary.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+#else
+#ifndef PACKAGE_STRING
+#define PACKAGE_STRING "nuspell 2.0.0"
+#endif
+#endif
+
+using namespace std;
+using namespace nuspell;
+
+auto print_help(const string& program_name) -> void
+{
+	auto& p = program_name;
+	cout << "Usage:\n"
+	        "\n";
+	cout << p << " dict_PATH [output_FILE]\n";
+	cout << p << " -h|--help|-v|--version\n";
+	cout << "\n"
+	        "Compile the dictionary dict_PATH.aff and dict_PATH.dic into "
+	        "binary format\n"
+	        "that loads much faster. Files compressed with hzip, "
+	        "dict_PATH.aff.hz and\n"
+	        "dict_PATH.dic.hz, are read too. The output file defaults to "
+	        "dict_PATH.cdic.\n"
+	        "Load it with nuspell -d output_FILE.\n";
+}
+
+int main(int argc, char* argv[])
+{
+	auto program_name = string("nuspell-compile");
+	if (argc != 0 && argv[0] && argv[0][0] != '\0')
+		program_name = argv[0];
+	auto args = vector<string>(argv + min(argc, 1), argv + argc);
+	if (args.size() == 1 && (args[0] == "-h" || args[0] == "--help")) {
+		print_help(program_name);
+		return 0;
+	}
+	if (args.size() == 1 && (args[0] == "-v" || args[0] == "--version")) {
+		cout << PACKAGE_STRING << '\n';
+		return 0;
+	}
+	if (args.empty() || args.size() > 2) {
+		cerr << "Invalid arguments, try '" << program_name
+		     << " --help' for more information\n";
+		return 1;
+	}
+	auto& in_path = args[0];
+	auto out_path = args.size() == 2 ? args[1] : in_path + ".cdic";
+
+	auto aff_file = open_possibly_hzipped(in_path + ".aff");
+	auto dic_file = open_possibly_hzipped(in_path + ".dic");
+	if (aff_file->fail() || dic_file->fail()) {
+		cerr << "Can not open " << in_path << ".aff or " << in_path
+		     << ".dic\n";
+		return 1;
+	}
+	// Large dictionaries are parsed on all hardware threads.
+	auto dic = Dictionary();
+	if (!dic.parse_aff_dic(*aff_file, *dic_file, 0)) {
+		cerr << "Error parsing " << in_path << '\n';
+		return 1;
+	}
+	ofstream out(out_path, ios_base::binary);
+	if (!out.is_open() || !dic.write_compiled(out)) {
+		cerr << "Can not write " << out_path << '\n';
+		return 1;
+	}
+	out.close();
+
+	// verify that the output loads back
+	ifstream in(out_path, ios_base::binary);
+	auto dic2 = Dictionary();
+	if (!dic2.parse_compiled(in) || dic2.words.size() != dic.words.size()) {
+		cerr << "Verification of " << out_path << " failed\n";
+		return 1;
+	}
+	return 0;
+}
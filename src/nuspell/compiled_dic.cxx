@@ -0,0 +1,755 @@
+/* Copyright 2016-2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file compiled_dic.cxx
+ * Binary precompiled dictionary format.
+ */
+
+#include "aff_data.hxx"
+#include "locale_utils.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+
+#include <boost/crc.hpp>
+#include <boost/locale.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#if defined(_POSIX_VERSION) && defined(_POSIX_MAPPED_FILES)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define NUSPELL_HAVE_MMAP
+#endif
+
+/*
+ * The compiled dictionary is one file with the following layout. All numbers
+ * are in the native byte order of the machine that compiled the file, the
+ * header has a byte order mark so foreign files are rejected.
+ *
+ * File_Header
+ * Section_Header[section_count]
+ * sections, each one aligned to 8 bytes
+ *
+ * The sections are:
+ *
+ * AFF_SECTION - the options of the affix file, the ph: fields of the words
+ * and the affix tables, in a simple length prefixed serialization.
+ *
+ * FLAG_SETS_SECTION - all distinct flag sets of the words, interned.
+ *	uint32_t count
+ *	uint32_t offsets[count + 1]  // into the data
+ *	char16_t data[]
+ *
+ * WORD_STRINGS_SECTION - the words, concatenated, in dictionary encoding.
+ *
+ * WORD_TABLE_SECTION - hash table of the words, with positions relative to
+ * the sections so it can be used directly from a mapping.
+ *	uint32_t bucket_count        // power of two
+ *	uint32_t entry_count
+ *	uint32_t bucket_begin[bucket_count + 1]  // into the entries
+ *	Word_Entry entries[entry_count]
+ *
+ * The bucket of a word is the FNV-1a hash of its bytes modulo bucket_count.
+ * Homonyms are consecutive entries in the same order as in Dic_Data.
+ *
+ * The word table and the word strings are not deserialized, Dic_Data uses
+ * them in place. When the file is mapped with map_compiled(), the pages are
+ * shared between all processes that use the same dictionary.
+ */
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = {'N', 'U', 'S', 'P', 'C', 'D', 'I', 'C'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t FORMAT_VERSION = 2;
+
+enum Section_Id : uint32_t {
+	AFF_SECTION = 1,
+	FLAG_SETS_SECTION,
+	WORD_STRINGS_SECTION,
+	WORD_TABLE_SECTION
+};
+const uint32_t SECTION_COUNT = 4;
+
+struct File_Header {
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t section_count;
+	uint32_t reserved;
+};
+
+struct Section_Header {
+	uint32_t id;
+	uint32_t crc;
+	uint64_t offset;
+	uint64_t size;
+};
+
+using Word_Entry = Dic_Data::Compiled_Entry;
+
+auto crc32(const char* data, size_t size) -> uint32_t
+{
+	boost::crc_32_type crc;
+	crc.process_bytes(data, size);
+	return crc.checksum();
+}
+
+template <class T>
+auto load_pod(const char* p) -> T
+{
+	T x;
+	memcpy(&x, p, sizeof x);
+	return x;
+}
+
+template <class T>
+auto append_pod(string& out, const T& x) -> void
+{
+	out.append(reinterpret_cast<const char*>(&x), sizeof x);
+}
+
+template <class T>
+using enable_if_pod_t =
+    enable_if_t<is_arithmetic<T>::value || is_enum<T>::value>;
+
+class Blob_Writer {
+	string buf;
+
+      public:
+	template <class T>
+	auto operator()(const T& x) -> enable_if_pod_t<T>
+	{
+		append_pod(buf, x);
+	}
+	template <class CharT>
+	auto operator()(const basic_string<CharT>& s) -> void
+	{
+		append_pod(buf, uint32_t(s.size()));
+		buf.append(reinterpret_cast<const char*>(s.data()),
+		           s.size() * sizeof(CharT));
+	}
+	auto operator()(const Flag_Set& s) -> void { (*this)(s.data()); }
+	template <class T, class U>
+	auto operator()(const pair<T, U>& p) -> void
+	{
+		(*this)(p.first);
+		(*this)(p.second);
+	}
+	template <class T>
+	auto operator()(const vector<T>& v) -> void
+	{
+		append_pod(buf, uint32_t(v.size()));
+		for (auto& x : v)
+			(*this)(x);
+	}
+	auto operator()(const Compound_Check_Pattern& p) -> void
+	{
+		(*this)(p.first_word_end);
+		(*this)(p.first_word_flag);
+		(*this)(p.second_word_begin);
+		(*this)(p.second_word_flag);
+		(*this)(p.replacement);
+	}
+	auto& data() const { return buf; }
+};
+
+class Blob_Reader {
+	const char* p;
+	const char* last;
+	bool ok = true;
+
+	auto check_size(size_t n)
+	{
+		if (size_t(last - p) < n)
+			ok = false;
+		return ok;
+	}
+
+      public:
+	Blob_Reader(const char* first, const char* last) : p(first), last(last)
+	{
+	}
+	template <class T>
+	auto operator()(T& x) -> enable_if_pod_t<T>
+	{
+		if (!check_size(sizeof x)) {
+			x = T();
+			return;
+		}
+		memcpy(&x, p, sizeof x);
+		p += sizeof x;
+	}
+	template <class CharT>
+	auto operator()(basic_string<CharT>& s) -> void
+	{
+		uint32_t n = 0;
+		(*this)(n);
+		if (!check_size(size_t(n) * sizeof(CharT)))
+			return;
+		s.resize(n);
+		memcpy(&s[0], p, n * sizeof(CharT));
+		p += n * sizeof(CharT);
+	}
+	auto operator()(Flag_Set& s) -> void
+	{
+		auto x = u16string();
+		(*this)(x);
+		s = move(x);
+	}
+	template <class T, class U>
+	auto operator()(pair<T, U>& p) -> void
+	{
+		(*this)(p.first);
+		(*this)(p.second);
+	}
+	template <class T>
+	auto operator()(vector<T>& v) -> void
+	{
+		uint32_t n = 0;
+		(*this)(n);
+		// each element takes at least one byte
+		if (!check_size(n))
+			return;
+		v.resize(n);
+		for (auto& x : v)
+			(*this)(x);
+	}
+	auto operator()(Compound_Check_Pattern& p) -> void
+	{
+		(*this)(p.first_word_end);
+		(*this)(p.first_word_flag);
+		(*this)(p.second_word_begin);
+		(*this)(p.second_word_flag);
+		(*this)(p.replacement);
+	}
+	explicit operator bool() const { return ok; }
+	auto at_end() const { return p == last; }
+};
+
+template <class Archive, class... T>
+auto process_all(Archive& ar, T&... x) -> void
+{
+	int dummy[] = {0, (ar(x), 0)...};
+	(void)dummy;
+}
+
+/**
+ * @brief Visits all options of the affix file in a fixed order.
+ *
+ * Used for both writing and reading so the two can not go out of sync.
+ * The affix tables are handled separately because they depend on the
+ * encoding.
+ */
+template <class Archive, class AffData>
+auto process_options(Archive& ar, AffData& a) -> void
+{
+	process_all(ar, a.flag_type, a.complex_prefixes, a.flag_aliases);
+
+	process_all(ar, a.keyboard_layout, a.try_chars, a.nosuggest_flag,
+	            a.max_compound_suggestions, a.max_ngram_suggestions,
+	            a.max_diff_factor, a.only_max_diff, a.no_split_suggestions,
+	            a.suggest_with_dots, a.replacements, a.map_related_chars,
+	            a.phonetic_replacements, a.warn_flag, a.forbid_warn);
+
+	// not an option, but small and needed by the suggestions
+	process_all(ar, a.pronunciations);
+
+	process_all(ar, a.compound_rules, a.compound_minimum, a.compound_flag,
+	            a.compound_begin_flag, a.compound_last_flag,
+	            a.compound_middle_flag, a.compound_onlyin_flag,
+	            a.compound_permit_flag, a.compound_forbid_flag,
+	            a.compound_more_suffixes, a.compound_root_flag,
+	            a.compound_word_max, a.compound_check_up,
+	            a.compound_check_rep, a.compound_check_case,
+	            a.compound_check_triple, a.compound_simplified_triple,
+	            a.compound_check_patterns, a.compound_force_uppercase,
+	            a.compound_syllable_max, a.compound_syllable_vowels,
+	            a.compound_syllable_num);
+
+	process_all(ar, a.circumfix_flag, a.forbiddenword_flag, a.fullstrip,
+	            a.keepcase_flag, a.need_affix_flag, a.substandard_flag,
+	            a.wordchars, a.checksharps);
+}
+
+template <class Table>
+auto write_affixes(Blob_Writer& w, const Table& t) -> void
+{
+	w(uint32_t(t.size()));
+	for (auto& a : t) {
+		w(a.flag);
+		w(a.cross_product);
+		w(to_dict_encoding(a.stripping));
+		w(to_dict_encoding(a.appending));
+		w(a.cont_flags);
+		w(to_dict_encoding(a.condition.str()));
+	}
+}
+
+template <class CharT>
+auto write_structures(Blob_Writer& w, const Aff_Structures<CharT>& s) -> void
+{
+	auto write_pairs = [&](auto& table) {
+		w(uint32_t(table.size()));
+		for (auto& x : table) {
+			w(to_dict_encoding(x.first));
+			w(to_dict_encoding(x.second));
+		}
+	};
+	write_pairs(s.input_substr_replacer.data());
+	write_pairs(s.output_substr_replacer.data());
+
+	// Restore the anchors so the table is ordered the same way on load.
+	auto breaks = vector<string>();
+	for (auto& x : s.break_table.start_word_breaks())
+		breaks.push_back('^' + to_dict_encoding(x));
+	for (auto& x : s.break_table.end_word_breaks())
+		breaks.push_back(to_dict_encoding(x) + '$');
+	for (auto& x : s.break_table.middle_word_breaks())
+		breaks.push_back(to_dict_encoding(x));
+	w(breaks);
+
+	w(to_dict_encoding(s.ignored_chars.data()));
+	write_affixes(w, s.prefixes);
+	write_affixes(w, s.suffixes);
+}
+
+template <class CharT, class Table>
+auto read_affixes(Blob_Reader& r, Table& t) -> void
+{
+	uint32_t n = 0;
+	r(n);
+	char16_t flag;
+	bool cross_product;
+	auto stripping = string();
+	auto appending = string();
+	auto cont_flags = Flag_Set();
+	auto condition = string();
+	for (uint32_t i = 0; i != n && r; ++i) {
+		process_all(r, flag, cross_product, stripping, appending,
+		            cont_flags, condition);
+		if (!r)
+			break;
+		t.emplace(flag, cross_product,
+		          from_dict_to_wide_encoding<CharT>(stripping),
+		          from_dict_to_wide_encoding<CharT>(appending),
+		          cont_flags,
+		          from_dict_to_wide_encoding<CharT>(condition));
+	}
+}
+
+template <class CharT>
+auto read_structures(Blob_Reader& r, Aff_Structures<CharT>& s) -> void
+{
+	using StrT = basic_string<CharT>;
+	auto read_pairs = [&]() {
+		auto v = vector<pair<string, string>>();
+		r(v);
+		auto ret = typename Substr_Replacer<CharT>::Table_Pairs();
+		for (auto& x : v)
+			ret.emplace_back(
+			    from_dict_to_wide_encoding<CharT>(x.first),
+			    from_dict_to_wide_encoding<CharT>(x.second));
+		return ret;
+	};
+	auto iconv = read_pairs();
+	s.input_substr_replacer = iconv;
+	auto oconv = read_pairs();
+	s.output_substr_replacer = oconv;
+
+	auto breaks = vector<string>();
+	r(breaks);
+	auto wide_breaks = vector<StrT>();
+	for (auto& x : breaks)
+		wide_breaks.push_back(from_dict_to_wide_encoding<CharT>(x));
+	s.break_table = move(wide_breaks);
+
+	auto ignored = string();
+	r(ignored);
+	s.ignored_chars = StrT(from_dict_to_wide_encoding<CharT>(ignored));
+
+	read_affixes<CharT>(r, s.prefixes);
+	read_affixes<CharT>(r, s.suffixes);
+}
+
+auto align_to_8(string& s) -> void { s.resize((s.size() + 7) / 8 * 8); }
+
+/**
+ * @brief Builds the position-independent word table.
+ */
+auto write_word_table(const Dic_Data& words, string& flag_sets_sec,
+                      string& strings_sec, string& table_sec) -> void
+{
+	auto flag_set_idx = unordered_map<u16string, uint32_t>();
+	auto flag_offsets = vector<uint32_t>{0};
+	auto flag_data = u16string();
+
+	// equal keys are adjacent in Dic_Data, so homonyms share the string
+	auto entries = vector<Word_Entry>();
+	auto hashes = vector<uint32_t>();
+	entries.reserve(words.size());
+	hashes.reserve(words.size());
+	auto prev_word = my_string_view<char>();
+	for (auto&& w : words) {
+		auto e = Word_Entry();
+		if (!entries.empty() && prev_word == w.first) {
+			e.word_offset = entries.back().word_offset;
+			hashes.push_back(hashes.back());
+		}
+		else {
+			e.word_offset = strings_sec.size();
+			strings_sec.append(w.first.data(), w.first.size());
+			hashes.push_back(Dic_Data::hash_word(w.first));
+		}
+		e.word_size = w.first.size();
+		prev_word = w.first;
+
+		auto ins = flag_set_idx.emplace(w.second.data(),
+		                                flag_offsets.size() - 1);
+		if (ins.second) {
+			flag_data += w.second.data();
+			flag_offsets.push_back(flag_data.size());
+		}
+		e.flag_set = ins.first->second;
+		entries.push_back(e);
+	}
+
+	append_pod(flag_sets_sec, uint32_t(flag_offsets.size() - 1));
+	for (auto x : flag_offsets)
+		append_pod(flag_sets_sec, x);
+	flag_sets_sec.append(reinterpret_cast<const char*>(flag_data.data()),
+	                     flag_data.size() * sizeof(char16_t));
+
+	uint32_t bucket_count = 1;
+	while (bucket_count < entries.size())
+		bucket_count *= 2;
+	auto mask = bucket_count - 1;
+
+	// stable counting sort by bucket keeps the order of homonyms
+	auto bucket_begin = vector<uint32_t>(bucket_count + 1);
+	for (auto h : hashes)
+		++bucket_begin[(h & mask) + 1];
+	for (size_t i = 0; i != bucket_count; ++i)
+		bucket_begin[i + 1] += bucket_begin[i];
+	auto pos = vector<uint32_t>(begin(bucket_begin), end(bucket_begin) - 1);
+	auto sorted = vector<Word_Entry>(entries.size());
+	for (size_t i = 0; i != entries.size(); ++i)
+		sorted[pos[hashes[i] & mask]++] = entries[i];
+
+	append_pod(table_sec, bucket_count);
+	append_pod(table_sec, uint32_t(sorted.size()));
+	for (auto x : bucket_begin)
+		append_pod(table_sec, x);
+	for (auto& e : sorted)
+		append_pod(table_sec, e);
+}
+
+auto read_flag_sets(const char* first, size_t size, vector<Flag_Set>& out)
+    -> bool
+{
+	if (size < sizeof(uint32_t))
+		return false;
+	auto count = load_pod<uint32_t>(first);
+	auto offsets = first + sizeof(uint32_t);
+	auto data_size = size - sizeof(uint32_t);
+	if ((data_size / sizeof(uint32_t)) <= count)
+		return false;
+	auto data = offsets + (size_t(count) + 1) * sizeof(uint32_t);
+	auto n_flags = (first + size - data) / sizeof(char16_t);
+	out.resize(count);
+	auto prev = load_pod<uint32_t>(offsets);
+	for (size_t i = 0; i != count; ++i) {
+		auto next = load_pod<uint32_t>(offsets + (i + 1) * 4);
+		if (next < prev || next > n_flags)
+			return false;
+		auto fs = u16string(next - prev, 0);
+		memcpy(&fs[0], data + prev * sizeof(char16_t),
+		       fs.size() * sizeof(char16_t));
+		out[i] = move(fs);
+		prev = next;
+	}
+	return true;
+}
+
+auto read_word_table(const char* table, size_t table_size, size_t strings_size,
+                     size_t flag_set_count, Dic_Data::Compiled_Table& out)
+    -> bool
+{
+	if (table_size < 2 * sizeof(uint32_t))
+		return false;
+	auto bucket_count = load_pod<uint32_t>(table);
+	auto entry_count = load_pod<uint32_t>(table + 4);
+	auto buckets = table + 8;
+	auto entries =
+	    buckets + (size_t(bucket_count) + 1) * sizeof(uint32_t);
+	if (bucket_count == 0 || (bucket_count & (bucket_count - 1)) != 0 ||
+	    (table_size - 8) / sizeof(uint32_t) <= bucket_count ||
+	    size_t(table + table_size - entries) !=
+	        size_t(entry_count) * sizeof(Word_Entry))
+		return false;
+
+	// The table is used in place, validate it once here so lookups
+	// need no checks.
+	auto prev = uint32_t(0);
+	for (size_t i = 0; i != bucket_count + 1; ++i) {
+		auto b = load_pod<uint32_t>(buckets + i * sizeof(uint32_t));
+		if (b < prev || b > entry_count)
+			return false;
+		prev = b;
+	}
+	if (prev != entry_count || load_pod<uint32_t>(buckets) != 0)
+		return false;
+	for (size_t i = 0; i != entry_count; ++i) {
+		auto e = load_pod<Word_Entry>(entries + i * sizeof(Word_Entry));
+		if (e.word_offset > strings_size ||
+		    e.word_size > strings_size - e.word_offset ||
+		    e.flag_set >= flag_set_count)
+			return false;
+	}
+	out.bucket_begin = reinterpret_cast<const uint32_t*>(buckets);
+	out.bucket_count = bucket_count;
+	out.entries = reinterpret_cast<const Word_Entry*>(entries);
+	out.entry_count = entry_count;
+	return true;
+}
+
+auto read_file(const string& path, shared_ptr<const char>& data, size_t& size)
+    -> bool
+{
+	ifstream in(path, ios_base::binary);
+	if (!in.is_open())
+		return false;
+	auto buf = string(istreambuf_iterator<char>(in), {});
+	if (in.bad())
+		return false;
+	auto p = shared_ptr<char>(new char[buf.size() + 1],
+	                          default_delete<char[]>());
+	copy(begin(buf), end(buf), p.get());
+	data = move(p);
+	size = buf.size();
+	return true;
+}
+
+#ifdef NUSPELL_HAVE_MMAP
+auto map_file(const string& path, shared_ptr<const char>& data, size_t& size)
+    -> bool
+{
+	auto fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	size = st.st_size;
+	auto p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // the mapping stays valid
+	if (p == MAP_FAILED)
+		return false;
+	data = shared_ptr<const char>(static_cast<const char*>(p),
+	                              [size](const char* x) {
+		                              munmap(const_cast<char*>(x),
+		                                     size);
+	                              });
+	return true;
+}
+#endif
+} // namespace
+
+/**
+ * @brief Writes the data in the binary precompiled dictionary format.
+ *
+ * The file can be loaded with parse_compiled(), which is much faster than
+ * parsing the affix and dictionary files.
+ *
+ * @param out output stream, should be opened in binary mode.
+ * @return true on success.
+ */
+auto Aff_Data::write_compiled(std::ostream& out) const -> bool
+{
+	auto& info = use_facet<boost::locale::info>(locale_aff);
+	auto w = Blob_Writer();
+	w(info.name());
+	process_options(w, *this);
+	if (info.utf8())
+		write_structures(w, wide_structures);
+	else
+		write_structures(w, structures);
+
+	string sections[SECTION_COUNT];
+	sections[0] = w.data();
+	write_word_table(words, sections[1], sections[2], sections[3]);
+
+	auto header = File_Header();
+	copy(begin(MAGIC), end(MAGIC), header.magic);
+	header.byte_order = BYTE_ORDER_MARK;
+	header.version = FORMAT_VERSION;
+	header.section_count = SECTION_COUNT;
+	header.reserved = 0;
+
+	auto head = string();
+	append_pod(head, header);
+	uint64_t offset =
+	    sizeof(File_Header) + SECTION_COUNT * sizeof(Section_Header);
+	for (uint32_t i = 0; i != SECTION_COUNT; ++i) {
+		auto& s = sections[i];
+		auto sh = Section_Header();
+		sh.id = AFF_SECTION + i;
+		sh.crc = crc32(s.data(), s.size());
+		sh.offset = offset;
+		sh.size = s.size();
+		append_pod(head, sh);
+		align_to_8(s);
+		offset += s.size();
+	}
+	out.write(head.data(), head.size());
+	for (auto& s : sections)
+		out.write(s.data(), s.size());
+	return bool(out);
+}
+
+/**
+ * @brief Loads data in the binary precompiled dictionary format.
+ *
+ * The checksums of all sections are validated. The whole stream is read
+ * into memory which is owned by the word list.
+ *
+ * @param in input stream, should be opened in binary mode.
+ * @return true on success.
+ */
+auto Aff_Data::parse_compiled(std::istream& in) -> bool
+{
+	auto buf = string(istreambuf_iterator<char>(in), {});
+	auto p = shared_ptr<char>(new char[buf.size() + 1],
+	                          default_delete<char[]>());
+	copy(begin(buf), end(buf), p.get());
+	return parse_compiled(move(p), buf.size());
+}
+
+/**
+ * @brief Loads a file in the binary precompiled dictionary format.
+ *
+ * On POSIX systems the file is mapped read-only and the words are used
+ * directly from the mapping, so the load does not depend on the number of
+ * words and the memory is shared between processes. Otherwise, the file is
+ * read into memory.
+ *
+ * @param file_path path to the compiled dictionary.
+ * @return true on success.
+ */
+auto Aff_Data::map_compiled(const std::string& file_path) -> bool
+{
+	auto data = shared_ptr<const char>();
+	auto size = size_t();
+#ifdef NUSPELL_HAVE_MMAP
+	if (!map_file(file_path, data, size) &&
+	    !read_file(file_path, data, size))
+		return false;
+#else
+	if (!read_file(file_path, data, size))
+		return false;
+#endif
+	return parse_compiled(move(data), size);
+}
+
+/**
+ * @brief Loads the binary precompiled dictionary format from memory.
+ *
+ * @param data the file contents, aligned at least to 8 bytes. The word
+ * list keeps it alive.
+ * @param file_size size of the contents.
+ * @return true on success.
+ */
+auto Aff_Data::parse_compiled(std::shared_ptr<const char> data,
+                              size_t file_size) -> bool
+{
+	auto file = data.get();
+	if (file_size < sizeof(File_Header))
+		return false;
+	auto header = load_pod<File_Header>(file);
+	if (!equal(begin(MAGIC), end(MAGIC), header.magic) ||
+	    header.byte_order != BYTE_ORDER_MARK ||
+	    header.version != FORMAT_VERSION ||
+	    header.section_count != SECTION_COUNT ||
+	    file_size < sizeof(File_Header) +
+	                    SECTION_COUNT * sizeof(Section_Header))
+		return false;
+
+	const char* sec[SECTION_COUNT];
+	size_t sec_size[SECTION_COUNT];
+	for (uint32_t i = 0; i != SECTION_COUNT; ++i) {
+		auto sh = load_pod<Section_Header>(
+		    file + sizeof(File_Header) + i * sizeof(Section_Header));
+		if (sh.id != AFF_SECTION + i || sh.offset > file_size ||
+		    sh.size > file_size - sh.offset || sh.offset % 8 != 0)
+			return false;
+		sec[i] = file + sh.offset;
+		sec_size[i] = sh.size;
+		if (crc32(sec[i], sec_size[i]) != sh.crc) {
+			cerr << "Nuspell error: checksum mismatch in compiled "
+			        "dictionary"
+			     << endl;
+			return false;
+		}
+	}
+
+	auto r = Blob_Reader(sec[0], sec[0] + sec_size[0]);
+	auto locale_name = string();
+	r(locale_name);
+	if (!r)
+		return false;
+	boost::locale::generator locale_generator;
+	locale_aff = locale_generator(locale_name);
+	install_ctype_facets_inplace(locale_aff);
+
+	process_options(r, *this);
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		read_structures(r, wide_structures);
+	else
+		read_structures(r, structures);
+	if (!r || !r.at_end())
+		return false;
+	set_suggest_structures();
+
+	auto flag_sets = vector<Flag_Set>();
+	if (!read_flag_sets(sec[1], sec_size[1], flag_sets))
+		return false;
+	auto table = Dic_Data::Compiled_Table();
+	table.strings = sec[2];
+	if (!read_word_table(sec[3], sec_size[3], sec_size[2],
+	                     flag_sets.size(), table))
+		return false;
+	words.set_compiled(move(data), table, move(flag_sets));
+	return true;
+}
+} // namespace nuspell
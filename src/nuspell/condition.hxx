@@ -63,6 +63,8 @@ class Condition {
 	    -> bool;
 	auto match_prefix(const StrT& s) const -> bool;
 	auto match_suffix(const StrT& s) const -> bool;
+	auto& str() const { return cond; }
+	auto& span_data() const { return spans; }
 };
 } // namespace nuspell
 #endif // NUSPELL_CONDITION_HXX
@@ -0,0 +1,322 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file delete_index.cxx
+ * Symmetric delete index of words for suggestions.
+ */
+
+#include "delete_index.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = {'N', 'S', 'P', 'L', 'D', 'I', 'X', '1'};
+
+// FNV-1a
+template <class CharT>
+auto hash_str(const basic_string<CharT>& s) -> uint32_t
+{
+	uint32_t h = 2166136261u;
+	for (auto c : s) {
+		h ^= uint32_t(c);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * @brief Calls f with the hash of the word and of all its deletes.
+ *
+ * A delete at a position before the previous one is skipped as it is made
+ * also in the other order. Equal deletes from repeated characters are not
+ * skipped, the caller removes duplicates.
+ */
+template <class CharT, class Func>
+auto for_each_delete(basic_string<CharT>& w, size_t first, size_t dist,
+                     Func& f) -> void
+{
+	if (dist == 0)
+		return;
+	for (size_t i = first; i < w.size(); ++i) {
+		auto c = w[i];
+		w.erase(i, 1);
+		f(hash_str(w));
+		for_each_delete(w, i, dist - 1, f);
+		w.insert(i, 1, c);
+	}
+}
+
+template <class CharT, class Func>
+auto for_each_delete(basic_string<CharT> w, size_t dist, Func f) -> void
+{
+	f(hash_str(w));
+	for_each_delete(w, 0, dist, f);
+}
+
+template <class T>
+auto write_pod(ostream& out, const T& x) -> void
+{
+	out.write(reinterpret_cast<const char*>(&x), sizeof x);
+}
+
+template <class T>
+auto read_pod(istream& in, T& x) -> void
+{
+	in.read(reinterpret_cast<char*>(&x), sizeof x);
+}
+
+template <class T>
+auto write_array(ostream& out, const T* p, uint64_t n) -> void
+{
+	write_pod(out, n);
+	out.write(reinterpret_cast<const char*>(p), n * sizeof(T));
+}
+
+template <class Container>
+auto read_array(istream& in, Container& c) -> bool
+{
+	uint64_t n = 0;
+	read_pod(in, n);
+	if (!in || n > (uint64_t(1) << 40) / sizeof(c[0]))
+		return false;
+	c.resize(n);
+	if (n != 0)
+		in.read(reinterpret_cast<char*>(&c[0]), n * sizeof(c[0]));
+	return bool(in);
+}
+} // namespace
+
+/**
+ * Computes the optimal string alignment distance of two strings.
+ *
+ * It is the Levenshtein distance where a swap of adjacent characters also
+ * counts as one edit, and no substring is edited twice.
+ */
+template <class CharT>
+auto osa_distance(const basic_string<CharT>& a, const basic_string<CharT>& b)
+    -> size_t
+{
+	auto n = b.size();
+	// three rows of the table, for i - 2, i - 1 and i
+	auto r0 = vector<size_t>(n + 1), r1 = r0, r2 = r0;
+	for (size_t j = 0; j <= n; ++j)
+		r1[j] = j;
+	for (size_t i = 1; i <= a.size(); ++i) {
+		r2[0] = i;
+		for (size_t j = 1; j <= n; ++j) {
+			auto cost = a[i - 1] == b[j - 1] ? 0 : 1;
+			r2[j] = min({r1[j] + 1, r2[j - 1] + 1,
+			             r1[j - 1] + cost});
+			if (i > 1 && j > 1 && a[i - 1] == b[j - 2] &&
+			    a[i - 2] == b[j - 1])
+				r2[j] = min(r2[j], r0[j - 2] + 1);
+		}
+		std::swap(r0, r1);
+		std::swap(r1, r2);
+	}
+	return r1[n];
+}
+template auto osa_distance(const string& a, const string& b) -> size_t;
+template auto osa_distance(const wstring& a, const wstring& b) -> size_t;
+
+template <class CharT>
+auto Delete_Index<CharT>::word(size_t i) const -> StrT
+{
+	return chars.substr(offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+/**
+ * Builds the index.
+ *
+ * The time of building is kept, see build_seconds().
+ *
+ * @param words the words, duplicates are indexed once.
+ * @param max_distance the maximal edit distance of lookups, usually 1 or 2.
+ * The number of deletes of a word grows with the power of it.
+ */
+template <class CharT>
+auto Delete_Index<CharT>::build(const vector<StrT>& words,
+                                size_t max_distance) -> void
+{
+	auto t1 = chrono::steady_clock::now();
+	clear();
+	auto sorted = words;
+	sort(begin(sorted), end(sorted));
+	sorted.erase(unique(begin(sorted), end(sorted)), end(sorted));
+	max_dist = max_distance;
+	offsets.reserve(sorted.size() + 1);
+	for (auto& w : sorted) {
+		offsets.push_back(chars.size());
+		chars += w;
+	}
+	offsets.push_back(chars.size());
+	for (uint32_t i = 0; i != sorted.size(); ++i) {
+		for_each_delete(sorted[i], max_dist, [&](uint32_t h) {
+			entries.emplace_back(h, i);
+		});
+	}
+	sort(begin(entries), end(entries));
+	entries.erase(unique(begin(entries), end(entries)), end(entries));
+	entries.shrink_to_fit();
+	auto t2 = chrono::steady_clock::now();
+	seconds = chrono::duration<double>(t2 - t1).count();
+}
+
+/**
+ * Finds the words within the maximal distance of the index.
+ *
+ * @param word the misspelled word.
+ * @param out the words, nearest first, in alphabetical order at equal
+ * distance. The word itself is not included.
+ */
+template <class CharT>
+auto Delete_Index<CharT>::lookup(const StrT& word, vector<StrT>& out) const
+    -> void
+{
+	lookup(word, max_dist, out);
+}
+
+/**
+ * Finds the words within a distance.
+ *
+ * @param word the misspelled word.
+ * @param max_distance the distance, at most the one the index was built
+ * for.
+ * @param out the words, nearest first, in alphabetical order at equal
+ * distance. The word itself is not included.
+ */
+template <class CharT>
+auto Delete_Index<CharT>::lookup(const StrT& word, size_t max_distance,
+                                 vector<StrT>& out) const -> void
+{
+	out.clear();
+	max_distance = min(max_distance, max_dist);
+	auto ids = vector<uint32_t>();
+	for_each_delete(word, max_distance, [&](uint32_t h) {
+		auto range = equal_range(
+		    begin(entries), end(entries), make_pair(h, uint32_t(0)),
+		    [](auto& a, auto& b) { return a.first < b.first; });
+		for (auto it = range.first; it != range.second; ++it)
+			ids.push_back(it->second);
+	});
+	sort(begin(ids), end(ids));
+	ids.erase(unique(begin(ids), end(ids)), end(ids));
+	// the words are sorted, so are the ids at equal distance
+	auto found = vector<pair<size_t, uint32_t>>();
+	for (auto i : ids) {
+		size_t len = offsets[i + 1] - offsets[i];
+		auto diff = max(len, word.size()) - min(len, word.size());
+		if (diff > max_distance)
+			continue;
+		auto d = osa_distance(word, this->word(i));
+		if (d != 0 && d <= max_distance)
+			found.emplace_back(d, i);
+	}
+	sort(begin(found), end(found));
+	for (auto& f : found)
+		out.push_back(this->word(f.second));
+}
+
+/**
+ * Writes the index in a binary format.
+ *
+ * The format depends on the byte order and the size of the characters of
+ * the platform.
+ *
+ * @param out output stream, should be opened in binary mode.
+ * @return true on success.
+ */
+template <class CharT>
+auto Delete_Index<CharT>::write(ostream& out) const -> bool
+{
+	out.write(MAGIC, sizeof MAGIC);
+	write_pod(out, uint32_t(sizeof(CharT)));
+	write_pod(out, uint32_t(max_dist));
+	write_array(out, chars.data(), chars.size());
+	write_array(out, offsets.data(), offsets.size());
+	write_array(out, entries.data(), entries.size());
+	return bool(out);
+}
+
+/**
+ * Reads an index written with write().
+ *
+ * @param in input stream, should be opened in binary mode.
+ * @return true on success, on failure the index is empty.
+ */
+template <class CharT>
+auto Delete_Index<CharT>::read(istream& in) -> bool
+{
+	clear();
+	char magic[sizeof MAGIC];
+	uint32_t char_size = 0, dist = 0;
+	in.read(magic, sizeof magic);
+	read_pod(in, char_size);
+	read_pod(in, dist);
+	auto ok = in && memcmp(magic, MAGIC, sizeof MAGIC) == 0 &&
+	          char_size == sizeof(CharT) && read_array(in, chars) &&
+	          read_array(in, offsets) && read_array(in, entries);
+	// the words must be within chars and the entries refer to them
+	ok = ok && !offsets.empty() && offsets.front() == 0 &&
+	     offsets.back() == chars.size() &&
+	     is_sorted(begin(offsets), end(offsets)) &&
+	     all_of(begin(entries), end(entries),
+	            [&](auto& e) { return e.second < offsets.size() - 1; }) &&
+	     is_sorted(begin(entries), end(entries));
+	if (!ok) {
+		clear();
+		return false;
+	}
+	max_dist = dist;
+	return true;
+}
+
+template <class CharT>
+auto Delete_Index<CharT>::clear() -> void
+{
+	chars.clear();
+	offsets.clear();
+	entries.clear();
+	max_dist = 0;
+	seconds = 0;
+}
+
+/**
+ * Gets the heap memory of the index in bytes.
+ */
+template <class CharT>
+auto Delete_Index<CharT>::memory_usage() const -> size_t
+{
+	return chars.capacity() * sizeof(CharT) +
+	       offsets.capacity() * sizeof(offsets[0]) +
+	       entries.capacity() * sizeof(entries[0]);
+}
+
+template class Delete_Index<char>;
+template class Delete_Index<wchar_t>;
+} // namespace nuspell
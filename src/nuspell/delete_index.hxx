@@ -0,0 +1,87 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file delete_index.hxx
+ * Symmetric delete index of words for suggestions.
+ */
+
+#ifndef NUSPELL_DELETE_INDEX_HXX
+#define NUSPELL_DELETE_INDEX_HXX
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Index of the words by the strings made by deleting characters.
+ *
+ * Two words are within edit distance k only if deleting at most k
+ * characters of each gives a common string. The index maps the hashes of all
+ * such deletes of its words to the words, so the words near a misspelled
+ * word are found with lookups of the deletes of the misspelled word, instead
+ * of checking each of its edits.
+ *
+ * The distance is the optimal string alignment distance, where a swap of
+ * adjacent characters is one edit.
+ */
+template <class CharT>
+class Delete_Index {
+      public:
+	using StrT = std::basic_string<CharT>;
+
+      private:
+	StrT chars;                         // the words one after another
+	std::vector<std::uint32_t> offsets; // where each word starts
+	// hash of a delete and index of word, sorted
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> entries;
+	std::size_t max_dist = 0;
+	double seconds = 0;
+
+	auto word(std::size_t i) const -> StrT;
+
+      public:
+	auto build(const std::vector<StrT>& words, std::size_t max_distance)
+	    -> void;
+	auto lookup(const StrT& word, std::vector<StrT>& out) const -> void;
+	auto lookup(const StrT& word, std::size_t max_distance,
+	            std::vector<StrT>& out) const -> void;
+	auto write(std::ostream& out) const -> bool;
+	auto read(std::istream& in) -> bool;
+	auto clear() -> void;
+
+	auto empty() const { return offsets.empty(); }
+	auto size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	auto max_distance() const { return max_dist; }
+	auto deletes() const { return entries.size(); }
+	auto build_seconds() const { return seconds; }
+	auto memory_usage() const -> std::size_t;
+};
+extern template class Delete_Index<char>;
+extern template class Delete_Index<wchar_t>;
+
+template <class CharT>
+auto osa_distance(const std::basic_string<CharT>& a,
+                  const std::basic_string<CharT>& b) -> std::size_t;
+} // namespace nuspell
+
+#endif // NUSPELL_DELETE_INDEX_HXX
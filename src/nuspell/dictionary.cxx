@@ -24,6 +24,7 @@
 #include "dictionary.hxx"
 #include "string_utils.hxx"
 
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 
@@ -33,8 +34,127 @@ namespace nuspell {
 
 using namespace std;
 using boost::make_iterator_range;
-using boost::locale::to_lower;
-using boost::locale::to_title;
+
+namespace {
+// The counters of the current stage of checkword(), if enabled.
+thread_local Checkword_Stats::Stage* current_stage = nullptr;
+
+/**
+ * @brief Counts the calls, time and result of a stage of checkword().
+ *
+ * While in scope, the affix candidates and dictionary probes of the calling
+ * thread are counted in the stage. Does nothing if stats is nullptr.
+ */
+class Stage_Counter {
+	using clock = chrono::steady_clock;
+	Checkword_Stats::Stage* stage = nullptr;
+	clock::time_point start;
+
+      public:
+	Stage_Counter(Checkword_Stats* stats, Checkword_Stage s)
+	{
+		if (!stats)
+			return;
+		stage = &stats->stages[s];
+		++stage->calls;
+		current_stage = stage;
+		start = clock::now();
+	}
+	Stage_Counter(const Stage_Counter&) = delete;
+	auto operator=(const Stage_Counter&) -> Stage_Counter& = delete;
+	~Stage_Counter()
+	{
+		if (!stage)
+			return;
+		auto d = chrono::duration<double>(clock::now() - start);
+		stage->seconds += d.count();
+		current_stage = nullptr;
+	}
+	auto accept() -> void
+	{
+		if (stage)
+			++stage->accepted;
+	}
+};
+
+template <class CharT>
+auto add_affix(Word_Analysis& a, const Prefix<CharT>& e) -> void
+{
+	a.prefixes[a.prefix_count++] = e.flag;
+}
+
+template <class CharT>
+auto add_affix(Word_Analysis& a, const Suffix<CharT>& e) -> void
+{
+	a.suffixes[a.suffix_count++] = e.flag;
+}
+
+/**
+ * @brief The visitor of the strip functions for analyze(), records each root
+ * and its affixes and searches on.
+ */
+struct Analysis_Collector {
+	vector<Word_Analysis>* out;
+
+	template <class... Affixes>
+	auto operator()(Dic_Data::const_reference root,
+	                const Affixes&... affixes) const -> bool
+	{
+		auto a = Word_Analysis();
+		a.root = root.first;
+		a.root_flags = &root.second;
+		int expand[] = {0, (add_affix(a, affixes), 0)...};
+		(void)expand;
+		out->push_back(a);
+		return true;
+	}
+};
+
+auto count_affix_candidate() -> void
+{
+	if (current_stage)
+		++current_stage->affix_candidates;
+}
+
+/**
+ * @brief Looks up root words, counted as dictionary probe of checkword().
+ */
+template <class CharT>
+auto probe(const Dic_Data& dic, const basic_string<CharT>& word)
+{
+	if (current_stage)
+		++current_stage->dictionary_probes;
+	return dic.equal_range(word);
+}
+} // namespace
+
+/**
+ * Gets the name of a stage of checkword().
+ *
+ * @param stage the stage.
+ * @return the name of the function of the stage, or "root" for the lookup
+ * of the word as it is.
+ */
+auto checkword_stage_name(Checkword_Stage stage) -> const char*
+{
+	static const char* names[] = {"root",
+	                              "strip_prefix_only",
+	                              "strip_suffix_only",
+	                              "strip_prefix_then_suffix",
+	                              "strip_suffix_then_prefix",
+	                              "strip_suffix_then_suffix",
+	                              "strip_prefix_then_2_suffixes",
+	                              "strip_suffix_prefix_suffix",
+	                              "strip_2_suffixes_then_prefix",
+	                              "strip_prefix_then_prefix",
+	                              "strip_suffix_then_2_prefixes",
+	                              "strip_prefix_suffix_prefix",
+	                              "strip_2_prefixes_then_suffix",
+	                              "compound_check"};
+	static_assert(sizeof(names) / sizeof(names[0]) == CHECKWORD_STAGES,
+	              "a name for each stage");
+	return names[stage];
+}
 
 /** Check spelling for a word.
  *
@@ -181,6 +301,9 @@ auto Dictionary::spell_casing(std::basic_string<CharT>& s) -> const Flag_Set*
 	}
 	return res;
 }
+// spell_casing() is also used for the verification of suggestions
+template auto Dictionary::spell_casing(string& s) -> const Flag_Set*;
+template auto Dictionary::spell_casing(wstring& s) -> const Flag_Set*;
 
 /**
  * Checks spelling for a word which is in all upper case.
@@ -316,80 +439,152 @@ auto Dictionary::spell_sharps(std::basic_string<CharT>& base, size_t pos,
  * Unaffixing is done by combinations of zero or more unsuffixing and
  * unprefixing operations.
  *
+ * If the form index is built, it replaces the root lookup and the
+ * unaffixing, and only compounding is tried for the words not in it.
+ *
  * @param s string to check spelling for.
  * @return The flags of the corresponding dictionary word.
  */
 template <class CharT>
 auto Dictionary::checkword(std::basic_string<CharT>& s) const -> const Flag_Set*
 {
-
-	for (auto& we : make_iterator_range(words.equal_range(s))) {
-		auto& word_flags = we.second;
-		if (word_flags.contains(need_affix_flag))
-			continue;
-		if (word_flags.contains(compound_onlyin_flag))
-			continue;
-		return &word_flags;
-	}
-	{
-		auto ret2 = strip_prefix_only(s);
-		if (ret2)
-			return &get<0>(*ret2).second;
+	auto stats = checkword_stats.get();
+	if (stats)
+		++stats->calls;
+	auto& index = get_form_index<CharT>();
+	const Flag_Set* ret;
+	if (index.empty()) {
+		if ((ret = check_affixed(s)))
+			return ret;
 	}
-	{
-		auto ret3 = strip_suffix_only(s);
-		if (ret3)
-			return &get<0>(*ret3).second;
+	else {
+		Stage_Counter counter(stats, CHECK_ROOT);
+		if ((ret = index.lookup(s))) {
+			counter.accept();
+			return ret;
+		}
 	}
 	{
-		auto ret4 = strip_prefix_then_suffix(s);
-		if (ret4)
-			return &get<0>(*ret4).second;
+		Stage_Counter counter(stats, CHECK_COMPOUND);
+		auto compound = compound_check(s);
+		if (compound) {
+			counter.accept();
+			return &get<0>(*compound).second;
+		}
 	}
+	if (stats)
+		++stats->misses;
+	return nullptr;
+}
+
+/**
+ * Checks a word as a root and with affixes, without compounding.
+ *
+ * @param s string to check spelling for.
+ * @return The flags of the corresponding dictionary word.
+ */
+template <class CharT>
+auto Dictionary::check_affixed(std::basic_string<CharT>& s) const
+    -> const Flag_Set*
+{
+	auto stats = checkword_stats.get();
 	{
-		auto ret5 = strip_suffix_then_prefix(s);
-		if (ret5)
-			return &get<0>(*ret5).second;
+		Stage_Counter counter(stats, CHECK_ROOT);
+		for (auto&& we : make_iterator_range(probe(words, s))) {
+			auto& word_flags = we.second;
+			if (word_flags.contains(need_affix_flag))
+				continue;
+			if (word_flags.contains(compound_onlyin_flag))
+				continue;
+			counter.accept();
+			return &word_flags;
+		}
 	}
+	// runs one stage, returns the flags of the root if it accepts the word
+	auto stage = [&](Checkword_Stage st, auto strip) -> const Flag_Set* {
+		Stage_Counter counter(stats, st);
+		auto ret = strip();
+		if (!ret)
+			return nullptr;
+		counter.accept();
+		return &get<0>(*ret).second;
+	};
+	const Flag_Set* ret;
+	if ((ret = stage(CHECK_PREFIX, [&] { return strip_prefix_only(s); })))
+		return ret;
+	if ((ret = stage(CHECK_SUFFIX, [&] { return strip_suffix_only(s); })))
+		return ret;
+	if ((ret = stage(CHECK_PREFIX_SUFFIX,
+	                 [&] { return strip_prefix_then_suffix(s); })))
+		return ret;
+	if ((ret = stage(CHECK_SUFFIX_PREFIX,
+	                 [&] { return strip_suffix_then_prefix(s); })))
+		return ret;
 	if (complex_prefixes == false) {
-		auto ret6 = strip_suffix_then_suffix(s);
-		if (ret6)
-			return &get<0>(*ret6).second;
-
-		auto ret7 = strip_prefix_then_2_suffixes(s);
-		if (ret7)
-			return &get<0>(*ret7).second;
-
-		auto ret8 = strip_suffix_prefix_suffix(s);
-		if (ret8)
-			return &get<0>(*ret8).second;
-
-		auto ret9 = strip_2_suffixes_then_prefix(s);
-		if (ret9)
-			return &get<0>(*ret9).second;
+		if ((ret = stage(CHECK_SUFFIX_SUFFIX,
+		                 [&] { return strip_suffix_then_suffix(s); })))
+			return ret;
+		if ((ret = stage(CHECK_PREFIX_2_SUFFIXES, [&] {
+			     return strip_prefix_then_2_suffixes(s);
+		     })))
+			return ret;
+		if ((ret = stage(CHECK_SUFFIX_PREFIX_SUFFIX, [&] {
+			     return strip_suffix_prefix_suffix(s);
+		     })))
+			return ret;
+		if ((ret = stage(CHECK_2_SUFFIXES_PREFIX, [&] {
+			     return strip_2_suffixes_then_prefix(s);
+		     })))
+			return ret;
 	}
 	else {
-		auto ret6 = strip_prefix_then_prefix(s);
-		if (ret6)
-			return &get<0>(*ret6).second;
-		auto ret7 = strip_suffix_then_2_prefixes(s);
-		if (ret7)
-			return &get<0>(*ret7).second;
-
-		auto ret8 = strip_prefix_suffix_prefix(s);
-		if (ret8)
-			return &get<0>(*ret8).second;
-
-		auto ret9 = strip_2_prefixes_then_suffix(s);
-		if (ret9)
-			return &get<0>(*ret9).second;
+		if ((ret = stage(CHECK_PREFIX_PREFIX,
+		                 [&] { return strip_prefix_then_prefix(s); })))
+			return ret;
+		if ((ret = stage(CHECK_SUFFIX_2_PREFIXES, [&] {
+			     return strip_suffix_then_2_prefixes(s);
+		     })))
+			return ret;
+		if ((ret = stage(CHECK_PREFIX_SUFFIX_PREFIX, [&] {
+			     return strip_prefix_suffix_prefix(s);
+		     })))
+			return ret;
+		if ((ret = stage(CHECK_2_PREFIXES_SUFFIX, [&] {
+			     return strip_2_prefixes_then_suffix(s);
+		     })))
+			return ret;
 	}
-	auto ret10 = compound_check(s);
-	if (ret10)
-		return &get<0>(*ret10).second;
-
 	return nullptr;
 }
+template auto Dictionary::check_affixed(string& s) const -> const Flag_Set*;
+template auto Dictionary::check_affixed(wstring& s) const -> const Flag_Set*;
+
+/**
+ * Enables or disables the counters of the stages of checkword().
+ *
+ * The counters are not synchronized, so they should be enabled only while
+ * one thread checks words with this dictionary. Copies of the dictionary
+ * made while enabled share the counters.
+ *
+ * @param enable true to start counting from zero, false to stop.
+ */
+auto Dictionary::enable_checkword_stats(bool enable) -> void
+{
+	if (enable)
+		checkword_stats = make_shared<Checkword_Stats>();
+	else
+		checkword_stats.reset();
+}
+
+/**
+ * Gets the counters of the stages of checkword().
+ *
+ * @return the counters, or nullptr if they are not enabled.
+ */
+auto Dictionary::get_checkword_stats() const -> const Checkword_Stats*
+{
+	return checkword_stats.get();
+}
 
 template <class CharT, template <class> class AffixT>
 class To_Root_Unroot_RAII {
@@ -499,6 +694,7 @@ class Prefix_Iter {
 			pfx = prefix(word, len);
 			tie(a, b) = tbl.equal_range(pfx);
 			for (; a != b; ++a) {
+				count_affix_candidate();
 				valid = true;
 				return;
 			}
@@ -513,6 +709,7 @@ class Prefix_Iter {
 			pfx = prefix(word, len);
 			tie(a, b) = tbl.equal_range(pfx);
 			for (; a != b; ++a) {
+				count_affix_candidate();
 				return *this;
 			resume_pfx_of_word:;
 			}
@@ -550,6 +747,7 @@ class Suffix_Iter {
 			pfx = suffix(word, len);
 			tie(a, b) = tbl.equal_range(pfx);
 			for (; a != b; ++a) {
+				count_affix_candidate();
 				valid = true;
 				return;
 			}
@@ -564,6 +762,7 @@ class Suffix_Iter {
 			pfx = suffix(word, len);
 			tie(a, b) = tbl.equal_range(pfx);
 			for (; a != b; ++a) {
+				count_affix_candidate();
 				return *this;
 			resume_sfx_of_word:;
 			}
@@ -576,8 +775,9 @@ class Suffix_Iter {
 	auto aff_len() { return len; }
 };
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_prefix_only(std::basic_string<CharT>& word) const
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_prefix_only(std::basic_string<CharT>& word,
+                                   Visitor visit) const
     -> boost::optional<
         std::tuple<Dic_Data::const_reference, const Prefix<CharT>&>>
 {
@@ -593,8 +793,8 @@ auto Dictionary::strip_prefix_only(std::basic_string<CharT>& word) const
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, e);
 		if (!e.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(word_flags, e))
 				continue;
@@ -621,14 +821,17 @@ auto Dictionary::strip_prefix_only(std::basic_string<CharT>& word) const
 			    !word_flags.contains(compound_last_flag) &&
 			    !e.cont_flags.contains(compound_last_flag))
 				continue;
+			if (visit(word_entry, e))
+				continue;
 			return {{word_entry, e}};
 		}
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_suffix_only(std::basic_string<CharT>& word) const
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_suffix_only(std::basic_string<CharT>& word,
+                                   Visitor visit) const
     -> boost::optional<
         std::tuple<Dic_Data::const_reference, const Suffix<CharT>&>>
 {
@@ -647,8 +850,8 @@ auto Dictionary::strip_suffix_only(std::basic_string<CharT>& word) const
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, e);
 		if (!e.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(word_flags, e))
 				continue;
@@ -675,14 +878,17 @@ auto Dictionary::strip_suffix_only(std::basic_string<CharT>& word) const
 			    !word_flags.contains(compound_last_flag) &&
 			    !e.cont_flags.contains(compound_last_flag))
 				continue;
+			if (visit(word_entry, e))
+				continue;
 			return {{word_entry, e}};
 		}
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_prefix_then_suffix(std::basic_string<CharT>& word) const
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_prefix_then_suffix(std::basic_string<CharT>& word,
+                                          Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Suffix<CharT>&, const Prefix<CharT>&>>
 {
@@ -697,16 +903,17 @@ auto Dictionary::strip_prefix_then_suffix(std::basic_string<CharT>& word) const
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe);
 		if (!pe.check_condition(word))
 			continue;
-		auto ret = strip_pfx_then_sfx_2<m>(pe, word);
+		auto ret = strip_pfx_then_sfx_2<m>(pe, word, visit);
 		if (ret)
 			return ret;
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_pfx_then_sfx_2(const Prefix<CharT>& pe,
-                                      std::basic_string<CharT>& word) const
+                                      std::basic_string<CharT>& word,
+                                      Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Suffix<CharT>&, const Prefix<CharT>&>>
 {
@@ -724,8 +931,8 @@ auto Dictionary::strip_pfx_then_sfx_2(const Prefix<CharT>& pe,
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se);
 		if (!se.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(se, pe) &&
 			    !cross_valid_inner_outer(word_flags, pe))
@@ -737,6 +944,8 @@ auto Dictionary::strip_pfx_then_sfx_2(const Prefix<CharT>& pe,
 			    word_flags.contains(compound_onlyin_flag))
 				continue;
 			// needflag check here if needed
+			if (visit(word_entry, pe, se))
+				continue;
 			return {{word_entry, se, pe}};
 		}
 	}
@@ -744,8 +953,9 @@ auto Dictionary::strip_pfx_then_sfx_2(const Prefix<CharT>& pe,
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_suffix_then_prefix(std::basic_string<CharT>& word) const
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_suffix_then_prefix(std::basic_string<CharT>& word,
+                                          Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Prefix<CharT>&, const Suffix<CharT>&>>
 {
@@ -760,16 +970,17 @@ auto Dictionary::strip_suffix_then_prefix(std::basic_string<CharT>& word) const
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se);
 		if (!se.check_condition(word))
 			continue;
-		auto ret = strip_sfx_then_pfx_2<m>(se, word);
+		auto ret = strip_sfx_then_pfx_2<m>(se, word, visit);
 		if (ret)
 			return ret;
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_sfx_then_pfx_2(const Suffix<CharT>& se,
-                                      std::basic_string<CharT>& word) const
+                                      std::basic_string<CharT>& word,
+                                      Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Prefix<CharT>&, const Suffix<CharT>&>>
 {
@@ -787,8 +998,8 @@ auto Dictionary::strip_sfx_then_pfx_2(const Suffix<CharT>& se,
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe);
 		if (!pe.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(pe, se) &&
 			    !cross_valid_inner_outer(word_flags, se))
@@ -800,14 +1011,17 @@ auto Dictionary::strip_sfx_then_pfx_2(const Suffix<CharT>& se,
 			    word_flags.contains(compound_onlyin_flag))
 				continue;
 			// needflag check here if needed
+			if (visit(word_entry, se, pe))
+				continue;
 			return {{word_entry, pe, se}};
 		}
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_suffix_then_suffix(std::basic_string<CharT>& word) const
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_suffix_then_suffix(std::basic_string<CharT>& word,
+                                          Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Suffix<CharT>&, const Suffix<CharT>&>>
 {
@@ -822,16 +1036,17 @@ auto Dictionary::strip_suffix_then_suffix(std::basic_string<CharT>& word) const
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se1);
 		if (!se1.check_condition(word))
 			continue;
-		auto ret = strip_sfx_then_sfx_2<FULL_WORD>(se1, word);
+		auto ret = strip_sfx_then_sfx_2<FULL_WORD>(se1, word, visit);
 		if (ret)
 			return ret;
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_sfx_then_sfx_2(const Suffix<CharT>& se1,
-                                      std::basic_string<CharT>& word) const
+                                      std::basic_string<CharT>& word,
+                                      Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Suffix<CharT>&, const Suffix<CharT>&>>
 {
@@ -850,8 +1065,8 @@ auto Dictionary::strip_sfx_then_sfx_2(const Suffix<CharT>& se1,
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se2);
 		if (!se2.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(word_flags, se2))
 				continue;
@@ -860,14 +1075,17 @@ auto Dictionary::strip_sfx_then_sfx_2(const Suffix<CharT>& se1,
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
 			// needflag check here if needed
+			if (visit(word_entry, se1, se2))
+				continue;
 			return {{word_entry, se2, se1}};
 		}
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_prefix_then_prefix(std::basic_string<CharT>& word) const
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_prefix_then_prefix(std::basic_string<CharT>& word,
+                                          Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Prefix<CharT>&, const Prefix<CharT>&>>
 {
@@ -882,16 +1100,17 @@ auto Dictionary::strip_prefix_then_prefix(std::basic_string<CharT>& word) const
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe1);
 		if (!pe1.check_condition(word))
 			continue;
-		auto ret = strip_pfx_then_pfx_2<FULL_WORD>(pe1, word);
+		auto ret = strip_pfx_then_pfx_2<FULL_WORD>(pe1, word, visit);
 		if (ret)
 			return ret;
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_pfx_then_pfx_2(const Prefix<CharT>& pe1,
-                                      std::basic_string<CharT>& word) const
+                                      std::basic_string<CharT>& word,
+                                      Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference,
                                   const Prefix<CharT>&, const Prefix<CharT>&>>
 {
@@ -909,8 +1128,8 @@ auto Dictionary::strip_pfx_then_pfx_2(const Prefix<CharT>& pe1,
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe2);
 		if (!pe2.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(word_flags, pe2))
 				continue;
@@ -919,15 +1138,18 @@ auto Dictionary::strip_pfx_then_pfx_2(const Prefix<CharT>& pe1,
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
 			// needflag check here if needed
+			if (visit(word_entry, pe1, pe2))
+				continue;
 			return {{word_entry, pe2, pe1}};
 		}
 	}
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_prefix_then_2_suffixes(std::basic_string<CharT>& word)
-    const -> boost::optional<std::tuple<Dic_Data::const_reference>>
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_prefix_then_2_suffixes(std::basic_string<CharT>& word,
+                                              Visitor visit) const
+    -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& prefixes = get_structures<CharT>().prefixes;
 	auto& suffixes = get_structures<CharT>().suffixes;
@@ -952,7 +1174,8 @@ auto Dictionary::strip_prefix_then_2_suffixes(std::basic_string<CharT>& word)
 			To_Root_Unroot_RAII<CharT, Suffix> yyy(word, se1);
 			if (!se1.check_condition(word))
 				continue;
-			auto ret = strip_pfx_2_sfx_3<FULL_WORD>(pe1, se1, word);
+			auto ret = strip_pfx_2_sfx_3<FULL_WORD>(pe1, se1, word,
+			                                        visit);
 			if (ret)
 				return ret;
 		}
@@ -960,10 +1183,11 @@ auto Dictionary::strip_prefix_then_2_suffixes(std::basic_string<CharT>& word)
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_pfx_2_sfx_3(const Prefix<CharT>& pe1,
                                    const Suffix<CharT>& se1,
-                                   std::basic_string<CharT>& word) const
+                                   std::basic_string<CharT>& word,
+                                   Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& dic = words;
@@ -980,8 +1204,8 @@ auto Dictionary::strip_pfx_2_sfx_3(const Prefix<CharT>& pe1,
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se2);
 		if (!se2.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(se1, pe1) &&
 			    !cross_valid_inner_outer(word_flags, pe1))
@@ -993,6 +1217,8 @@ auto Dictionary::strip_pfx_2_sfx_3(const Prefix<CharT>& pe1,
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
 			// needflag check here if needed
+			if (visit(word_entry, pe1, se1, se2))
+				continue;
 			return {{word_entry}};
 		}
 	}
@@ -1000,9 +1226,10 @@ auto Dictionary::strip_pfx_2_sfx_3(const Prefix<CharT>& pe1,
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_suffix_prefix_suffix(std::basic_string<CharT>& word)
-    const -> boost::optional<std::tuple<Dic_Data::const_reference>>
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_suffix_prefix_suffix(std::basic_string<CharT>& word,
+                                            Visitor visit) const
+    -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& prefixes = get_structures<CharT>().prefixes;
 	auto& suffixes = get_structures<CharT>().suffixes;
@@ -1025,7 +1252,8 @@ auto Dictionary::strip_suffix_prefix_suffix(std::basic_string<CharT>& word)
 			To_Root_Unroot_RAII<CharT, Prefix> yyy(word, pe1);
 			if (!pe1.check_condition(word))
 				continue;
-			auto ret = strip_s_p_s_3<FULL_WORD>(se1, pe1, word);
+			auto ret = strip_s_p_s_3<FULL_WORD>(se1, pe1, word,
+			                                    visit);
 			if (ret)
 				return ret;
 		}
@@ -1033,10 +1261,11 @@ auto Dictionary::strip_suffix_prefix_suffix(std::basic_string<CharT>& word)
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_s_p_s_3(const Suffix<CharT>& se1,
                                const Prefix<CharT>& pe1,
-                               std::basic_string<CharT>& word) const
+                               std::basic_string<CharT>& word,
+                               Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& dic = words;
@@ -1058,8 +1287,8 @@ auto Dictionary::strip_s_p_s_3(const Suffix<CharT>& se1,
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se2);
 		if (!se2.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(se2, pe1) &&
 			    !cross_valid_inner_outer(word_flags, pe1))
@@ -1071,6 +1300,8 @@ auto Dictionary::strip_s_p_s_3(const Suffix<CharT>& se1,
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
 			// needflag check here if needed
+			if (visit(word_entry, se1, pe1, se2))
+				continue;
 			return {{word_entry}};
 		}
 	}
@@ -1078,9 +1309,10 @@ auto Dictionary::strip_s_p_s_3(const Suffix<CharT>& se1,
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_2_suffixes_then_prefix(std::basic_string<CharT>& word)
-    const -> boost::optional<std::tuple<Dic_Data::const_reference>>
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_2_suffixes_then_prefix(std::basic_string<CharT>& word,
+                                              Visitor visit) const
+    -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& suffixes = get_structures<CharT>().suffixes;
 
@@ -1102,7 +1334,8 @@ auto Dictionary::strip_2_suffixes_then_prefix(std::basic_string<CharT>& word)
 			To_Root_Unroot_RAII<CharT, Suffix> yyy(word, se2);
 			if (!se2.check_condition(word))
 				continue;
-			auto ret = strip_2_sfx_pfx_3<FULL_WORD>(se1, se2, word);
+			auto ret = strip_2_sfx_pfx_3<FULL_WORD>(se1, se2, word,
+			                                        visit);
 			if (ret)
 				return ret;
 		}
@@ -1110,10 +1343,11 @@ auto Dictionary::strip_2_suffixes_then_prefix(std::basic_string<CharT>& word)
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_2_sfx_pfx_3(const Suffix<CharT>& se1,
                                    const Suffix<CharT>& se2,
-                                   std::basic_string<CharT>& word) const
+                                   std::basic_string<CharT>& word,
+                                   Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& dic = words;
@@ -1131,8 +1365,8 @@ auto Dictionary::strip_2_sfx_pfx_3(const Suffix<CharT>& se1,
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe1);
 		if (!pe1.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(pe1, se2) &&
 			    !cross_valid_inner_outer(word_flags, se2))
@@ -1144,6 +1378,8 @@ auto Dictionary::strip_2_sfx_pfx_3(const Suffix<CharT>& se1,
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
 			// needflag check here if needed
+			if (visit(word_entry, se1, se2, pe1))
+				continue;
 			return {{word_entry}};
 		}
 	}
@@ -1151,9 +1387,10 @@ auto Dictionary::strip_2_sfx_pfx_3(const Suffix<CharT>& se1,
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_suffix_then_2_prefixes(std::basic_string<CharT>& word)
-    const -> boost::optional<std::tuple<Dic_Data::const_reference>>
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_suffix_then_2_prefixes(std::basic_string<CharT>& word,
+                                              Visitor visit) const
+    -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& prefixes = get_structures<CharT>().prefixes;
 	auto& suffixes = get_structures<CharT>().suffixes;
@@ -1178,7 +1415,8 @@ auto Dictionary::strip_suffix_then_2_prefixes(std::basic_string<CharT>& word)
 			To_Root_Unroot_RAII<CharT, Prefix> yyy(word, pe1);
 			if (!pe1.check_condition(word))
 				continue;
-			auto ret = strip_sfx_2_pfx_3<FULL_WORD>(se1, pe1, word);
+			auto ret = strip_sfx_2_pfx_3<FULL_WORD>(se1, pe1, word,
+			                                        visit);
 			if (ret)
 				return ret;
 		}
@@ -1186,10 +1424,11 @@ auto Dictionary::strip_suffix_then_2_prefixes(std::basic_string<CharT>& word)
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_sfx_2_pfx_3(const Suffix<CharT>& se1,
                                    const Prefix<CharT>& pe1,
-                                   std::basic_string<CharT>& word) const
+                                   std::basic_string<CharT>& word,
+                                   Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& dic = words;
@@ -1206,8 +1445,8 @@ auto Dictionary::strip_sfx_2_pfx_3(const Suffix<CharT>& se1,
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe2);
 		if (!pe2.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(pe1, se1) &&
 			    !cross_valid_inner_outer(word_flags, se1))
@@ -1218,6 +1457,8 @@ auto Dictionary::strip_sfx_2_pfx_3(const Suffix<CharT>& se1,
 			// if (m == FULL_WORD &&
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
+			if (visit(word_entry, se1, pe1, pe2))
+				continue;
 			return {{word_entry}};
 		}
 	}
@@ -1225,9 +1466,10 @@ auto Dictionary::strip_sfx_2_pfx_3(const Suffix<CharT>& se1,
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_prefix_suffix_prefix(std::basic_string<CharT>& word)
-    const -> boost::optional<std::tuple<Dic_Data::const_reference>>
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_prefix_suffix_prefix(std::basic_string<CharT>& word,
+                                            Visitor visit) const
+    -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& prefixes = get_structures<CharT>().prefixes;
 	auto& suffixes = get_structures<CharT>().suffixes;
@@ -1250,7 +1492,8 @@ auto Dictionary::strip_prefix_suffix_prefix(std::basic_string<CharT>& word)
 			To_Root_Unroot_RAII<CharT, Suffix> yyy(word, se1);
 			if (!se1.check_condition(word))
 				continue;
-			auto ret = strip_p_s_p_3<FULL_WORD>(pe1, se1, word);
+			auto ret = strip_p_s_p_3<FULL_WORD>(pe1, se1, word,
+			                                    visit);
 			if (ret)
 				return ret;
 		}
@@ -1258,10 +1501,11 @@ auto Dictionary::strip_prefix_suffix_prefix(std::basic_string<CharT>& word)
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_p_s_p_3(const Prefix<CharT>& pe1,
                                const Suffix<CharT>& se1,
-                               std::basic_string<CharT>& word) const
+                               std::basic_string<CharT>& word,
+                               Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& dic = words;
@@ -1283,8 +1527,8 @@ auto Dictionary::strip_p_s_p_3(const Prefix<CharT>& pe1,
 		To_Root_Unroot_RAII<CharT, Prefix> xxx(word, pe2);
 		if (!pe2.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(pe2, se1) &&
 			    !cross_valid_inner_outer(word_flags, se1))
@@ -1295,6 +1539,8 @@ auto Dictionary::strip_p_s_p_3(const Prefix<CharT>& pe1,
 			// if (m == FULL_WORD &&
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
+			if (visit(word_entry, pe1, se1, pe2))
+				continue;
 			return {{word_entry}};
 		}
 	}
@@ -1302,9 +1548,10 @@ auto Dictionary::strip_p_s_p_3(const Prefix<CharT>& pe1,
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
-auto Dictionary::strip_2_prefixes_then_suffix(std::basic_string<CharT>& word)
-    const -> boost::optional<std::tuple<Dic_Data::const_reference>>
+template <Affixing_Mode m, class CharT, class Visitor>
+auto Dictionary::strip_2_prefixes_then_suffix(std::basic_string<CharT>& word,
+                                              Visitor visit) const
+    -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& prefixes = get_structures<CharT>().prefixes;
 
@@ -1326,7 +1573,8 @@ auto Dictionary::strip_2_prefixes_then_suffix(std::basic_string<CharT>& word)
 			To_Root_Unroot_RAII<CharT, Prefix> yyy(word, pe2);
 			if (!pe2.check_condition(word))
 				continue;
-			auto ret = strip_2_pfx_sfx_3<FULL_WORD>(pe1, pe2, word);
+			auto ret = strip_2_pfx_sfx_3<FULL_WORD>(pe1, pe2, word,
+			                                        visit);
 			if (ret)
 				return ret;
 		}
@@ -1334,10 +1582,11 @@ auto Dictionary::strip_2_prefixes_then_suffix(std::basic_string<CharT>& word)
 	return {};
 }
 
-template <Affixing_Mode m, class CharT>
+template <Affixing_Mode m, class CharT, class Visitor>
 auto Dictionary::strip_2_pfx_sfx_3(const Prefix<CharT>& pe1,
                                    const Prefix<CharT>& pe2,
-                                   std::basic_string<CharT>& word) const
+                                   std::basic_string<CharT>& word,
+                                   Visitor visit) const
     -> boost::optional<std::tuple<Dic_Data::const_reference>>
 {
 	auto& dic = words;
@@ -1355,8 +1604,8 @@ auto Dictionary::strip_2_pfx_sfx_3(const Prefix<CharT>& pe1,
 		To_Root_Unroot_RAII<CharT, Suffix> xxx(word, se1);
 		if (!se1.check_condition(word))
 			continue;
-		for (auto& word_entry :
-		     make_iterator_range(dic.equal_range(word))) {
+		for (auto&& word_entry :
+		     make_iterator_range(probe(dic, word))) {
 			auto& word_flags = word_entry.second;
 			if (!cross_valid_inner_outer(se1, pe2) &&
 			    !cross_valid_inner_outer(word_flags, pe2))
@@ -1367,6 +1616,8 @@ auto Dictionary::strip_2_pfx_sfx_3(const Prefix<CharT>& pe1,
 			// if (m == FULL_WORD &&
 			//    word_flags.contains(compound_onlyin_flag))
 			//	continue;
+			if (visit(word_entry, pe1, pe2, se1))
+				continue;
 			return {{word_entry}};
 		}
 	}
@@ -1374,6 +1625,34 @@ auto Dictionary::strip_2_pfx_sfx_3(const Prefix<CharT>& pe1,
 	return {};
 }
 
+/**
+ * Checks if a REP replacement makes a word that is not compound.
+ *
+ * This is for CHECKCOMPOUNDREP, a compound word is not accepted if it is
+ * more likely a misspelling of a simple word, one with at most a prefix and
+ * a suffix.
+ *
+ * @param word the compound word.
+ * @return true if one of the replacements is a simple word.
+ */
+template <class CharT>
+auto Dictionary::is_rep_similar(const std::basic_string<CharT>& word) const
+    -> bool
+{
+	auto& table = get_structures<CharT>().replacement_table;
+	auto found = vector<basic_string<CharT>>();
+	table.replace_each(word, found);
+	for (auto& w : found) {
+		for (auto&& we : make_iterator_range(probe(words, w)))
+			if (!we.second.contains(need_affix_flag))
+				return true;
+		if (strip_prefix_only(w) || strip_suffix_only(w) ||
+		    strip_prefix_then_suffix(w) || strip_suffix_then_prefix(w))
+			return true;
+	}
+	return false;
+}
+
 template <class CharT>
 auto Dictionary::compound_check(std::basic_string<CharT>& word,
                                 size_t num) const
@@ -1386,9 +1665,9 @@ auto Dictionary::compound_check(std::basic_string<CharT>& word,
         size_t max_length = word.size() - min_length;
         for (auto i = min_length; i <= max_length; ++i) {
 	        part_str.assign(word, 0, i);
-		auto range1 = words.equal_range(part_str);
+		auto range1 = probe(words, part_str);
 		auto part1_entry =
-		    find_if(range1.first, range1.second, [&](auto& e) {
+		    find_if(range1.first, range1.second, [&](auto&& e) {
 			    auto& word_flags = e.second;
 			    if (word_flags.contains(need_affix_flag))
 				    return false;
@@ -1406,9 +1685,9 @@ auto Dictionary::compound_check(std::basic_string<CharT>& word,
 			return {};
 
 		part_str.assign(word, i, word.npos);
-		auto range2 = words.equal_range(part_str);
+		auto range2 = probe(words, part_str);
 		auto part2_entry =
-		    find_if(range2.first, range2.second, [&](auto& e) {
+		    find_if(range2.first, range2.second, [&](auto&& e) {
 			    auto& word_flags = e.second;
 			    if (word_flags.contains(need_affix_flag))
 				    return false;
@@ -1424,9 +1703,187 @@ auto Dictionary::compound_check(std::basic_string<CharT>& word,
 		    });
 		if (part2_entry == range2.second)
 			return {};
+		if (compound_check_rep && is_rep_similar(word))
+			return {};
+		// a part with NOSUGGEST keeps the compound out of suggestions
+		if ((*part2_entry).second.contains(nosuggest_flag))
+			return {{*part2_entry}};
 		return {{*part1_entry}};
         }
         return {};
 }
 
+/**
+ * Finds the roots of a word with zero to three affixes.
+ *
+ * The same stages as in checkword() run, except compounding, and each
+ * appends all the roots it finds to out, also the same derivation found by
+ * several stages.
+ */
+template <class CharT>
+auto Dictionary::analyze_word(std::basic_string<CharT>& word,
+                              std::vector<Word_Analysis>& out) const -> void
+{
+	auto visit = Analysis_Collector{&out};
+	for (auto&& we : make_iterator_range(probe(words, word))) {
+		auto& word_flags = we.second;
+		if (word_flags.contains(need_affix_flag) ||
+		    word_flags.contains(compound_onlyin_flag))
+			continue;
+		visit(we);
+	}
+	strip_prefix_only(word, visit);
+	strip_suffix_only(word, visit);
+	strip_prefix_then_suffix(word, visit);
+	strip_suffix_then_prefix(word, visit);
+	if (complex_prefixes == false) {
+		strip_suffix_then_suffix(word, visit);
+		strip_prefix_then_2_suffixes(word, visit);
+		strip_suffix_prefix_suffix(word, visit);
+		strip_2_suffixes_then_prefix(word, visit);
+	}
+	else {
+		strip_prefix_then_prefix(word, visit);
+		strip_suffix_then_2_prefixes(word, visit);
+		strip_prefix_suffix_prefix(word, visit);
+		strip_2_prefixes_then_suffix(word, visit);
+	}
+}
+
+/**
+ * Finds all derivations of a word from the roots of the dictionary.
+ *
+ * A word in title case or in upper case is also analyzed in lower case if
+ * it has no derivation as it is. Compound words and the roots marked as
+ * forbidden have none.
+ *
+ * @param word the word, in the intermediate encoding.
+ * @param out the derivations, previous content is cleared.
+ */
+template <class CharT>
+auto Dictionary::analyze_priv(std::basic_string<CharT> word,
+                              std::vector<Word_Analysis>& out) const -> void
+{
+	out.clear();
+	size_t MAXWORDLENGTH = 180;
+	if (word.size() >= MAXWORDLENGTH)
+		return;
+	get_structures<CharT>().input_substr_replacer.replace(word);
+	if (word.empty())
+		return;
+	analyze_word(word, out);
+	auto casing = classify_casing(word, locale_aff);
+	if (out.empty() && casing == Casing::ALL_CAPITAL) {
+		auto title = to_title(word, locale_aff);
+		analyze_word(title, out);
+	}
+	if (out.empty() &&
+	    (casing == Casing::INIT_CAPITAL || casing == Casing::ALL_CAPITAL)) {
+		auto lower = to_lower(word, locale_aff);
+		analyze_word(lower, out);
+	}
+
+	// The same derivation can be found by several stages, only the first
+	// one is kept. They are sorted apart to keep the order of the rest.
+	auto key = [&](size_t i) {
+		auto& a = out[i];
+		return make_tuple(a.root.data(), a.root_flags, a.prefix_count,
+		                  a.prefixes[0], a.prefixes[1], a.suffix_count,
+		                  a.suffixes[0], a.suffixes[1]);
+	};
+	auto order = vector<size_t>(out.size());
+	for (size_t i = 0; i != order.size(); ++i)
+		order[i] = i;
+	stable_sort(begin(order), end(order),
+	            [&](size_t i, size_t j) { return key(i) < key(j); });
+	auto repeated = vector<bool>(out.size());
+	for (size_t i = 1; i < order.size(); ++i)
+		repeated[order[i]] = key(order[i]) == key(order[i - 1]);
+	auto n = size_t(0);
+	for (size_t i = 0; i != out.size(); ++i) {
+		if (repeated[i] ||
+		    out[i].root_flags->contains(forbiddenword_flag))
+			continue;
+		out[n++] = out[i];
+	}
+	out.resize(n);
+}
+template auto Dictionary::analyze_priv(string word,
+                                       vector<Word_Analysis>& out) const
+    -> void;
+template auto Dictionary::analyze_priv(wstring word,
+                                       vector<Word_Analysis>& out) const
+    -> void;
+
+/**
+ * Finds all derivations of a word from the roots of the dictionary.
+ *
+ * This is the morphological analysis by the affix rules, the dictionary
+ * does not keep the morphological fields. Compound words are not analyzed,
+ * they have no derivation even if they are correct. The derivations refer
+ * to the dictionary and are not allocated apart from the vector, which
+ * keeps its capacity between calls.
+ *
+ * @param word the word, in the encoding of loc.
+ * @param out the derivations, previous content is cleared.
+ * @param loc locale of the encoding of the word.
+ */
+auto Dictionary::analyze(const std::string& word,
+                         std::vector<Word_Analysis>& out,
+                         std::locale loc) const -> void
+{
+	using info_t = boost::locale::info;
+	auto& dic_info = use_facet<info_t>(locale_aff);
+	if (dic_info.utf8())
+		analyze_priv(Locale_Input::cvt_for_u8_dict(word, loc), out);
+	else
+		analyze_priv(
+		    Locale_Input::cvt_for_byte_dict(word, loc, locale_aff),
+		    out);
+}
+
+/**
+ * Finds the derivations of many words.
+ *
+ * @param words the words, in the encoding of loc.
+ * @param out the derivations of each word. The inner vectors are reused.
+ * @param loc locale of the encoding of the words.
+ */
+auto Dictionary::analyze_batch(const std::vector<std::string>& words,
+                               std::vector<std::vector<Word_Analysis>>& out,
+                               std::locale loc) const -> void
+{
+	out.resize(words.size());
+	for (size_t i = 0; i != words.size(); ++i)
+		analyze(words[i], out[i], loc);
+}
+
+/**
+ * Finds the roots of a word.
+ *
+ * @param word the word, in the encoding of loc.
+ * @param out the distinct roots, in the encoding of loc.
+ * @param loc locale of the encoding of the word and of the roots.
+ */
+auto Dictionary::stem(const std::string& word, std::vector<std::string>& out,
+                      std::locale loc) const -> void
+{
+	using info_t = boost::locale::info;
+	auto& dic_info = use_facet<info_t>(locale_aff);
+	auto analyses = vector<Word_Analysis>();
+	analyze(word, analyses, loc);
+	out.clear();
+	for (auto& a : analyses) {
+		auto root = string(a.root.data(), a.root.size());
+		using boost::locale::conv::utf_to_utf;
+		if (dic_info.utf8())
+			root = Locale_Output::cvt_from_u8_dict(
+			    utf_to_utf<wchar_t>(root), loc);
+		else
+			root = Locale_Output::cvt_from_byte_dict(root, loc,
+			                                         locale_aff);
+		if (find(begin(out), end(out), root) == end(out))
+			out.push_back(move(root));
+	}
+}
 } // namespace nuspell
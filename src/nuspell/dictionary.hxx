@@ -25,10 +25,20 @@
 #define NUSPELL_DICTIONARY_HXX
 
 #include "aff_data.hxx"
+#include "delete_index.hxx"
+#include "form_index.hxx"
+#include "hzip.hxx"
 #include "locale_utils.hxx"
+#include "ngram_index.hxx"
+#include "phonetic_index.hxx"
+#include "word_trie.hxx"
 
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <locale>
+#include <memory>
+#include <mutex>
 
 #include <boost/optional.hpp>
 
@@ -48,6 +58,147 @@ enum Affixing_Mode {
 	AT_COMPOUND_MIDDLE
 };
 
+/**
+ * @brief The stages of Dictionary::checkword(), in the order they are tried.
+ *
+ * The stages with two affixes on the same side depend on COMPLEXPREFIXES,
+ * only one group of four is tried for a dictionary.
+ */
+enum Checkword_Stage {
+	CHECK_ROOT /**< the word as it is */,
+	CHECK_PREFIX,
+	CHECK_SUFFIX,
+	CHECK_PREFIX_SUFFIX,
+	CHECK_SUFFIX_PREFIX,
+	CHECK_SUFFIX_SUFFIX,
+	CHECK_PREFIX_2_SUFFIXES,
+	CHECK_SUFFIX_PREFIX_SUFFIX,
+	CHECK_2_SUFFIXES_PREFIX,
+	CHECK_PREFIX_PREFIX,
+	CHECK_SUFFIX_2_PREFIXES,
+	CHECK_PREFIX_SUFFIX_PREFIX,
+	CHECK_2_PREFIXES_SUFFIX,
+	CHECK_COMPOUND,
+	CHECKWORD_STAGES /**< the number of stages */
+};
+
+auto checkword_stage_name(Checkword_Stage stage) -> const char*;
+
+/**
+ * @brief Counters of the stages of Dictionary::checkword().
+ *
+ * A stage is called if all stages before it did not accept the word. The
+ * affix candidates are the affixes whose appending matches the word, and
+ * the dictionary probes are the lookups of root words. The time of a stage
+ * includes that of counting.
+ */
+struct Checkword_Stats {
+	struct Stage {
+		size_t calls = 0;
+		size_t accepted = 0;
+		size_t affix_candidates = 0;
+		size_t dictionary_probes = 0;
+		double seconds = 0;
+	};
+	size_t calls = 0;
+	size_t misses = 0;
+	Stage stages[CHECKWORD_STAGES];
+};
+
+/**
+ * @brief Limits of the work of Dictionary::suggest().
+ *
+ * The candidates are the edits of the misspelled word that are generated and
+ * then verified. A limit of zero means no limit.
+ */
+struct Suggest_Budget {
+	size_t max_suggestions = 15;
+	size_t max_candidates = 0;
+	double max_seconds = 0;
+};
+
+/**
+ * @brief The strategies of Dictionary::suggest(), in the order they run.
+ *
+ * The cheap edits go first, the n-gram and phonetic suggestions that run
+ * only if no change of case, REP or MAP gave a suggestion go last.
+ */
+enum Suggest_Strategy {
+	SUGGEST_CASE,
+	SUGGEST_REP,
+	SUGGEST_MAP,
+	SUGGEST_INDEX /**< the delete index or the word trie */,
+	SUGGEST_SWAP,
+	SUGGEST_KEY,
+	SUGGEST_EXTRA_CHAR,
+	SUGGEST_FORGOT_CHAR,
+	SUGGEST_MOVE_CHAR,
+	SUGGEST_BAD_CHAR,
+	SUGGEST_DOUBLE_TWO_CHARS,
+	SUGGEST_TWO_WORDS,
+	SUGGEST_NGRAM,
+	SUGGEST_PHONETIC,
+	SUGGEST_STRATEGIES /**< the number of strategies */
+};
+
+auto suggest_strategy_name(Suggest_Strategy strategy) -> const char*;
+
+/**
+ * @brief What one call of Dictionary::suggest() has done.
+ *
+ * A strategy is completed if all its candidates were verified, or if it
+ * had nothing to do, e.g. without its index. When the search stops at the
+ * deadline or with enough suggestions, the strategies that did not finish
+ * are not completed.
+ */
+struct Suggest_Report {
+	bool completed[SUGGEST_STRATEGIES];
+	bool timed_out = false;
+	size_t candidates = 0;
+	double seconds = 0;
+	Suggest_Report() { std::fill_n(completed, SUGGEST_STRATEGIES, true); }
+};
+
+/**
+ * @brief One derivation of a word from a root of the dictionary.
+ *
+ * The root points into the dictionary, it is in the encoding of the
+ * dictionary and valid as long as the dictionary is not modified. The
+ * affixes are given by their flags, the outer ones first.
+ */
+struct Word_Analysis {
+	my_string_view<char> root;
+	const Flag_Set* root_flags = nullptr;
+	unsigned char prefix_count = 0;
+	unsigned char suffix_count = 0;
+	char16_t prefixes[2] = {};
+	char16_t suffixes[2] = {};
+};
+
+/**
+ * @brief Receives a word form and its derivation.
+ *
+ * See Dictionary::generate_forms().
+ */
+using Form_Callback = std::function<void(const std::string& form,
+                                         const Word_Analysis& derivation)>;
+
+/**
+ * @brief The visitor of the roots found by the strip functions of Dictionary
+ * that takes the first one, as checkword() does.
+ *
+ * A visitor is called with each root found and its affixes, the outer ones
+ * first. It returns true to search on, false to return the root.
+ */
+struct Take_First_Root {
+	template <class... Affixes>
+	auto operator()(Dic_Data::const_reference, const Affixes&...) const
+	    -> bool
+	{
+		return false;
+	}
+};
+
 class Dictionary : public Aff_Data {
       public:
 	template <class CharT>
@@ -66,6 +217,9 @@ class Dictionary : public Aff_Data {
 	                  size_t n = 0, size_t rep = 0) -> const Flag_Set*;
 	template <class CharT>
 	auto checkword(std::basic_string<CharT>& s) const -> const Flag_Set*;
+	template <class CharT>
+	auto check_affixed(std::basic_string<CharT>& s) const
+	    -> const Flag_Set*;
 
 	template <Affixing_Mode m, class CharT>
 	auto affix_NOT_valid(const Prefix<CharT>& a) const;
@@ -81,8 +235,10 @@ class Dictionary : public Aff_Data {
 	 * @param s derived word with affixes
 	 * @return if found, root word + prefix
 	 */
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_prefix_only(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_prefix_only(std::basic_string<CharT>& s,
+	                       Visitor visit = Visitor()) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Prefix<CharT>&>>;
 
@@ -91,8 +247,10 @@ class Dictionary : public Aff_Data {
 	 * @param s derived word with affixes
 	 * @return if found, root word + suffix
 	 */
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_suffix_only(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_suffix_only(std::basic_string<CharT>& s,
+	                       Visitor visit = Visitor()) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Suffix<CharT>&>>;
 
@@ -105,15 +263,18 @@ class Dictionary : public Aff_Data {
 	 * @param s derived word with affixes
 	 * @return if found, root word + suffix + prefix
 	 */
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_prefix_then_suffix(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_prefix_then_suffix(std::basic_string<CharT>& s,
+	                              Visitor visit = Visitor()) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Suffix<CharT>&,
 	                   const Prefix<CharT>&>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_pfx_then_sfx_2(const Prefix<CharT>& pe,
-	                          std::basic_string<CharT>& s) const
+	                          std::basic_string<CharT>& s,
+	                          Visitor visit) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Suffix<CharT>&,
 	                   const Prefix<CharT>&>>;
@@ -127,105 +288,152 @@ class Dictionary : public Aff_Data {
 	 * @param s derived word with prefix and suffix
 	 * @return if found, root word + prefix + suffix
 	 */
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_suffix_then_prefix(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_suffix_then_prefix(std::basic_string<CharT>& s,
+	                              Visitor visit = Visitor()) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Prefix<CharT>&,
 	                   const Suffix<CharT>&>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_sfx_then_pfx_2(const Suffix<CharT>& se,
-	                          std::basic_string<CharT>& s) const
+	                          std::basic_string<CharT>& s,
+	                          Visitor visit) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Prefix<CharT>&,
 	                   const Suffix<CharT>&>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_suffix_then_suffix(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_suffix_then_suffix(std::basic_string<CharT>& s,
+	                              Visitor visit = Visitor()) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Suffix<CharT>&,
 	                   const Suffix<CharT>&>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_sfx_then_sfx_2(const Suffix<CharT>& se1,
-	                          std::basic_string<CharT>& s) const
+	                          std::basic_string<CharT>& s,
+	                          Visitor visit) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Suffix<CharT>&,
 	                   const Suffix<CharT>&>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_prefix_then_prefix(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_prefix_then_prefix(std::basic_string<CharT>& s,
+	                              Visitor visit = Visitor()) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Prefix<CharT>&,
 	                   const Prefix<CharT>&>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_pfx_then_pfx_2(const Prefix<CharT>& pe1,
-	                          std::basic_string<CharT>& s) const
+	                          std::basic_string<CharT>& s,
+	                          Visitor visit) const
 	    -> boost::optional<
 	        std::tuple<Dic_Data::const_reference, const Prefix<CharT>&,
 	                   const Prefix<CharT>&>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_prefix_then_2_suffixes(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_prefix_then_2_suffixes(std::basic_string<CharT>& s,
+	                                  Visitor visit = Visitor()) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_pfx_2_sfx_3(const Prefix<CharT>& pe1,
 	                       const Suffix<CharT>& se1,
-	                       std::basic_string<CharT>& s) const
+	                       std::basic_string<CharT>& s,
+	                       Visitor visit) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_suffix_prefix_suffix(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_suffix_prefix_suffix(std::basic_string<CharT>& s,
+	                                Visitor visit = Visitor()) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_s_p_s_3(const Suffix<CharT>& se1, const Prefix<CharT>& pe1,
-	                   std::basic_string<CharT>& word) const
+	                   std::basic_string<CharT>& word,
+	                   Visitor visit) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_2_suffixes_then_prefix(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_2_suffixes_then_prefix(std::basic_string<CharT>& s,
+	                                  Visitor visit = Visitor()) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_2_sfx_pfx_3(const Suffix<CharT>& se1,
 	                       const Suffix<CharT>& se2,
-	                       std::basic_string<CharT>& word) const
+	                       std::basic_string<CharT>& word,
+	                       Visitor visit) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_suffix_then_2_prefixes(std::basic_string<CharT>& s) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_suffix_then_2_prefixes(std::basic_string<CharT>& s,
+	                                  Visitor visit = Visitor()) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_sfx_2_pfx_3(const Suffix<CharT>& se1,
 	                       const Prefix<CharT>& pe1,
-	                       std::basic_string<CharT>& s) const
+	                       std::basic_string<CharT>& s,
+	                       Visitor visit) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_prefix_suffix_prefix(std::basic_string<CharT>& word) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_prefix_suffix_prefix(std::basic_string<CharT>& word,
+	                                Visitor visit = Visitor()) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_p_s_p_3(const Prefix<CharT>& pe1, const Suffix<CharT>& se1,
-	                   std::basic_string<CharT>& word) const
+	                   std::basic_string<CharT>& word,
+	                   Visitor visit) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
-	template <Affixing_Mode m = FULL_WORD, class CharT>
-	auto strip_2_prefixes_then_suffix(std::basic_string<CharT>& word) const
+	template <Affixing_Mode m = FULL_WORD, class CharT,
+	          class Visitor = Take_First_Root>
+	auto strip_2_prefixes_then_suffix(std::basic_string<CharT>& word,
+	                                  Visitor visit = Visitor()) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
-	template <Affixing_Mode m, class CharT>
+	template <Affixing_Mode m, class CharT, class Visitor>
 	auto strip_2_pfx_sfx_3(const Prefix<CharT>& pe1,
 	                       const Prefix<CharT>& pe2,
-	                       std::basic_string<CharT>& word) const
+	                       std::basic_string<CharT>& word,
+	                       Visitor visit) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
 
 	template <class CharT>
 	auto compound_check(std::basic_string<CharT>& s, size_t num = 0) const
 	    -> boost::optional<std::tuple<Dic_Data::const_reference>>;
+	template <class CharT>
+	auto is_rep_similar(const std::basic_string<CharT>& word) const
+	    -> bool;
+	template <class CharT>
+	auto analyze_word(std::basic_string<CharT>& word,
+	                  std::vector<Word_Analysis>& out) const -> void;
+	template <class CharT>
+	auto analyze_priv(std::basic_string<CharT> word,
+	                  std::vector<Word_Analysis>& out) const -> void;
+
+	template <class CharT>
+	auto suggest_priv(std::basic_string<CharT> word,
+	                  std::vector<std::basic_string<CharT>>& out,
+	                  std::chrono::steady_clock::time_point deadline =
+	                      std::chrono::steady_clock::time_point::max())
+	    -> Suggest_Report;
+	template <class CharT>
+	auto check_suggestion(const std::basic_string<CharT>& s,
+	                      bool exact_casing = false) -> bool;
+	auto build_ngram_indexes_once() -> void;
 
       public:
 	Dictionary()
@@ -237,9 +445,9 @@ class Dictionary : public Aff_Data {
 	bool parse_aff_dic(const string& file_path_without_extension)
 	{
 		auto& path = file_path_without_extension;
-		std::ifstream aff_file(path + ".aff");
-		std::ifstream dic_file(path + ".dic");
-		return parse_aff_dic(aff_file, dic_file);
+		auto aff_file = open_possibly_hzipped(path + ".aff");
+		auto dic_file = open_possibly_hzipped(path + ".dic");
+		return parse_aff_dic(*aff_file, *dic_file);
 	}
 
 	auto static load_from_aff_dic(std::istream& aff, std::istream& dic)
@@ -252,13 +460,52 @@ class Dictionary : public Aff_Data {
 	auto static load_from_aff_dic(const string& file_path_without_extension)
 	{
 		auto& path = file_path_without_extension;
-		std::ifstream aff_file(path + ".aff");
-		if (aff_file.fail())
+		auto aff_file = open_possibly_hzipped(path + ".aff");
+		if (aff_file->fail())
+			throw std::ios_base::failure("Aff file not found.");
+		auto dic_file = open_possibly_hzipped(path + ".dic");
+		if (dic_file->fail())
+			throw std::ios_base::failure("Dic file not found.");
+		return load_from_aff_dic(*aff_file, *dic_file);
+	}
+
+	auto static load_from_aff_dic_lazy(const string& file_path_without_extension,
+	                                   size_t preload_bytes = 0)
+	{
+		auto& path = file_path_without_extension;
+		auto aff_file = open_possibly_hzipped(path + ".aff");
+		if (aff_file->fail())
 			throw std::ios_base::failure("Aff file not found.");
-		std::ifstream dic_file(path + ".dic");
-		if (dic_file.fail())
+		auto dic_file = open_possibly_hzipped(path + ".dic");
+		if (dic_file->fail())
 			throw std::ios_base::failure("Dic file not found.");
-		return load_from_aff_dic(aff_file, dic_file);
+		auto ret = Dictionary();
+		if (!ret.parse_aff(*aff_file) ||
+		    !ret.parse_dic_lazy(*dic_file, preload_bytes))
+			throw std::ios_base::failure("Error parsing.");
+		return ret;
+	}
+
+	auto static load_from_compiled(std::istream& in)
+	{
+		auto ret = Dictionary();
+		if (!ret.parse_compiled(in))
+			throw std::ios_base::failure(
+			    "Error loading compiled dictionary.");
+		return ret;
+	}
+	auto static load_from_compiled(const string& file_path)
+	{
+		std::ifstream file(file_path, std::ios_base::binary);
+		if (file.fail())
+			throw std::ios_base::failure(
+			    "Compiled dictionary file not found.");
+		file.close();
+		auto ret = Dictionary();
+		if (!ret.map_compiled(file_path))
+			throw std::ios_base::failure(
+			    "Error loading compiled dictionary.");
+		return ret;
 	}
 
 	auto spell_dict_encoding(const std::string& word) -> Spell_Result;
@@ -285,6 +532,128 @@ class Dictionary : public Aff_Data {
 	auto spell(const std::wstring& word) -> Spell_Result;
 	auto spell(const std::u16string& word) -> Spell_Result;
 	auto spell(const std::u32string& word) -> Spell_Result;
+
+	Suggest_Budget suggest_budget;
+	size_t suggest_threads = 1; // threads of suggest_batch()
+	auto suggest(const std::string& word, std::vector<std::string>& out,
+	             std::locale loc = std::locale()) -> void;
+	auto suggest(const std::string& word, std::vector<std::string>& out,
+	             std::chrono::steady_clock::time_point deadline,
+	             std::locale loc = std::locale()) -> Suggest_Report;
+	auto suggest_batch(const std::vector<std::string>& words,
+	                   std::vector<std::vector<std::string>>& out,
+	                   std::locale loc = std::locale()) -> void;
+
+	auto analyze(const std::string& word, std::vector<Word_Analysis>& out,
+	             std::locale loc = std::locale()) const -> void;
+	auto analyze_batch(const std::vector<std::string>& words,
+	                   std::vector<std::vector<Word_Analysis>>& out,
+	                   std::locale loc = std::locale()) const -> void;
+	auto stem(const std::string& word, std::vector<std::string>& out,
+	          std::locale loc = std::locale()) const -> void;
+	auto generate_forms(const std::string& root,
+	                    const Form_Callback& f) const -> void;
+	auto generate_all_forms(const Form_Callback& f) const -> void;
+
+	auto enable_checkword_stats(bool enable = true) -> void;
+	auto get_checkword_stats() const -> const Checkword_Stats*;
+
+	auto build_delete_index(size_t max_distance = 2, bool affixed = false)
+	    -> void;
+	auto write_delete_index(std::ostream& out) const -> bool;
+	auto read_delete_index(std::istream& in) -> bool;
+	template <class CharT>
+	auto get_delete_index() const -> const Delete_Index<CharT>&;
+	auto build_ngram_index(bool affixed = false) -> void;
+	template <class CharT>
+	auto get_ngram_index() const -> const Ngram_Index<CharT>&;
+	auto build_word_trie(size_t max_distance = 2, bool affixed = false)
+	    -> void;
+	template <class CharT>
+	auto get_word_trie() const -> const Word_Trie<CharT>&;
+	auto build_phonetic_index(bool affixed = false) -> void;
+	template <class CharT>
+	auto get_phonetic_index() const -> const Phonetic_Index<CharT>&;
+	auto build_form_index() -> void;
+	template <class CharT>
+	auto get_form_index() const -> const Form_Index<CharT>&;
+
+      private:
+	std::shared_ptr<Checkword_Stats> checkword_stats;
+	Delete_Index<char> delete_index;
+	Delete_Index<wchar_t> wide_delete_index;
+	Ngram_Index<char> ngram_index;
+	Ngram_Index<wchar_t> wide_ngram_index;
+	Form_Index<char> form_index;
+	Form_Index<wchar_t> wide_form_index;
+	Word_Trie<char> word_trie;
+	Word_Trie<wchar_t> wide_word_trie;
+	Phonetic_Index<char> phonetic_index;
+	Phonetic_Index<wchar_t> wide_phonetic_index;
+	// guards the build of the indexes on the first n-gram suggestion
+	std::shared_ptr<std::mutex> ngram_indexes_mutex =
+	    std::make_shared<std::mutex>();
+	bool ngram_indexes_built = false;
 };
+
+template <>
+auto inline Dictionary::get_delete_index<char>() const
+    -> const Delete_Index<char>&
+{
+	return delete_index;
+}
+template <>
+auto inline Dictionary::get_delete_index<wchar_t>() const
+    -> const Delete_Index<wchar_t>&
+{
+	return wide_delete_index;
+}
+template <>
+auto inline Dictionary::get_ngram_index<char>() const
+    -> const Ngram_Index<char>&
+{
+	return ngram_index;
+}
+template <>
+auto inline Dictionary::get_ngram_index<wchar_t>() const
+    -> const Ngram_Index<wchar_t>&
+{
+	return wide_ngram_index;
+}
+template <>
+auto inline Dictionary::get_word_trie<char>() const -> const Word_Trie<char>&
+{
+	return word_trie;
+}
+template <>
+auto inline Dictionary::get_word_trie<wchar_t>() const
+    -> const Word_Trie<wchar_t>&
+{
+	return wide_word_trie;
+}
+template <>
+auto inline Dictionary::get_phonetic_index<char>() const
+    -> const Phonetic_Index<char>&
+{
+	return phonetic_index;
+}
+template <>
+auto inline Dictionary::get_phonetic_index<wchar_t>() const
+    -> const Phonetic_Index<wchar_t>&
+{
+	return wide_phonetic_index;
+}
+template <>
+auto inline Dictionary::get_form_index<char>() const
+    -> const Form_Index<char>&
+{
+	return form_index;
+}
+template <>
+auto inline Dictionary::get_form_index<wchar_t>() const
+    -> const Form_Index<wchar_t>&
+{
+	return wide_form_index;
+}
 } // namespace nuspell
 #endif // NUSPELL_DICTIONARY_HXX
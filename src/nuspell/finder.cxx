@@ -22,6 +22,7 @@
  */
 
 #include "finder.hxx"
+#include "load_stats.hxx"
 #include "string_utils.hxx"
 
 #include <algorithm>
@@ -598,6 +599,8 @@ auto Finder::add_apacheopenoffice_paths() -> void
 /**
  * Searches path for dictionaries.
  *
+ * Either of the .aff and .dic files can be compressed with hzip.
+ *
  * @param dir directory path.
  * @param out output iter where to append the found dictionary names.
  * @return end of the output range
@@ -619,7 +622,12 @@ auto search_path_for_dicts(const string& dir, OutIt out) -> OutIt
 		// en_GB	/usr/share/hunspell/en_GB
 		file_name = d.entry_name();
 		auto sz = file_name.size();
-		if (sz < 4) {
+		// files compressed with hzip count as the plain ones
+		if (sz > 3 && file_name.compare(sz - 3, 3, ".hz") == 0) {
+			sz -= 3;
+			file_name.erase(sz);
+		}
+		if (sz < 4 || dics.count(file_name)) {
 			continue;
 		}
 		if (file_name.compare(sz - 4, 4, ".dic") == 0) {
@@ -648,12 +656,21 @@ auto search_path_for_dicts(const string& dir, OutIt out) -> OutIt
 
 /**
  * Searches for dictionaries in paths which have been found and added.
+ *
+ * Adds its timings and counts to the Load_Stats of the thread, if enabled.
  */
 auto Finder::search_dictionaries() -> void
 {
+	auto stats = get_load_stats();
+	Load_Timer timer(stats ? &stats->search_seconds : nullptr);
+	auto old_size = dictionaries.size();
 	for (auto& path : paths) {
 		search_path_for_dicts(path, back_inserter(dictionaries));
 	}
+	if (stats) {
+		stats->search_paths += paths.size();
+		stats->dictionaries_found += dictionaries.size() - old_size;
+	}
 }
 
 /**
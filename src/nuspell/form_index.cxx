@@ -0,0 +1,147 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file form_index.cxx
+ * Hash set of the expanded word forms for spelling.
+ */
+
+#include "form_index.hxx"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+
+// FNV-1a
+template <class CharT>
+auto hash_str(const CharT* s, size_t n) -> uint32_t
+{
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i != n; ++i) {
+		h ^= uint32_t(s[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+} // namespace
+
+/**
+ * Builds the index.
+ *
+ * @param forms the forms and the flags of their roots. The flags are
+ * copied. Of duplicate forms the first one is kept.
+ */
+template <class CharT>
+auto Form_Index<CharT>::build(const vector<pair<StrT, const Flag_Set*>>& forms)
+    -> void
+{
+	clear();
+	auto table_size = size_t(1);
+	while (table_size < forms.size() * 2)
+		table_size *= 2;
+	slots.assign(table_size, 0);
+	auto mask = table_size - 1;
+	auto flag_ids = unordered_map<u16string, uint32_t>();
+	offsets.reserve(forms.size() + 1);
+	form_flags.reserve(forms.size());
+	for (auto& f : forms) {
+		auto& w = f.first;
+		auto i = hash_str(w.data(), w.size()) & mask;
+		for (; slots[i] != 0; i = (i + 1) & mask) {
+			auto j = slots[i] - 1;
+			auto n = offsets[j + 1] - offsets[j];
+			if (chars.compare(offsets[j], n, w) == 0)
+				break;
+		}
+		if (slots[i] != 0)
+			continue;
+		auto& flags = f.second->data();
+		auto id = flag_ids.emplace(flags, flag_sets.size());
+		if (id.second)
+			flag_sets.push_back(*f.second);
+		if (offsets.empty())
+			offsets.push_back(0);
+		slots[i] = offsets.size();
+		chars += w;
+		offsets.push_back(chars.size());
+		form_flags.push_back(id.first->second);
+	}
+	chars.shrink_to_fit();
+	offsets.shrink_to_fit();
+	form_flags.shrink_to_fit();
+	flag_sets.shrink_to_fit();
+}
+
+/**
+ * Looks up a form.
+ *
+ * @param form the word.
+ * @return the flags of the root of the word, or nullptr if it is not in
+ * the index.
+ */
+template <class CharT>
+auto Form_Index<CharT>::lookup(const StrT& form) const -> const Flag_Set*
+{
+	if (slots.empty())
+		return nullptr;
+	auto mask = slots.size() - 1;
+	auto i = hash_str(form.data(), form.size()) & mask;
+	for (; slots[i] != 0; i = (i + 1) & mask) {
+		auto j = slots[i] - 1;
+		auto n = offsets[j + 1] - offsets[j];
+		if (n == form.size() &&
+		    chars.compare(offsets[j], n, form) == 0)
+			return &flag_sets[form_flags[j]];
+	}
+	return nullptr;
+}
+
+template <class CharT>
+auto Form_Index<CharT>::clear() -> void
+{
+	chars.clear();
+	offsets.clear();
+	form_flags.clear();
+	flag_sets.clear();
+	slots.clear();
+}
+
+/**
+ * Gets the heap memory of the index in bytes.
+ */
+template <class CharT>
+auto Form_Index<CharT>::memory_usage() const -> size_t
+{
+	auto flags = size_t(0);
+	for (auto& f : flag_sets)
+		flags += f.data().capacity() * sizeof(char16_t);
+	return chars.capacity() * sizeof(CharT) +
+	       offsets.capacity() * sizeof(offsets[0]) +
+	       form_flags.capacity() * sizeof(form_flags[0]) +
+	       flag_sets.capacity() * sizeof(flag_sets[0]) + flags +
+	       slots.capacity() * sizeof(slots[0]);
+}
+
+template class Form_Index<char>;
+template class Form_Index<wchar_t>;
+} // namespace nuspell
@@ -0,0 +1,70 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file form_index.hxx
+ * Hash set of the expanded word forms for spelling.
+ */
+
+#ifndef NUSPELL_FORM_INDEX_HXX
+#define NUSPELL_FORM_INDEX_HXX
+
+#include "structures.hxx"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Hash set of all word forms with the flags of their roots.
+ *
+ * The forms are stored one after another and found with open addressing in
+ * a table of their numbers, which is kept at most half full. A lookup
+ * hashes the word once and usually compares it with one form. The flag sets
+ * are stored once for all forms that share them.
+ */
+template <class CharT>
+class Form_Index {
+      public:
+	using StrT = std::basic_string<CharT>;
+
+      private:
+	StrT chars;                            // the forms one after another
+	std::vector<std::uint32_t> offsets;    // where each form starts
+	std::vector<std::uint32_t> form_flags; // index of flag set of form
+	std::vector<Flag_Set> flag_sets;
+	std::vector<std::uint32_t> slots; // number of form + 1, or 0 if empty
+
+      public:
+	auto build(const std::vector<std::pair<StrT, const Flag_Set*>>& forms)
+	    -> void;
+	auto lookup(const StrT& form) const -> const Flag_Set*;
+	auto clear() -> void;
+
+	auto empty() const { return offsets.empty(); }
+	auto size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	auto memory_usage() const -> std::size_t;
+};
+extern template class Form_Index<char>;
+extern template class Form_Index<wchar_t>;
+} // namespace nuspell
+
+#endif // NUSPELL_FORM_INDEX_HXX
@@ -0,0 +1,485 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file forms.cxx
+ * Generation of the word forms of the roots.
+ */
+
+#include "dictionary.hxx"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/locale.hpp>
+
+namespace nuspell {
+
+using namespace std;
+using boost::make_iterator_range;
+
+namespace {
+
+auto encode_form(const string& form, string&) -> const string&
+{
+	return form;
+}
+
+/**
+ * @brief Converts a form to UTF-8 into a reused buffer.
+ */
+auto encode_form(const wstring& form, string& out) -> const string&
+{
+	using namespace boost::locale::utf;
+	out.clear();
+	for (auto it = begin(form); it != end(form);) {
+		auto c = utf_traits<wchar_t>::decode(it, end(form));
+		if (c != illegal && c != incomplete)
+			utf_traits<char>::encode(c, back_inserter(out));
+	}
+	return out;
+}
+
+/**
+ * @brief Generates the forms of roots in the intermediate encoding.
+ *
+ * The affixes are applied from the inner to the outer one, the opposite
+ * of the order checkword() strips them in, and a form is given if the
+ * chain of affixes passes the same checks as in the strip function of its
+ * shape. A chain with prefixes and suffixes can pass in several orders, it
+ * is given only in the order with the prefix outermost, and for three
+ * affixes with the affix of the other kind outermost.
+ *
+ * The affixes are indexed by flag once, those not valid in a full word are
+ * left out. The forms are made in one buffer, so after it has grown to the
+ * longest form no form allocates.
+ *
+ * With forbidden set, the forbidden roots are expanded too and no form is
+ * skipped for being a forbidden word.
+ */
+template <class CharT>
+class Form_Generator {
+	using StrT = basic_string<CharT>;
+	struct Step {
+		const Prefix<CharT>* prefix; // exactly one of the two is set
+		const Suffix<CharT>* suffix;
+		char16_t flag;
+		const Flag_Set* cont_flags;
+		bool cross_product;
+	};
+
+	const Dictionary& dic;
+	const Form_Callback& callback;
+	bool forbidden;
+	unordered_map<char16_t, vector<const Prefix<CharT>*>> prefixes;
+	unordered_map<char16_t, vector<const Suffix<CharT>*>> suffixes;
+
+	my_string_view<char> root;
+	const Flag_Set* root_flags = nullptr;
+	StrT root_word;
+	StrT word;         // the form being made
+	StrT scratch;      // for checking the other orders of the affixes
+	Step chain[3];     // the applied affixes, the inner one first
+	size_t length = 0; // of chain
+	vector<char16_t> candidates[3]; // the flags to try at each depth
+	string encoded;
+
+	auto has(const Step& inner, const Step& outer) const
+	{
+		return inner.cont_flags->contains(outer.flag);
+	}
+	auto in_root(const Step& x) const
+	{
+		return root_flags->contains(x.flag);
+	}
+	auto outer_ok(const Step& x) const
+	{
+		return !x.cont_flags->contains(dic.need_affix_flag);
+	}
+	auto circ(const Step& x) const
+	{
+		return x.cont_flags->contains(dic.circumfix_flag);
+	}
+	auto root_ok() const
+	{
+		return !root_flags->contains(dic.compound_onlyin_flag);
+	}
+
+	auto fits(const Step& x, const StrT& w) const -> bool;
+	auto apply(const Step& x, StrT& w) const -> void;
+	auto unapply(const Step& x, StrT& w) const -> void;
+	auto is_valid(const Step* seq, size_t n) const -> bool;
+	auto is_valid_order(const Step* seq, size_t n) -> bool;
+	auto check_and_emit() -> void;
+	auto emit(const Step* seq, size_t n) -> void;
+	auto try_step(const Step& x) -> void;
+	auto extend() -> void;
+
+      public:
+	Form_Generator(const Dictionary& dic, const Form_Callback& callback,
+	               bool forbidden = false);
+	auto generate(Dic_Data::const_reference root_entry) -> void;
+};
+
+template <class CharT>
+Form_Generator<CharT>::Form_Generator(const Dictionary& dic,
+                                      const Form_Callback& callback,
+                                      bool forbidden)
+    : dic(dic), callback(callback), forbidden(forbidden)
+{
+	auto& d = dic.get_structures<CharT>();
+	for (auto& a : d.prefixes)
+		if (!a.cont_flags.contains(dic.compound_onlyin_flag))
+			prefixes[a.flag].push_back(&a);
+	for (auto& a : d.suffixes)
+		if (!a.cont_flags.contains(dic.compound_onlyin_flag))
+			suffixes[a.flag].push_back(&a);
+}
+
+template <class CharT>
+auto Form_Generator<CharT>::fits(const Step& x, const StrT& w) const -> bool
+{
+	using boost::algorithm::ends_with;
+	using boost::algorithm::starts_with;
+	if (x.prefix)
+		return starts_with(w, x.prefix->stripping) &&
+		       x.prefix->check_condition(w);
+	return ends_with(w, x.suffix->stripping) &&
+	       x.suffix->check_condition(w);
+}
+
+template <class CharT>
+auto Form_Generator<CharT>::apply(const Step& x, StrT& w) const -> void
+{
+	if (x.prefix)
+		x.prefix->to_derived(w);
+	else
+		x.suffix->to_derived(w);
+}
+
+template <class CharT>
+auto Form_Generator<CharT>::unapply(const Step& x, StrT& w) const -> void
+{
+	if (x.prefix)
+		x.prefix->to_root(w);
+	else
+		x.suffix->to_root(w);
+}
+
+/**
+ * Checks a chain of affixes as the strip functions of checkword() do.
+ *
+ * The conditions of the affixes are not checked here.
+ *
+ * @param seq the affixes, the outer one first.
+ * @param n the number of affixes, 1 to 3.
+ */
+template <class CharT>
+auto Form_Generator<CharT>::is_valid(const Step* seq, size_t n) const -> bool
+{
+	if (n == 1) {
+		auto& a = seq[0];
+		return outer_ok(a) && !circ(a) && in_root(a) && root_ok();
+	}
+	if (n == 2) {
+		auto &o = seq[0], &i = seq[1];
+		if (!o.prefix != !i.prefix)
+			return o.cross_product && i.cross_product &&
+			       outer_ok(o) && circ(o) == circ(i) &&
+			       (has(i, o) || in_root(o)) && in_root(i) &&
+			       root_ok();
+		return outer_ok(o) && !circ(o) && has(i, o) && !circ(i) &&
+		       in_root(i);
+	}
+	// The functions for two suffixes and a prefix and for two prefixes
+	// and a suffix check the same, with the kinds swapped.
+	auto &o = seq[0], &m = seq[1], &i = seq[2];
+	auto odd = !o.prefix == !m.prefix ? 2 : !o.prefix == !i.prefix ? 1 : 0;
+	if (!outer_ok(o) || !in_root(i))
+		return false;
+	if (odd == 0)
+		return o.cross_product && m.cross_product &&
+		       circ(o) == circ(m) && has(i, m) && !circ(i) &&
+		       (has(m, o) || in_root(o));
+	auto cross_ok = has(i, o) || has(m, o);
+	auto inner_ok = has(i, m) || in_root(m);
+	if (odd == 1) {
+		auto circ1ok = circ(m) == circ(o) && !circ(i);
+		auto circ2ok = circ(m) == circ(i) && !circ(o);
+		return o.cross_product && m.cross_product && cross_ok &&
+		       (circ1ok || circ2ok) && inner_ok;
+	}
+	return !circ(o) && m.cross_product && cross_ok &&
+	       circ(m) == circ(i) && inner_ok;
+}
+
+/**
+ * Checks a chain of affixes in an order other than they were applied in.
+ *
+ * @param seq the affixes, the outer one first.
+ * @param n the number of affixes.
+ */
+template <class CharT>
+auto Form_Generator<CharT>::is_valid_order(const Step* seq, size_t n) -> bool
+{
+	scratch = root_word;
+	for (auto i = n; i-- != 0;) {
+		if (!fits(seq[i], scratch))
+			return false;
+		apply(seq[i], scratch);
+	}
+	return is_valid(seq, n);
+}
+
+template <class CharT>
+auto Form_Generator<CharT>::check_and_emit() -> void
+{
+	Step seq[3] = {};
+	for (size_t i = 0; i != length; ++i)
+		seq[i] = chain[length - 1 - i];
+	if (!is_valid(seq, length))
+		return;
+
+	// The affix of the kind that is used once, with one of each kind the
+	// prefix. If it passes also further out, the form is given there.
+	auto is_prefix = [](const Step& x) { return x.prefix != nullptr; };
+	auto prefix_count = size_t(count_if(seq, seq + length, is_prefix));
+	if (prefix_count == 0 || prefix_count == length)
+		return emit(seq, length);
+	auto k = size_t(0);
+	while (is_prefix(seq[k]) != (prefix_count == 1))
+		++k;
+	for (size_t j = 0; j != k; ++j) {
+		Step alt[3];
+		copy(seq, seq + length, alt);
+		rotate(alt + j, alt + k, alt + k + 1);
+		if (is_valid_order(alt, length))
+			return;
+	}
+	emit(seq, length);
+}
+
+/**
+ * Gives a form to the callback, unless it is a forbidden word.
+ *
+ * @param seq the affixes, the outer one first.
+ * @param n the number of affixes.
+ */
+template <class CharT>
+auto Form_Generator<CharT>::emit(const Step* seq, size_t n) -> void
+{
+	if (word.empty())
+		return;
+	auto& form = encode_form(word, encoded);
+	// checkword() takes the first homonym that can stand alone
+	auto homonyms = dic.words.equal_range(form);
+	if (forbidden)
+		homonyms.first = homonyms.second;
+	for (auto&& we : make_iterator_range(homonyms)) {
+		auto& flags = we.second;
+		if (flags.contains(dic.need_affix_flag) ||
+		    flags.contains(dic.compound_onlyin_flag))
+			continue;
+		if (flags.contains(dic.forbiddenword_flag))
+			return;
+		break;
+	}
+	auto a = Word_Analysis();
+	a.root = root;
+	a.root_flags = root_flags;
+	for (size_t i = 0; i != n; ++i) {
+		if (seq[i].prefix)
+			a.prefixes[a.prefix_count++] = seq[i].flag;
+		else
+			a.suffixes[a.suffix_count++] = seq[i].flag;
+	}
+	callback(form, a);
+}
+
+template <class CharT>
+auto Form_Generator<CharT>::try_step(const Step& x) -> void
+{
+	auto prefix_count = size_t(x.prefix != nullptr);
+	for (size_t i = 0; i != length; ++i)
+		prefix_count += chain[i].prefix != nullptr;
+	auto suffix_count = length + 1 - prefix_count;
+	// two prefixes only with COMPLEXPREFIXES, two suffixes only without
+	if (prefix_count > size_t(dic.complex_prefixes ? 2 : 1) ||
+	    suffix_count > size_t(dic.complex_prefixes ? 1 : 2))
+		return;
+	if (!fits(x, word))
+		return;
+	chain[length++] = x;
+	apply(x, word);
+	check_and_emit();
+	extend();
+	unapply(x, word);
+	--length;
+}
+
+/**
+ * Applies one more affix to the form in all possible ways.
+ *
+ * The inner affix must have a flag of the root, the outer ones a flag of
+ * the root or of the affixes inside them.
+ */
+template <class CharT>
+auto Form_Generator<CharT>::extend() -> void
+{
+	if (length == 3)
+		return;
+	auto& flags = candidates[length];
+	flags.assign(begin(*root_flags), end(*root_flags));
+	for (size_t i = 0; i != length; ++i) {
+		auto& cont = *chain[i].cont_flags;
+		flags.insert(end(flags), begin(cont), end(cont));
+	}
+	sort(begin(flags), end(flags));
+	flags.erase(unique(begin(flags), end(flags)), end(flags));
+	for (auto f : flags) {
+		auto p = prefixes.find(f);
+		if (p != end(prefixes))
+			for (auto e : p->second)
+				try_step({e, nullptr, e->flag, &e->cont_flags,
+				          e->cross_product});
+		auto s = suffixes.find(f);
+		if (s != end(suffixes))
+			for (auto e : s->second)
+				try_step({nullptr, e, e->flag, &e->cont_flags,
+				          e->cross_product});
+	}
+}
+
+/**
+ * Generates the forms of one root, the root itself first.
+ */
+template <class CharT>
+auto Form_Generator<CharT>::generate(Dic_Data::const_reference root_entry)
+    -> void
+{
+	root = root_entry.first;
+	root_flags = &root_entry.second;
+	if (!forbidden && root_flags->contains(dic.forbiddenword_flag))
+		return;
+	root_word = from_dict_to_wide_encoding<CharT>(
+	    string(root.data(), root.size()));
+	word = root_word;
+	length = 0;
+	if (!root_flags->contains(dic.need_affix_flag) && root_ok())
+		emit(chain, 0);
+	extend();
+}
+
+template <class CharT>
+auto generate_forms_of(const Dictionary& dic, const string* root,
+                       const Form_Callback& f, bool forbidden = false)
+    -> void
+{
+	auto g = Form_Generator<CharT>(dic, f, forbidden);
+	if (!root) {
+		for (auto&& w : dic.words)
+			g.generate(w);
+		return;
+	}
+	for (auto&& w : make_iterator_range(dic.words.equal_range(*root)))
+		g.generate(w);
+}
+} // namespace
+
+/**
+ * Generates all forms of a root.
+ *
+ * The forms are the root and the words made from it with up to three
+ * affixes, as far as checkword() accepts them. Compound words are not
+ * generated. Nothing is generated for a root marked as forbidden, and
+ * forms that are forbidden words are skipped.
+ *
+ * @param root the root, in the encoding of the dictionary, like
+ * Word_Analysis::root. All homonyms are expanded.
+ * @param f called with each form, in the encoding of the dictionary, and
+ * its derivation. The form is valid only during the call.
+ */
+auto Dictionary::generate_forms(const std::string& root,
+                                const Form_Callback& f) const -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		generate_forms_of<wchar_t>(*this, &root, f);
+	else
+		generate_forms_of<char>(*this, &root, f);
+}
+
+/**
+ * Generates the forms of all roots of the dictionary.
+ *
+ * This is like generate_forms() for each root, but indexes the affixes
+ * only once.
+ *
+ * @param f called with each form and its derivation.
+ */
+auto Dictionary::generate_all_forms(const Form_Callback& f) const -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		generate_forms_of<wchar_t>(*this, nullptr, f);
+	else
+		generate_forms_of<char>(*this, nullptr, f);
+}
+
+/**
+ * Builds the index of all forms for checkword().
+ *
+ * The index has the roots and all forms made from them with affixes, with
+ * the flags that checkword() returns for them without the index. With the
+ * index, checkword() looks up a word once instead of trying to strip the
+ * affixes in all ways, and tries only compounding for the words not in
+ * it. It costs memory for each form, so it pays for dictionaries with
+ * many affixes per root, for spelling of many words.
+ *
+ * The index must be built again after the words or the affixes change.
+ */
+auto Dictionary::build_form_index() -> void
+{
+	auto fill = [&](auto& index) {
+		using StrT = typename decay_t<decltype(index)>::StrT;
+		using CharT = typename StrT::value_type;
+		index.clear();
+		auto words = vector<StrT>();
+		generate_forms_of<CharT>(
+		    *this, nullptr,
+		    [&](auto& form, auto&) {
+			    words.push_back(
+			        from_dict_to_wide_encoding<CharT>(form));
+		    },
+		    true);
+		sort(begin(words), end(words));
+		words.erase(unique(begin(words), end(words)), end(words));
+		auto forms = vector<pair<StrT, const Flag_Set*>>();
+		for (auto& w : words) {
+			auto flags = check_affixed(w);
+			if (flags)
+				forms.emplace_back(move(w), flags);
+		}
+		index.build(forms);
+	};
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		fill(wide_form_index);
+	else
+		fill(form_index);
+}
+} // namespace nuspell
@@ -0,0 +1,356 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file hzip.cxx
+ * Reading of dictionary files compressed with hzip.
+ */
+
+#include "hzip.hxx"
+
+#include <algorithm>
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+const size_t in_chunk_size = 64 * 1024;
+const size_t out_chunk_size = 64 * 1024;
+const unsigned char hz_escape = 31;
+
+auto corrupted() -> ios_base::failure
+{
+	return ios_base::failure("Corrupted .hz data.");
+}
+} // namespace
+
+/**
+ * Reads the header and the Huffman codes and builds the code tree.
+ *
+ * The header of encrypted files (magic "hz1") is XORed with the cycling key,
+ * the compressed text is not.
+ *
+ * @param key key of encrypted file, ignored for plain files.
+ * @return true on success, false if the header is not valid.
+ */
+auto Hzip_Streambuf::read_code_table(const string& key) -> bool
+{
+	char magic[3];
+	if (source->sgetn(magic, 3) != 3 || magic[0] != 'h' ||
+	    magic[1] != 'z' || (magic[2] != '0' && magic[2] != '1'))
+		return false;
+	auto encrypted = magic[2] == '1';
+	if (encrypted) {
+		if (key.empty())
+			return false;
+		unsigned char sum = 0;
+		for (auto c : key)
+			sum ^= c;
+		if (source->sbumpc() != traits_type::to_int_type(sum))
+			return false;
+	}
+	size_t key_pos = 0;
+	auto read = [&](unsigned char* p, size_t n) {
+		auto s = reinterpret_cast<char*>(p);
+		if (size_t(source->sgetn(s, n)) != n)
+			return false;
+		if (encrypted)
+			for (size_t i = 0; i != n; ++i)
+				p[i] ^= key[key_pos++ % key.size()];
+		return true;
+	};
+
+	unsigned char rec[3];
+	if (!read(rec, 2))
+		return false;
+	auto n = rec[0] << 8 | rec[1];
+	if (n == 0)
+		return false;
+	nodes.assign(1, {});
+	unsigned char code[32];
+	for (int i = 0; i != n; ++i) {
+		// two bytes of the symbol, then the code length in bits
+		if (!read(rec, 3) || !read(code, rec[2] / 8 + 1))
+			return false;
+		auto p = uint32_t(0);
+		for (unsigned j = 0; j != rec[2]; ++j) {
+			if (nodes[p].is_leaf)
+				return false;
+			auto bit = code[j / 8] >> (7 - j % 8) & 1;
+			if (nodes[p].child[bit] == 0) {
+				nodes[p].child[bit] = nodes.size();
+				nodes.emplace_back();
+			}
+			p = nodes[p].child[bit];
+		}
+		auto& leaf = nodes[p];
+		if (leaf.is_leaf || leaf.child[0] || leaf.child[1])
+			return false;
+		leaf.is_leaf = true;
+		leaf.symbol[0] = rec[0];
+		leaf.symbol[1] = rec[1];
+		// the last code is the end of data
+		terminal = p;
+	}
+	return true;
+}
+
+/**
+ * Builds the table that maps the next TABLE_BITS bits to a code.
+ *
+ * The entry is either a leaf and the length of its code, or the inner node
+ * reached after TABLE_BITS bits. Bit patterns that are not a prefix of any
+ * code get length larger than any bit count, so they fail the same check as
+ * truncated data.
+ */
+auto Hzip_Streambuf::build_lookup_table() -> void
+{
+	table.resize(1u << TABLE_BITS);
+	if (nodes[0].is_leaf) {
+		// only the end of data, with code of length zero
+		fill(begin(table), end(table), Table_Entry{0, 0, true});
+		return;
+	}
+	for (uint32_t v = 0; v != table.size(); ++v) {
+		auto p = uint32_t(0);
+		auto j = 0u;
+		do {
+			p = nodes[p].child[v >> (TABLE_BITS - 1 - j) & 1];
+			++j;
+		} while (p != 0 && !nodes[p].is_leaf && j != TABLE_BITS);
+		if (p == 0)
+			table[v] = {0, 0xFF, false};
+		else
+			table[v] = {p, uint8_t(j), nodes[p].is_leaf};
+	}
+}
+
+/**
+ * Fills the bit buffer from the source up to at least 57 bits, or less at the
+ * end of the source.
+ */
+auto Hzip_Streambuf::refill() -> void
+{
+	while (bit_count <= 56) {
+		if (in_next == in_end) {
+			if (source_end)
+				return;
+			auto n = source->sgetn(in.data(), in.size());
+			if (n <= 0) {
+				source_end = true;
+				return;
+			}
+			in_next = reinterpret_cast<unsigned char*>(in.data());
+			in_end = in_next + n;
+		}
+		bit_buf |= uint64_t(*in_next++) << (56 - bit_count);
+		bit_count += 8;
+	}
+}
+
+auto Hzip_Streambuf::take_bits(unsigned n) -> void
+{
+	bit_buf <<= n;
+	bit_count -= n;
+}
+
+/**
+ * Decodes one code.
+ *
+ * @return the leaf node of the code.
+ * @throws std::ios_base::failure on invalid or truncated data.
+ */
+auto Hzip_Streambuf::decode_symbol() -> uint32_t
+{
+	if (bit_count < TABLE_BITS)
+		refill();
+	auto& e = table[bit_buf >> (64 - TABLE_BITS)];
+	if (e.bits > bit_count)
+		throw corrupted();
+	take_bits(e.bits);
+	auto p = e.node;
+	while (!nodes[p].is_leaf) {
+		if (bit_count == 0) {
+			refill();
+			if (bit_count == 0)
+				throw corrupted();
+		}
+		p = nodes[p].child[bit_buf >> 63];
+		take_bits(1);
+		if (p == 0)
+			throw corrupted();
+	}
+	return p;
+}
+
+/**
+ * Processes one byte of the prefix and suffix compressed text.
+ *
+ * Byte 31 escapes the next byte, bytes below 47 other than tab and space end
+ * the line. Bytes 33 to 46 give the length of the suffix taken from the
+ * previous line and are followed by the length of the prefix.
+ */
+auto Hzip_Streambuf::put_char(unsigned char c) -> void
+{
+	switch (text_state) {
+	case PLAIN:
+		break;
+	case ESCAPED:
+		text += c;
+		text_state = PLAIN;
+		return;
+	case PREFIX:
+		end_line(c);
+		text_state = PLAIN;
+		return;
+	}
+	if (c >= 47 || c == '\t' || c == ' ')
+		text += c;
+	else if (c == hz_escape)
+		text_state = ESCAPED;
+	else if (c > 32) {
+		suffix_size = c - 31;
+		text_state = PREFIX;
+	}
+	else
+		end_line(c);
+}
+
+/**
+ * Outputs the line made of the common prefix with the previous line, the new
+ * text and the common suffix with the previous line.
+ *
+ * @param prefix the length of the prefix, 30 stands for 9 (tab).
+ */
+auto Hzip_Streambuf::end_line(unsigned char prefix) -> void
+{
+	auto left = min<size_t>(prefix == 30 ? 9 : prefix, line.size());
+	auto right = min<size_t>(suffix_size, line.size());
+	out.append(line, 0, left);
+	out += text;
+	out.append(line, line.size() - right, right);
+	auto size = left + text.size() + right;
+	line.assign(out, out.size() - size, size);
+	out += '\n';
+	text.clear();
+	suffix_size = 0;
+}
+
+/**
+ * Decodes the next chunk of text.
+ */
+auto Hzip_Streambuf::underflow() -> int_type
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+	out.clear();
+	while (!finished && out.size() < out_chunk_size) {
+		auto p = decode_symbol();
+		auto& node = nodes[p];
+		if (p == terminal) {
+			// the end of data carries the last odd byte
+			if (node.symbol[0])
+				put_char(node.symbol[1]);
+			// the last line without new line
+			out += text;
+			text.clear();
+			finished = true;
+			break;
+		}
+		if (text_state == PLAIN && node.symbol[0] >= 47 &&
+		    node.symbol[1] >= 47) {
+			// the common case, two plain characters
+			text.append(reinterpret_cast<const char*>(node.symbol),
+			            2);
+			continue;
+		}
+		put_char(node.symbol[0]);
+		put_char(node.symbol[1]);
+	}
+	if (out.empty())
+		return traits_type::eof();
+	setg(&out[0], &out[0], &out[0] + out.size());
+	return traits_type::to_int_type(out[0]);
+}
+
+/**
+ * Starts decoding of .hz data.
+ *
+ * @param source the stream buffer with .hz data, must outlive this object.
+ * @param key the key of encrypted data.
+ * @return true if the header is valid, false otherwise.
+ */
+auto Hzip_Streambuf::open(streambuf* source, const string& key) -> bool
+{
+	setg(nullptr, nullptr, nullptr);
+	this->source = source;
+	in.resize(in_chunk_size);
+	in_next = in_end = nullptr;
+	bit_buf = 0;
+	bit_count = 0;
+	source_end = false;
+	text_state = PLAIN;
+	suffix_size = 0;
+	text.clear();
+	line.clear();
+	out.clear();
+	if (!source || !read_code_table(key)) {
+		this->source = nullptr;
+		finished = true;
+		return false;
+	}
+	build_lookup_table();
+	finished = false;
+	return true;
+}
+
+Hzip_Istream::Hzip_Istream(istream& in, const string& key) : istream(nullptr)
+{
+	init(&buf);
+	if (!buf.open(in.rdbuf(), key))
+		setstate(failbit);
+}
+
+Hzip_Istream::Hzip_Istream(const string& file_name, const string& key)
+    : istream(nullptr)
+{
+	init(&buf);
+	if (!file.open(file_name, ios_base::in | ios_base::binary) ||
+	    !buf.open(&file, key))
+		setstate(failbit);
+}
+
+/**
+ * Opens a file, or the same file compressed with hzip if it does not exist.
+ *
+ * @param file_name path of the uncompressed file.
+ * @return the stream of file_name, or of file_name + ".hz" if only that
+ * exists. The stream is in failed state if neither can be opened.
+ */
+auto open_possibly_hzipped(const string& file_name) -> unique_ptr<istream>
+{
+	auto file = unique_ptr<istream>(new ifstream(file_name));
+	if (file->fail()) {
+		auto hz_file = make_unique<Hzip_Istream>(file_name + ".hz");
+		if (!hz_file->fail())
+			return hz_file;
+	}
+	return file;
+}
+} // namespace nuspell
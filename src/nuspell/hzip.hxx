@@ -0,0 +1,123 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file hzip.hxx
+ * Reading of dictionary files compressed with hzip.
+ */
+
+#ifndef NUSPELL_HZIP_HXX
+#define NUSPELL_HZIP_HXX
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Stream buffer that decompresses .hz data from another stream buffer.
+ *
+ * The .hz format is Huffman coding of byte pairs over a prefix and suffix
+ * compression of the lines. The codes are decoded with a lookup table that
+ * consumes up to TABLE_BITS bits at once, only longer codes continue bit by
+ * bit in the code tree.
+ *
+ * Corrupted data is reported by throwing std::ios_base::failure from
+ * underflow(), which istream functions turn into badbit. Code that reads
+ * the buffer directly, e.g. with std::istreambuf_iterator, gets the
+ * exception and must catch it, as Aff_Data::parse_dic() does.
+ */
+class Hzip_Streambuf : public std::streambuf {
+      public:
+	enum : unsigned { TABLE_BITS = 10 };
+
+      private:
+	struct Node {
+		std::uint32_t child[2];
+		unsigned char symbol[2];
+		bool is_leaf;
+	};
+	struct Table_Entry {
+		std::uint32_t node;
+		std::uint8_t bits;
+		bool is_leaf;
+	};
+	enum Text_State : unsigned char { PLAIN, ESCAPED, PREFIX };
+
+	std::streambuf* source = nullptr;
+	std::vector<Node> nodes;
+	std::uint32_t terminal = 0;
+	std::vector<Table_Entry> table;
+
+	std::vector<char> in;
+	const unsigned char* in_next = nullptr;
+	const unsigned char* in_end = nullptr;
+	std::uint64_t bit_buf = 0;
+	unsigned bit_count = 0;
+	bool source_end = false;
+	bool finished = true;
+
+	Text_State text_state = PLAIN;
+	unsigned suffix_size = 0;
+	std::string text;
+	std::string line;
+	std::string out;
+
+	auto read_code_table(const std::string& key) -> bool;
+	auto build_lookup_table() -> void;
+	auto refill() -> void;
+	auto take_bits(unsigned n) -> void;
+	auto decode_symbol() -> std::uint32_t;
+	auto put_char(unsigned char c) -> void;
+	auto end_line(unsigned char prefix) -> void;
+
+      protected:
+	auto underflow() -> int_type override;
+
+      public:
+	Hzip_Streambuf() = default;
+	auto open(std::streambuf* source, const std::string& key = "") -> bool;
+	auto is_open() const { return source != nullptr; }
+};
+
+/**
+ * @brief Input stream that reads .hz file or .hz data from another stream.
+ *
+ * Fails on construction if the file can not be opened, if the header is not
+ * valid or if the key does not match an encrypted file.
+ */
+class Hzip_Istream : public std::istream {
+	std::filebuf file;
+	Hzip_Streambuf buf;
+
+      public:
+	explicit Hzip_Istream(std::istream& in, const std::string& key = "");
+	explicit Hzip_Istream(const std::string& file_name,
+	                      const std::string& key = "");
+};
+
+auto open_possibly_hzipped(const std::string& file_name)
+    -> std::unique_ptr<std::istream>;
+} // namespace nuspell
+
+#endif // NUSPELL_HZIP_HXX
@@ -0,0 +1,47 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file load_stats.cxx
+ * Instrumentation of dictionary loading.
+ */
+
+#include "load_stats.hxx"
+
+namespace nuspell {
+
+namespace {
+thread_local Load_Stats* current_load_stats = nullptr;
+}
+
+/**
+ * Enables or disables collecting of load statistics in the calling thread.
+ *
+ * When disabled, the loading functions only check for it once per phase.
+ *
+ * @param stats object where to add the statistics, nullptr disables.
+ */
+auto set_load_stats(Load_Stats* stats) -> void { current_load_stats = stats; }
+
+/**
+ * Gets the object where the load statistics of the calling thread go.
+ *
+ * @return the object set with set_load_stats(), or nullptr if disabled.
+ */
+auto get_load_stats() -> Load_Stats* { return current_load_stats; }
+} // namespace nuspell
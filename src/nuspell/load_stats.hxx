@@ -0,0 +1,102 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file load_stats.hxx
+ * Instrumentation of dictionary loading.
+ */
+
+#ifndef NUSPELL_LOAD_STATS_HXX
+#define NUSPELL_LOAD_STATS_HXX
+
+#include <chrono>
+#include <cstddef>
+
+namespace nuspell {
+
+/**
+ * @brief Timings and counts of the phases of dictionary loading.
+ *
+ * Collected only while enabled with set_load_stats() in the loading thread.
+ * Times are in seconds. The values add up over repeated loads, except the
+ * final table sizes which are of the last load.
+ */
+struct Load_Stats {
+	// Aff_Data::parse_aff()
+	double aff_seconds = 0;
+	double aff_structures_seconds = 0; // part of aff_seconds
+	size_t aff_lines = 0;
+	size_t prefixes = 0;
+	size_t suffixes = 0;
+	size_t flag_aliases = 0;
+
+	// install_ctype_facets_inplace()
+	double ctype_facets_seconds = 0;
+	size_t ctype_facets_installed = 0;
+
+	// Aff_Data::parse_dic() and Aff_Data::parse_dic_lazy()
+	double dic_seconds = 0;
+	double dic_read_seconds = 0; // part of dic_seconds
+	size_t dic_lines = 0;
+	size_t words_inserted = 0;
+	size_t hidden_homonyms = 0;
+	size_t dic_bytes = 0; // estimate of the heap memory of the words
+	size_t word_count = 0;
+	size_t word_buckets = 0;
+
+	// Finder::search_dictionaries()
+	double search_seconds = 0;
+	size_t search_paths = 0;
+	size_t dictionaries_found = 0;
+};
+
+auto set_load_stats(Load_Stats* stats) -> void;
+auto get_load_stats() -> Load_Stats*;
+
+/**
+ * @brief Adds the time of its scope to a counter, if there is one.
+ *
+ * Does not read the clock when constructed with nullptr. Can be stopped
+ * before the end of the scope.
+ */
+class Load_Timer {
+	using clock = std::chrono::steady_clock;
+	double* seconds;
+	clock::time_point start;
+
+      public:
+	explicit Load_Timer(double* seconds) : seconds(seconds)
+	{
+		if (seconds)
+			start = clock::now();
+	}
+	Load_Timer(const Load_Timer&) = delete;
+	auto operator=(const Load_Timer&) -> Load_Timer& = delete;
+	~Load_Timer() { stop(); }
+	auto stop() -> void
+	{
+		if (!seconds)
+			return;
+		auto d = std::chrono::duration<double>(clock::now() - start);
+		*seconds += d.count();
+		seconds = nullptr;
+	}
+};
+} // namespace nuspell
+
+#endif // NUSPELL_LOAD_STATS_HXX
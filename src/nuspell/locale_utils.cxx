@@ -22,15 +22,22 @@
  */
 
 #include "locale_utils.hxx"
+#include "load_stats.hxx"
 
 #include <algorithm>
+#include <array>
 #include <limits>
+#include <map>
+#include <tuple>
+#include <vector>
 
 #include <boost/locale.hpp>
 
 #include <unicode/uchar.h>
+#include <unicode/ucasemap.h>
 #include <unicode/ucnv.h>
 #include <unicode/unistr.h>
+#include <unicode/ustring.h>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -257,10 +264,13 @@ auto decode_utf8(const std::string& s) -> std::u32string
 }
 
 auto validate_utf8(const std::string& s) -> bool
+{
+	return validate_utf8(s.data(), s.data() + s.size());
+}
+
+auto validate_utf8(const char* first, const char* last) -> bool
 {
 	using namespace boost::locale::utf;
-	auto first = begin(s);
-	auto last = end(s);
 	while (first != last) {
 		auto cp = utf_traits<char>::decode(first, last);
 		if (unlikely(cp == incomplete || cp == illegal))
@@ -519,6 +529,161 @@ auto general_category_to_ctype_mask(UCharCategory cat) -> ctype_base::mask
 	return {};
 }
 
+namespace {
+/**
+ * @brief Properties of a single BMP code point.
+ *
+ * The simple case mappings are stored as differences to the code point
+ * (modulo 2^16). That way whole blocks of characters, e.g. the uncased ones or
+ * alternating upper/lower ones, have equal properties and can be shared.
+ */
+struct Bmp_Char_Props {
+	char16_t upper_delta;
+	char16_t lower_delta;
+	char16_t title_delta;
+	ctype_base::mask mask;
+	unsigned char category; /**< the UCharCategory */
+	bool special_casing; /**< full case mapping differs from the simple */
+
+	auto as_tuple() const
+	{
+		return make_tuple(upper_delta, lower_delta, title_delta, mask,
+		                  category, special_casing);
+	}
+	auto operator<(const Bmp_Char_Props& other) const
+	{
+		return as_tuple() < other.as_tuple();
+	}
+};
+
+/**
+ * @brief Two-level lookup table of the properties of the BMP code points.
+ *
+ * The first level is indexed with the high byte of the code point and gives a
+ * block. The second level is indexed by the block and the low byte and gives
+ * an index in the array of distinct properties. Equal blocks are stored once.
+ */
+class Bmp_Char_Table {
+	array<uint16_t, 256> block_of;
+	vector<uint16_t> blocks;
+	vector<Bmp_Char_Props> props;
+
+      public:
+	Bmp_Char_Table();
+	auto& get(char16_t cp) const
+	{
+		return props[blocks[block_of[cp >> 8] << 8 | (cp & 0xFF)]];
+	}
+};
+
+auto get_bmp_char_props(UChar32 cp, UCaseMap* title_map) -> Bmp_Char_Props
+{
+	auto ret = Bmp_Char_Props();
+	auto special = false;
+	auto to_delta = [&](UChar32 mapped) -> char16_t {
+		if (mapped > 0xFFFF) {
+			special = true;
+			return 0;
+		}
+		return mapped - cp;
+	};
+	auto upper = u_toupper(cp);
+	auto lower = u_tolower(cp);
+	auto title = u_totitle(cp);
+	ret.upper_delta = to_delta(upper);
+	ret.lower_delta = to_delta(lower);
+	ret.title_delta = to_delta(title);
+	ret.mask = get_char_mask(cp);
+	ret.category = u_charType(cp);
+
+	if (U_IS_SURROGATE(cp)) {
+		special = true;
+	}
+	else if (u_hasBinaryProperty(cp, UCHAR_CHANGES_WHEN_CASEMAPPED)) {
+		// Compare with the full case mapping of the code point alone.
+		// E.g. sharp s has no simple upper case mapping, but has full
+		// mapping to SS.
+		UChar src = cp;
+		UChar dst[8];
+		auto err = U_ZERO_ERROR;
+		auto len = u_strToUpper(dst, 8, &src, 1, "", &err);
+		if (U_FAILURE(err) || len != 1 || dst[0] != upper)
+			special = true;
+		err = U_ZERO_ERROR;
+		len = u_strToLower(dst, 8, &src, 1, "", &err);
+		if (U_FAILURE(err) || len != 1 || dst[0] != lower)
+			special = true;
+		err = U_ZERO_ERROR;
+		len = ucasemap_toTitle(title_map, dst, 8, &src, 1, &err);
+		if (U_FAILURE(err) || len != 1 || dst[0] != title)
+			special = true;
+	}
+	// The lower case of capital sigma depends on the context, final sigma.
+	if (cp == 0x03A3)
+		special = true;
+	ret.special_casing = special;
+	return ret;
+}
+
+Bmp_Char_Table::Bmp_Char_Table()
+{
+	auto err = U_ZERO_ERROR;
+	auto title_map = ucasemap_open("", 0, &err);
+	auto prop_idx = map<Bmp_Char_Props, uint16_t>();
+	auto block_idx = map<vector<uint16_t>, uint16_t>();
+	auto block = vector<uint16_t>(256);
+	for (UChar32 hi = 0; hi != 256; ++hi) {
+		for (UChar32 lo = 0; lo != 256; ++lo) {
+			auto p = get_bmp_char_props(hi << 8 | lo, title_map);
+			auto ins = prop_idx.emplace(p, props.size());
+			if (ins.second)
+				props.push_back(p);
+			block[lo] = ins.first->second;
+		}
+		auto ins = block_idx.emplace(block, block_idx.size());
+		if (ins.second)
+			blocks.insert(end(blocks), begin(block), end(block));
+		block_of[hi] = ins.first->second;
+	}
+	ucasemap_close(title_map);
+}
+
+auto get_bmp_char_table() -> const Bmp_Char_Table&
+{
+	static const auto table = Bmp_Char_Table();
+	return table;
+}
+
+auto is_bmp_char(wchar_t c) { return static_cast<char32_t>(c) <= 0xFFFF; }
+
+auto char_mask(wchar_t c)
+{
+	if (likely(is_bmp_char(c)))
+		return get_bmp_char_table().get(c).mask;
+	return get_char_mask(c);
+}
+
+auto simple_toupper(wchar_t c) -> wchar_t
+{
+	if (likely(is_bmp_char(c))) {
+		auto& p = get_bmp_char_table().get(c);
+		if (!p.special_casing)
+			return static_cast<char16_t>(c + p.upper_delta);
+	}
+	return u_toupper(c);
+}
+
+auto simple_tolower(wchar_t c) -> wchar_t
+{
+	if (likely(is_bmp_char(c))) {
+		auto& p = get_bmp_char_table().get(c);
+		if (!p.special_casing)
+			return static_cast<char16_t>(c + p.lower_delta);
+	}
+	return u_tolower(c);
+}
+} // namespace
+
 auto fill_ctype(const string& enc, ctype_base::mask* m, char* upper,
                 char* lower)
 {
@@ -626,40 +791,13 @@ class icu_ctype_wide final : public std::ctype<wchar_t> {
 
 	virtual bool do_is(mask m, char_type c) const
 	{
-		if ((m & space) && u_isspace(c))
-			return true;
-		if ((m & print) && u_isprint(c))
-			return true;
-		if ((m & cntrl) && u_iscntrl(c))
-			return true;
-		if ((m & upper) && u_isupper(c))
-			return true;
-		if ((m & lower) && u_islower(c))
-			return true;
-		if ((m & alpha) && u_isalpha(c))
-			return true;
-		if ((m & digit) && u_isdigit(c))
-			return true;
-		if ((m & punct) && u_ispunct(c))
-			return true;
-		if ((m & xdigit) && u_isxdigit(c))
-			return true;
-		if ((m & blank) && u_isblank(c))
-			return true;
-
-		// don't uncoment this
-		// if ((m & alnum) && u_isalnum(c))
-		//	return true;
-		// if ((m & graph) && u_isgraph(c))
-		//	return true;
-
-		return false;
+		return char_mask(c) & m;
 	}
 	virtual const char_type* do_is(const char_type* first,
 	                               const char_type* last, mask* vec) const
 	{
 		std::transform(first, last, vec,
-		               [&](auto c) { return get_char_mask(c); });
+		               [&](auto c) { return char_mask(c); });
 		return last;
 	}
 	virtual const char_type* do_scan_is(mask m, const char_type* first,
@@ -675,21 +813,27 @@ class icu_ctype_wide final : public std::ctype<wchar_t> {
 		                        [&](auto c) { return do_is(m, c); });
 	}
 
-	virtual char_type do_toupper(char_type c) const { return u_toupper(c); }
+	virtual char_type do_toupper(char_type c) const
+	{
+		return simple_toupper(c);
+	}
 	virtual const char_type* do_toupper(char_type* low,
 	                                    const char_type* high) const
 	{
 		for (; low != high; ++low) {
-			*low = u_toupper(*low);
+			*low = simple_toupper(*low);
 		}
 		return high;
 	}
-	virtual char_type do_tolower(char_type c) const { return u_tolower(c); }
+	virtual char_type do_tolower(char_type c) const
+	{
+		return simple_tolower(c);
+	}
 	virtual const char_type* do_tolower(char_type* first,
 	                                    const char_type* last) const
 	{
 		for (; first != last; ++first) {
-			*first = u_tolower(*first);
+			*first = simple_tolower(*first);
 		}
 		return last;
 	}
@@ -722,13 +866,191 @@ class icu_ctype_wide final : public std::ctype<wchar_t> {
 	}
 };
 
+/**
+ * Replaces the ctype facets of the locale with ones backed by ICU.
+ *
+ * Adds its time to the Load_Stats of the thread, if enabled.
+ *
+ * @param boost_loc locale generated by Boost.Locale.
+ */
 auto install_ctype_facets_inplace(std::locale& boost_loc) -> void
 {
-
+	auto stats = get_load_stats();
+	Load_Timer timer(stats ? &stats->ctype_facets_seconds : nullptr);
+	if (stats)
+		stats->ctype_facets_installed++;
 	auto& info = use_facet<boost::locale::info>(boost_loc);
 	auto enc = info.encoding();
 	boost_loc = locale(boost_loc, new icu_ctype_char(enc));
 	boost_loc = locale(boost_loc, new icu_ctype_wide(enc));
 }
+
+namespace {
+/**
+ * @brief Checks if the language of the locale has language-specific casing.
+ *
+ * For these languages, e.g. Turkish dotted and dotless i, the precomputed
+ * tables can not be used and the casing is done by Boost.Locale.
+ */
+auto has_special_casing_rules(const std::locale& loc)
+{
+	if (!has_facet<boost::locale::info>(loc))
+		return true;
+	auto lang = use_facet<boost::locale::info>(loc).language();
+	return lang == "tr" || lang == "az" || lang == "lt" || lang == "el" ||
+	       lang == "nl" || lang == "hy";
+}
+
+/**
+ * @brief Maps the case of a range of wide characters with the BMP table.
+ *
+ * @param get_delta function that returns the delta of the wanted mapping
+ * @return false if some character needs full case mapping, in which case the
+ * range is partially modified.
+ */
+template <class It, class Func>
+auto map_case_with_table(It first, It last, Func get_delta) -> bool
+{
+	auto& table = get_bmp_char_table();
+	for (; first != last; ++first) {
+		auto c = *first;
+		if (unlikely(!is_bmp_char(c)))
+			return false;
+		auto& p = table.get(c);
+		if (unlikely(p.special_casing))
+			return false;
+		*first = static_cast<char16_t>(c + get_delta(p));
+	}
+	return true;
+}
+
+auto upper_delta(const Bmp_Char_Props& p) { return p.upper_delta; }
+auto lower_delta(const Bmp_Char_Props& p) { return p.lower_delta; }
+auto title_delta(const Bmp_Char_Props& p) { return p.title_delta; }
+
+auto is_cased_letter(unsigned char cat)
+{
+	return cat == U_UPPERCASE_LETTER || cat == U_LOWERCASE_LETTER ||
+	       cat == U_TITLECASE_LETTER;
+}
+
+/**
+ * @brief Checks if the title casing of a word can be done by characters.
+ *
+ * Boost.Locale title cases each word found by the word break iterator, so the
+ * simple mapping is equivalent only if the whole string is one word that
+ * starts with a cased letter.
+ */
+auto is_simple_title_word(const wstring& s)
+{
+	auto& table = get_bmp_char_table();
+	if (!is_bmp_char(s[0]) || !is_cased_letter(table.get(s[0]).category))
+		return false;
+	return all_of(begin(s) + 1, end(s), [&](wchar_t c) {
+		if (!is_bmp_char(c))
+			return false;
+		auto cat = table.get(c).category;
+		return is_cased_letter(cat) || cat == U_MODIFIER_LETTER ||
+		       cat == U_NON_SPACING_MARK ||
+		       cat == U_COMBINING_SPACING_MARK ||
+		       cat == U_ENCLOSING_MARK;
+	});
+}
+
+auto is_utf8_locale(const std::locale& loc)
+{
+	return has_facet<boost::locale::info>(loc) &&
+	       use_facet<boost::locale::info>(loc).utf8();
+}
+} // namespace
+
+/**
+ * @brief Converts string to upper case.
+ *
+ * Uses the precomputed BMP tables when possible, otherwise falls back to
+ * Boost.Locale.
+ *
+ * @param s string to convert.
+ * @param loc locale used for the conversion.
+ * @return the upper cased string.
+ */
+auto to_upper(const std::wstring& s, const std::locale& loc) -> std::wstring
+{
+	if (!has_special_casing_rules(loc)) {
+		auto ret = s;
+		if (map_case_with_table(begin(ret), end(ret), upper_delta))
+			return ret;
+	}
+	return boost::locale::to_upper(s, loc);
+}
+
+/**
+ * @brief Converts string to title case.
+ *
+ * The first letter is converted to title case and the rest to lower case.
+ * Uses the precomputed BMP tables when possible, otherwise falls back to
+ * Boost.Locale.
+ *
+ * @param s string to convert.
+ * @param loc locale used for the conversion.
+ * @return the title cased string.
+ */
+auto to_title(const std::wstring& s, const std::locale& loc) -> std::wstring
+{
+	if (s.empty())
+		return s;
+	if (!has_special_casing_rules(loc) && is_simple_title_word(s)) {
+		auto ret = s;
+		if (map_case_with_table(begin(ret), begin(ret) + 1,
+		                        title_delta) &&
+		    map_case_with_table(begin(ret) + 1, end(ret), lower_delta))
+			return ret;
+	}
+	return boost::locale::to_title(s, loc);
+}
+
+/**
+ * @brief Converts string to lower case.
+ *
+ * Uses the precomputed BMP tables when possible, otherwise falls back to
+ * Boost.Locale.
+ *
+ * @param s string to convert.
+ * @param loc locale used for the conversion.
+ * @return the lower cased string.
+ */
+auto to_lower(const std::wstring& s, const std::locale& loc) -> std::wstring
+{
+	if (!has_special_casing_rules(loc)) {
+		auto ret = s;
+		if (map_case_with_table(begin(ret), end(ret), lower_delta))
+			return ret;
+	}
+	return boost::locale::to_lower(s, loc);
+}
+
+auto to_upper(const std::string& s, const std::locale& loc) -> std::string
+{
+	using namespace boost::locale::conv;
+	if (is_utf8_locale(loc))
+		return utf_to_utf<char>(to_upper(utf_to_utf<wchar_t>(s), loc));
+	return boost::locale::to_upper(s, loc);
+}
+
+auto to_title(const std::string& s, const std::locale& loc) -> std::string
+{
+	using namespace boost::locale::conv;
+	if (is_utf8_locale(loc))
+		return utf_to_utf<char>(to_title(utf_to_utf<wchar_t>(s), loc));
+	return boost::locale::to_title(s, loc);
+}
+
+auto to_lower(const std::string& s, const std::locale& loc) -> std::string
+{
+	using namespace boost::locale::conv;
+	if (is_utf8_locale(loc))
+		return utf_to_utf<char>(to_lower(utf_to_utf<wchar_t>(s), loc));
+	return boost::locale::to_lower(s, loc);
+}
 } // namespace encoding
 } // namespace nuspell
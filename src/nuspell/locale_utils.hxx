@@ -60,6 +60,7 @@ inline namespace encoding {
 
 auto decode_utf8(const std::string& s) -> std::u32string;
 auto validate_utf8(const std::string& s) -> bool;
+auto validate_utf8(const char* first, const char* last) -> bool;
 
 auto is_ascii(char c) -> bool;
 auto is_all_ascii(const std::string& s) -> bool;
@@ -79,6 +80,13 @@ auto to_narrow(const std::wstring& in, const std::locale& outloc)
 
 auto install_ctype_facets_inplace(std::locale& boost_loc) -> void;
 
+auto to_upper(const std::string& s, const std::locale& loc) -> std::string;
+auto to_upper(const std::wstring& s, const std::locale& loc) -> std::wstring;
+auto to_title(const std::string& s, const std::locale& loc) -> std::string;
+auto to_title(const std::wstring& s, const std::locale& loc) -> std::wstring;
+auto to_lower(const std::string& s, const std::locale& loc) -> std::string;
+auto to_lower(const std::wstring& s, const std::locale& loc) -> std::wstring;
+
 // put template function definitions bellow the declarations above
 // otherwise doxygen has bugs when generating call graphs
 
@@ -161,6 +169,51 @@ auto inline Locale_Input::cvt_for_u8_dict(const std::string& in,
 	return to_wide(in, inloc);
 }
 
+/**
+ * @brief Converts from intermediate into output encoding.
+ *
+ * The reverse of Locale_Input, used for strings that the library returns,
+ * like suggestions.
+ */
+struct Locale_Output {
+	auto static cvt_from_byte_dict(const std::string& in,
+	                               const std::locale& outloc,
+	                               const std::locale& dicloc)
+	    -> std::string;
+	auto static cvt_from_u8_dict(const std::wstring& in,
+	                             const std::locale& outloc) -> std::string;
+};
+
+auto inline Locale_Output::cvt_from_byte_dict(const std::string& in,
+                                              const std::locale& outloc,
+                                              const std::locale& dicloc)
+    -> std::string
+{
+	using namespace std;
+	using info_t = boost::locale::info;
+	if (has_facet<info_t>(outloc)) {
+		auto& out_info = use_facet<info_t>(outloc);
+		auto& dic_info = use_facet<info_t>(dicloc);
+		if (out_info.encoding() == dic_info.encoding())
+			return in;
+	}
+	return to_narrow(to_wide(in, dicloc), outloc);
+}
+
+auto inline Locale_Output::cvt_from_u8_dict(const std::wstring& in,
+                                            const std::locale& outloc)
+    -> std::string
+{
+	using namespace std;
+	using info_t = boost::locale::info;
+	using namespace boost::locale::conv;
+	if (has_facet<info_t>(outloc)) {
+		if (use_facet<info_t>(outloc).utf8())
+			return utf_to_utf<char>(in);
+	}
+	return to_narrow(in, outloc);
+}
+
 template <class CharT>
 struct Unicode_Input {
 	auto static cvt_for_byte_dict(const std::basic_string<CharT>& in,
@@ -23,6 +23,7 @@
 
 #include "dictionary.hxx"
 #include "finder.hxx"
+#include "load_stats.hxx"
 #include "string_utils.hxx"
 #include <clocale>
 #include <fstream>
@@ -31,6 +32,7 @@
 #include <string>
 #include <unordered_map>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/locale.hpp>
 
 #ifdef HAVE_CONFIG_H
@@ -77,6 +79,7 @@ struct Args_t {
 	string program_name = PACKAGE;
 	string dictionary;
 	string encoding;
+	bool stats = false;
 	vector<string> other_dicts;
 	vector<string> files;
 
@@ -103,9 +106,12 @@ auto Args_t::parse_args(int argc, char* argv[]) -> void
 	// The program can run in various modes depending on the
 	// command line options. mode is FSM state, this while loop is FSM.
 	const char* shortopts = ":d:i:DGLUlhv";
+	// long options without short one get values above char
+	enum { STATS_OPTION = 256 };
 	const struct option longopts[] = {
 	    {"version", 0, 0, 'v'},
 	    {"help", 0, 0, 'h'},
+	    {"stats", 0, 0, STATS_OPTION},
 	    {nullptr, 0, 0, 0},
 	};
 	while ((c = getopt_long(argc, argv, shortopts, longopts, nullptr)) !=
@@ -181,6 +187,10 @@ auto Args_t::parse_args(int argc, char* argv[]) -> void
 			else
 				mode = ERROR_MODE;
 
+			break;
+		case STATS_OPTION:
+			stats = true;
+
 			break;
 		case ':':
 			cerr << "Option -" << (char)optopt
@@ -222,13 +232,18 @@ auto print_help(const string& program_name) -> void
 	     "input.\n"
 	     "\n"
 	     "  -d di_CT      use di_CT dictionary. Only one dictionary is\n"
-	     "                currently supported\n"
+	     "                currently supported. A path ending with .cdic\n"
+	     "                is loaded as compiled dictionary. The .aff and\n"
+	     "                .dic files can be compressed with hzip\n"
 	     "  -D            show available dictionaries and exit\n"
 	     "  -i enc        input encoding, default is active locale\n"
 	     "  -l            print only misspelled words or lines\n"
 	     "  -G            print only correct words or lines\n"
 	     "  -L            lines mode\n"
 	     "  -U            do not suggest, increases performance\n"
+	     "  --stats       print timings and counts of the loading of\n"
+	     "                the dictionary and of the checking of words\n"
+	     "                to standard error\n"
 	     "  -h, --help    display this help and exit\n"
 	     "  -v, --version print version number and exit\n"
 	     "\n";
@@ -258,6 +273,77 @@ auto print_version() -> void
 	    "see https://github.com/hunspell/nuspell/blob/master/AUTHORS\n";
 }
 
+/**
+ * Prints the load statistics to standard error.
+ *
+ * @param s the statistics.
+ */
+auto print_load_stats(const Load_Stats& s) -> void
+{
+	auto& o = cerr;
+	o << "STATS: search dictionaries: " << s.search_seconds << " s, "
+	  << s.search_paths << " paths, " << s.dictionaries_found
+	  << " dictionaries\n";
+	o << "STATS: ctype facets: " << s.ctype_facets_seconds << " s, "
+	  << s.ctype_facets_installed << " installed\n";
+	o << "STATS: parse aff: " << s.aff_seconds << " s, of it structures "
+	  << s.aff_structures_seconds << " s, " << s.aff_lines << " lines, "
+	  << s.prefixes << " prefixes, " << s.suffixes << " suffixes, "
+	  << s.flag_aliases << " flag aliases\n";
+	o << "STATS: parse dic: " << s.dic_seconds << " s, of it reading "
+	  << s.dic_read_seconds << " s, " << s.dic_lines << " lines, "
+	  << s.words_inserted << " words inserted, " << s.hidden_homonyms
+	  << " hidden homonyms\n";
+	o << "STATS: word list: " << s.word_count << " words, "
+	  << s.word_buckets << " buckets, about " << s.dic_bytes
+	  << " bytes\n";
+}
+
+/**
+ * Prints the memory usage of the dictionary to standard error.
+ *
+ * @param m the memory usage.
+ */
+auto print_memory_usage(const Memory_Usage& m) -> void
+{
+	auto& o = cerr;
+	o << "STATS: memory of words: " << m.word_buckets << " buckets, "
+	  << m.word_nodes << " nodes, " << m.word_strings << " strings, "
+	  << m.word_flag_sets << " flag sets, " << m.word_index
+	  << " index bytes\n";
+	o << "STATS: memory of affixes: " << m.prefixes << " prefixes, "
+	  << m.suffixes << " suffixes, " << m.conditions << " conditions, "
+	  << m.substr_replacers << " ICONV/OCONV, " << m.break_tables
+	  << " BREAK, " << m.flag_aliases << " flag aliases, " << m.other
+	  << " other bytes\n";
+	o << "STATS: memory total: " << m.total() << " bytes, "
+	  << m.flag_sets << " flag sets, " << m.distinct_flag_sets
+	  << " distinct\n";
+}
+
+/**
+ * Prints the counters of the stages of checking words to standard error.
+ *
+ * @param s the counters.
+ */
+auto print_checkword_stats(const Checkword_Stats& s) -> void
+{
+	auto& o = cerr;
+	o << "STATS: checkword: " << s.calls << " calls, " << s.misses
+	  << " misses\n";
+	for (size_t i = 0; i != CHECKWORD_STAGES; ++i) {
+		auto& st = s.stages[i];
+		if (st.calls == 0)
+			continue;
+		o << "STATS: checkword stage "
+		  << checkword_stage_name(Checkword_Stage(i)) << ": "
+		  << st.calls << " calls, " << st.accepted << " accepted, "
+		  << st.affix_candidates << " affix candidates, "
+		  << st.dictionary_probes << " probes, " << st.seconds
+		  << " s\n";
+	}
+}
+
 /**
  * Lists dictionary paths and available dictionaries on the system to standard
  * output.
@@ -336,6 +422,43 @@ auto normal_loop(istream& in, ostream& out, Dictionary& dic)
 	}
 }
 
+/**
+ * Loop that checks spelling and suggests corrections.
+ *
+ * Like normal_loop(), but a misspelled word is reported in the format of
+ * Ispell, "& word count 0: suggestion, ..." or "# word 0" if there are no
+ * suggestions.
+ *
+ * @param in the input stream to check spelling for with a word on each line.
+ * @param out the output stream to report spelling correctness on the respective
+ * lines.
+ * @param dic the dictionary to use.
+ */
+auto suggest_loop(istream& in, ostream& out, Dictionary& dic)
+{
+	auto word = string();
+	auto sugs = vector<string>();
+	while (in >> word) {
+		auto res = dic.spell(word, in.getloc());
+		if (res != BAD_WORD) {
+			out << '*' << '\n';
+			continue;
+		}
+		dic.suggest(word, sugs, in.getloc());
+		if (sugs.empty()) {
+			out << "# " << word << " 0\n";
+			continue;
+		}
+		out << "& " << word << ' ' << sugs.size() << " 0: ";
+		for (size_t i = 0; i != sugs.size(); ++i) {
+			if (i != 0)
+				out << ", ";
+			out << sugs[i];
+		}
+		out << '\n';
+	}
+}
+
 /**
  * Prints misspelled words from an input stream to an output stream.
  *
@@ -427,6 +550,9 @@ int main(int argc, char* argv[])
 		     << args.program_name << " --help' for more information\n";
 		return 1;
 	}
+	auto load_stats = Load_Stats();
+	if (args.stats)
+		set_load_stats(&load_stats);
 	boost::locale::generator gen;
 	auto loc = gen("");
 	install_ctype_facets_inplace(loc);
@@ -497,23 +623,36 @@ int main(int argc, char* argv[])
 
 		return 1;
 	}
-	clog << "INFO: Pointed dictionary " << filename << ".{dic,aff}\n";
+	auto compiled = boost::algorithm::ends_with(filename, ".cdic");
+	if (compiled)
+		clog << "INFO: Pointed dictionary " << filename << '\n';
+	else
+		clog << "INFO: Pointed dictionary " << filename
+		     << ".{dic,aff}\n";
 	auto dic = Dictionary();
 	try {
-		dic = Dictionary::load_from_aff_dic(filename);
+		if (compiled)
+			dic = Dictionary::load_from_compiled(filename);
+		else
+			dic = Dictionary::load_from_aff_dic(filename);
 	}
 	catch (const std::ios_base::failure& e) {
 		cerr << e.what() << '\n';
 		return 1;
 	}
+	if (args.stats) {
+		set_load_stats(nullptr);
+		print_load_stats(load_stats);
+		print_memory_usage(dic.memory_usage());
+		dic.enable_checkword_stats();
+	}
 	auto loop_function = normal_loop;
 	switch (args.mode) {
 	case DEFAULT_MODE:
-		// loop_function = normal_loop;
+		loop_function = suggest_loop;
 		break;
 	case NO_SUGGEST_MODE:
-		// This will differ from normal loop once suggestion has been
-		// implemented. loop_function = normal_loop;
+		// loop_function = normal_loop;
 		break;
 	case MISSPELLED_WORDS_MODE:
 		loop_function = misspelled_word_loop;
@@ -545,5 +684,7 @@ int main(int argc, char* argv[])
 			loop_function(in, cout, dic);
 		}
 	}
+	if (args.stats)
+		print_checkword_stats(*dic.get_checkword_stats());
 	return 0;
 }
@@ -0,0 +1,242 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ngram_index.cxx
+ * Inverted index of words by n-grams for suggestions.
+ */
+
+#include "ngram_index.hxx"
+
+#include <algorithm>
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Gets the sorted distinct hashes of the bigrams of a word.
+ */
+template <class CharT>
+auto bigrams(const basic_string<CharT>& w, vector<uint32_t>& out) -> void
+{
+	out.clear();
+	// 0 marks the boundary of the word
+	auto prev = uint32_t(0);
+	for (size_t i = 0; i <= w.size(); ++i) {
+		auto c = i == w.size() ? uint32_t(0) : uint32_t(w[i]);
+		// FNV-1a of the pair
+		auto h = 2166136261u;
+		h = (h ^ prev) * 16777619u;
+		h = (h ^ c) * 16777619u;
+		out.push_back(h);
+		prev = c;
+	}
+	sort(begin(out), end(out));
+	out.erase(unique(begin(out), end(out)), end(out));
+}
+} // namespace
+
+template <class CharT>
+auto Ngram_Index<CharT>::word(size_t i) const -> StrT
+{
+	return chars.substr(offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+/**
+ * Builds the index.
+ *
+ * @param words the words, duplicates are indexed once.
+ */
+template <class CharT>
+auto Ngram_Index<CharT>::build(const vector<StrT>& words) -> void
+{
+	auto keyed = vector<pair<StrT, StrT>>();
+	keyed.reserve(words.size());
+	for (auto& w : words)
+		keyed.emplace_back(w, w);
+	build(keyed);
+}
+
+/**
+ * Builds the index of words by their keys.
+ *
+ * @param keyed_words the key and the word, duplicates are indexed once. A
+ * word can have several keys.
+ */
+template <class CharT>
+auto Ngram_Index<CharT>::build(const vector<pair<StrT, StrT>>& keyed_words)
+    -> void
+{
+	clear();
+	auto sorted = keyed_words;
+	sort(begin(sorted), end(sorted));
+	sorted.erase(unique(begin(sorted), end(sorted)), end(sorted));
+	offsets.reserve(sorted.size() + 1);
+	gram_counts.reserve(sorted.size());
+	auto grams = vector<uint32_t>();
+	for (uint32_t i = 0; i != sorted.size(); ++i) {
+		offsets.push_back(chars.size());
+		chars += sorted[i].second;
+		bigrams(sorted[i].first, grams);
+		auto n = min(grams.size(), size_t(UINT16_MAX));
+		gram_counts.push_back(n);
+		for (size_t j = 0; j != n; ++j)
+			postings.emplace_back(grams[j], i);
+	}
+	offsets.push_back(chars.size());
+	sort(begin(postings), end(postings));
+	postings.shrink_to_fit();
+}
+
+/**
+ * Finds the most similar words.
+ *
+ * @param word the misspelled word.
+ * @param count the maximal number of words to find.
+ * @param out the words, most similar first. At equal similarity the words
+ * of nearer length go first, then by key. The word itself is not included,
+ * and a word found by several keys is included once.
+ */
+template <class CharT>
+auto Ngram_Index<CharT>::lookup(const StrT& word, size_t count,
+                                vector<StrT>& out) const -> void
+{
+	out.clear();
+	if (empty() || count == 0)
+		return;
+	auto grams = vector<uint32_t>();
+	bigrams(word, grams);
+	using Iter = typename decltype(postings)::const_iterator;
+	auto lists = vector<pair<Iter, Iter>>();
+	for (auto g : grams) {
+		auto r = equal_range(
+		    begin(postings), end(postings), make_pair(g, uint32_t(0)),
+		    [](auto& a, auto& b) { return a.first < b.first; });
+		lists.push_back(r);
+	}
+	sort(begin(lists), end(lists), [](auto& a, auto& b) {
+		return a.second - a.first < b.second - b.first;
+	});
+
+	// A word that shares at least min_shared bigrams shares at least one
+	// of the rarest size - min_shared + 1. Only their postings are
+	// scanned, the candidates are looked up in the other lists.
+	auto min_shared = (grams.size() + 1) / 2;
+	auto rarest = grams.size() - min_shared + 1;
+	auto ids = vector<uint32_t>();
+	for (size_t i = 0; i != rarest; ++i)
+		for (auto it = lists[i].first; it != lists[i].second; ++it)
+			ids.push_back(it->second);
+	sort(begin(ids), end(ids));
+	// id of word and number of shared bigrams, sorted by id
+	auto shared = vector<pair<uint32_t, uint32_t>>();
+	for (auto id : ids) {
+		if (!shared.empty() && shared.back().first == id)
+			++shared.back().second;
+		else
+			shared.emplace_back(id, 1);
+	}
+	// The postings of one bigram are sorted by id, like the candidates,
+	// so each search continues where the previous one stopped. The
+	// candidates that can no longer reach min_shared are dropped.
+	for (size_t i = rarest; i != lists.size() && !shared.empty(); ++i) {
+		auto lists_left = lists.size() - i;
+		auto it = lists[i].first;
+		auto last = lists[i].second;
+		auto out_it = begin(shared);
+		for (auto& s : shared) {
+			if (s.second + lists_left < min_shared)
+				continue;
+			it = lower_bound(
+			    it, last, s.first,
+			    [](auto& p, uint32_t id) { return p.second < id; });
+			if (it != last && it->second == s.first) {
+				++s.second;
+				++it;
+			}
+			*out_it++ = s;
+		}
+		shared.erase(out_it, end(shared));
+	}
+
+	// rank by Dice coefficient, length difference, then word index
+	struct Scored {
+		double score;
+		size_t len_diff;
+		uint32_t id;
+		auto operator<(const Scored& o) const
+		{
+			if (score != o.score)
+				return score > o.score;
+			if (len_diff != o.len_diff)
+				return len_diff < o.len_diff;
+			return id < o.id;
+		}
+	};
+	auto best = vector<Scored>();
+	for (auto& s : shared) {
+		if (s.second < min_shared)
+			continue;
+		auto id = s.first;
+		size_t len = offsets[id + 1] - offsets[id];
+		auto score = 2.0 * s.second / (grams.size() + gram_counts[id]);
+		auto len_diff = max(len, word.size()) - min(len, word.size());
+		best.push_back({score, len_diff, id});
+	}
+	// sorted in steps, as the words can repeat under several keys
+	for (size_t i = 0, n = count + 1; out.size() != count; n *= 2) {
+		n = min(n, best.size());
+		partial_sort(begin(best) + i, begin(best) + n, end(best));
+		for (; i != n && out.size() != count; ++i) {
+			auto w = this->word(best[i].id);
+			if (w != word &&
+			    find(begin(out), end(out), w) == end(out))
+				out.push_back(move(w));
+		}
+		if (n == best.size())
+			break;
+	}
+}
+
+template <class CharT>
+auto Ngram_Index<CharT>::clear() -> void
+{
+	chars.clear();
+	offsets.clear();
+	gram_counts.clear();
+	postings.clear();
+}
+
+/**
+ * Gets the heap memory of the index in bytes.
+ */
+template <class CharT>
+auto Ngram_Index<CharT>::memory_usage() const -> size_t
+{
+	return chars.capacity() * sizeof(CharT) +
+	       offsets.capacity() * sizeof(offsets[0]) +
+	       gram_counts.capacity() * sizeof(gram_counts[0]) +
+	       postings.capacity() * sizeof(postings[0]);
+}
+
+template class Ngram_Index<char>;
+template class Ngram_Index<wchar_t>;
+} // namespace nuspell
@@ -0,0 +1,77 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ngram_index.hxx
+ * Inverted index of words by n-grams for suggestions.
+ */
+
+#ifndef NUSPELL_NGRAM_INDEX_HXX
+#define NUSPELL_NGRAM_INDEX_HXX
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Inverted index from the bigrams of words to the words.
+ *
+ * The bigrams include the first and the last character paired with the
+ * boundary of the word. The similarity of two words is the Dice coefficient
+ * of their sets of bigrams. Only the words that share at least half of the
+ * bigrams of the looked up word are scored, and their candidates come only
+ * from the postings of its rarest bigrams. The common bigrams are never
+ * scanned, the candidates are binary searched in their postings.
+ *
+ * The bigrams can be taken from a key instead of the word itself, e.g. its
+ * lower case, then the words are found by the similarity of their keys.
+ */
+template <class CharT>
+class Ngram_Index {
+      public:
+	using StrT = std::basic_string<CharT>;
+
+      private:
+	StrT chars;                         // the words one after another
+	std::vector<std::uint32_t> offsets; // where each word starts
+	std::vector<std::uint16_t> gram_counts;
+	// hash of a bigram and index of word, sorted
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> postings;
+
+	auto word(std::size_t i) const -> StrT;
+
+      public:
+	auto build(const std::vector<StrT>& words) -> void;
+	auto build(const std::vector<std::pair<StrT, StrT>>& keyed_words)
+	    -> void;
+	auto lookup(const StrT& word, std::size_t count,
+	            std::vector<StrT>& out) const -> void;
+	auto clear() -> void;
+
+	auto empty() const { return offsets.empty(); }
+	auto size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	auto memory_usage() const -> std::size_t;
+};
+extern template class Ngram_Index<char>;
+extern template class Ngram_Index<wchar_t>;
+} // namespace nuspell
+
+#endif // NUSPELL_NGRAM_INDEX_HXX
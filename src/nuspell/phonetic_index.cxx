@@ -0,0 +1,135 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file phonetic_index.cxx
+ * Index of words by their phonetic codes for suggestions.
+ */
+
+#include "phonetic_index.hxx"
+#include "locale_utils.hxx"
+
+#include <algorithm>
+#include <chrono>
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+
+// FNV-1a
+template <class CharT>
+auto hash_str(const basic_string<CharT>& s) -> uint32_t
+{
+	uint32_t h = 2166136261u;
+	for (auto c : s) {
+		h ^= uint32_t(c);
+		h *= 16777619u;
+	}
+	return h;
+}
+} // namespace
+
+template <class CharT>
+auto Phonetic_Index<CharT>::word(size_t i) const -> StrT
+{
+	return chars.substr(offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+/**
+ * Builds the index.
+ *
+ * The words with an empty code are not indexed. The time of building is
+ * kept, see build_seconds().
+ *
+ * @param words the words, duplicates are indexed once.
+ * @param table the PHONE rules.
+ * @param loc locale used to convert the words to upper case.
+ */
+template <class CharT>
+auto Phonetic_Index<CharT>::build(const vector<StrT>& words,
+                                  const Phonetic_Table<CharT>& table,
+                                  const locale& loc) -> void
+{
+	auto t1 = chrono::steady_clock::now();
+	clear();
+	if (table.empty())
+		return;
+	auto sorted = words;
+	sort(begin(sorted), end(sorted));
+	sorted.erase(unique(begin(sorted), end(sorted)), end(sorted));
+	offsets.reserve(sorted.size() + 1);
+	for (uint32_t i = 0; i != sorted.size(); ++i) {
+		offsets.push_back(chars.size());
+		chars += sorted[i];
+		auto code = table.phonetic_code(to_upper(sorted[i], loc));
+		if (!code.empty())
+			entries.emplace_back(hash_str(code), i);
+	}
+	offsets.push_back(chars.size());
+	sort(begin(entries), end(entries));
+	entries.shrink_to_fit();
+	auto t2 = chrono::steady_clock::now();
+	seconds = chrono::duration<double>(t2 - t1).count();
+}
+
+/**
+ * Finds the words with a phonetic code.
+ *
+ * @param code the code, as given by Phonetic_Table::phonetic_code().
+ * @param out the words in alphabetical order. Rarely it also contains words
+ * of another code with the same hash.
+ */
+template <class CharT>
+auto Phonetic_Index<CharT>::lookup(const StrT& code, vector<StrT>& out) const
+    -> void
+{
+	out.clear();
+	if (code.empty())
+		return;
+	auto range = equal_range(
+	    begin(entries), end(entries), make_pair(hash_str(code), 0u),
+	    [](auto& a, auto& b) { return a.first < b.first; });
+	for (auto it = range.first; it != range.second; ++it)
+		out.push_back(word(it->second));
+}
+
+template <class CharT>
+auto Phonetic_Index<CharT>::clear() -> void
+{
+	chars.clear();
+	offsets.clear();
+	entries.clear();
+	seconds = 0;
+}
+
+/**
+ * Gets the heap memory of the index in bytes.
+ */
+template <class CharT>
+auto Phonetic_Index<CharT>::memory_usage() const -> size_t
+{
+	return chars.capacity() * sizeof(CharT) +
+	       offsets.capacity() * sizeof(offsets[0]) +
+	       entries.capacity() * sizeof(entries[0]);
+}
+
+template class Phonetic_Index<char>;
+template class Phonetic_Index<wchar_t>;
+} // namespace nuspell
@@ -0,0 +1,74 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file phonetic_index.hxx
+ * Index of words by their phonetic codes for suggestions.
+ */
+
+#ifndef NUSPELL_PHONETIC_INDEX_HXX
+#define NUSPELL_PHONETIC_INDEX_HXX
+
+#include "structures.hxx"
+
+#include <cstdint>
+#include <locale>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Index from the phonetic codes of words to the words.
+ *
+ * The codes are computed with the PHONE table once, when the index is
+ * built, so the words that sound like a misspelled word are found with one
+ * lookup of its code.
+ */
+template <class CharT>
+class Phonetic_Index {
+      public:
+	using StrT = std::basic_string<CharT>;
+
+      private:
+	StrT chars;                         // the words one after another
+	std::vector<std::uint32_t> offsets; // where each word starts
+	// hash of a code and index of word, sorted
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> entries;
+	double seconds = 0;
+
+	auto word(std::size_t i) const -> StrT;
+
+      public:
+	auto build(const std::vector<StrT>& words,
+	           const Phonetic_Table<CharT>& table, const std::locale& loc)
+	    -> void;
+	auto lookup(const StrT& code, std::vector<StrT>& out) const -> void;
+	auto clear() -> void;
+
+	auto empty() const { return offsets.empty(); }
+	auto size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	auto build_seconds() const { return seconds; }
+	auto memory_usage() const -> std::size_t;
+};
+extern template class Phonetic_Index<char>;
+extern template class Phonetic_Index<wchar_t>;
+} // namespace nuspell
+
+#endif // NUSPELL_PHONETIC_INDEX_HXX
@@ -23,6 +23,9 @@
 
 #include "structures.hxx"
 
+#include <cctype>
+#include <type_traits>
+
 namespace nuspell {
 
 using namespace std;
@@ -157,6 +160,459 @@ auto Break_Table<CharT>::order_entries() -> void
 template class Break_Table<char>;
 template class Break_Table<wchar_t>;
 
+namespace {
+template <class CharT>
+auto phonet_isalpha(CharT c) -> bool
+{
+	auto u = static_cast<typename make_unsigned<CharT>::type>(c);
+	if (u < 128)
+		return isalpha(static_cast<unsigned char>(u));
+	return true;
+}
+} // namespace
+
+/**
+ * Parses the rules.
+ *
+ * The syntax is the one of the PHONE rules of Aspell. A rule is its first
+ * letter, the letters that follow, optionally a group of letters in
+ * parentheses of which one must follow, then '-' for each letter that is
+ * matched but not consumed, '<', a priority digit and '^', "^^" or '$'.
+ * In the replacements '_' stands for nothing.
+ */
+template <class CharT>
+auto Phonetic_Table<CharT>::compile(const Table_Pairs& v) -> void
+{
+	auto special = StrT({'(', '-', '<', '^', '$'});
+	rules.clear();
+	for (auto& e : v) {
+		auto& p = e.first;
+		if (p.empty())
+			continue;
+		auto r = Rule();
+		r.first = p[0];
+		size_t i = 1;
+		for (; i != p.size(); ++i) {
+			auto c = p[i];
+			if ((c >= '0' && c <= '9') ||
+			    special.find(c) != special.npos)
+				break;
+			r.letters += c;
+		}
+		r.has_group = i != p.size() && p[i] == '(';
+		if (r.has_group) {
+			auto j = min(p.find(')', i), p.size());
+			r.group = p.substr(i + 1, j - i - 1);
+			i = min(j + 1, p.size());
+		}
+		r.after = i != p.size() ? p[i] : CharT();
+		for (; i != p.size() && p[i] == '-'; ++i)
+			++r.minus;
+		if (i != p.size() && p[i] == '<')
+			++i;
+		r.priority = 5;
+		if (i != p.size() && p[i] >= '0' && p[i] <= '9')
+			r.priority = p[i++] - '0';
+		if (i + 1 < p.size() && p[i] == '^' && p[i + 1] == '^')
+			++i;
+		if (i == p.size())
+			r.anchor = NONE;
+		else if (p[i] == '^' && i + 1 < p.size() && p[i + 1] == '$')
+			r.anchor = START_END;
+		else if (p[i] == '^')
+			r.anchor = START;
+		else if (p[i] == '$')
+			r.anchor = END;
+		else
+			r.anchor = INVALID;
+		r.lt = p.find('<', 1) != p.npos;
+		r.restart = p.find(StrT({'^', '^'}), 1) != p.npos;
+		r.replacement = e.second;
+		r.replacement.erase(remove(begin(r.replacement),
+		                           end(r.replacement), '_'),
+		                    end(r.replacement));
+		rules.push_back(move(r));
+	}
+	stable_sort(begin(rules), end(rules),
+	            [](auto& a, auto& b) { return a.first < b.first; });
+}
+
+template <class CharT>
+auto Phonetic_Table<CharT>::rules_of(CharT c) const
+    -> pair<typename vector<Rule>::const_iterator,
+            typename vector<Rule>::const_iterator>
+{
+	auto r = Rule();
+	r.first = c;
+	return equal_range(begin(rules), end(rules), r, [](auto& a, auto& b) {
+		return a.first < b.first;
+	});
+}
+
+/**
+ * Computes the phonetic code of a word.
+ *
+ * This is the algorithm of Aspell and Hunspell, see
+ * http://aspell.net/man-html/Phonetic-Code.html, run on the compiled rules.
+ *
+ * @param in the word in upper case.
+ * @return the code, empty if the word is too long.
+ */
+template <class CharT>
+auto Phonetic_Table<CharT>::phonetic_code(const StrT& in) const -> StrT
+{
+	using boost::make_iterator_range;
+	const size_t MAX_PHONET_LEN = 256;
+	auto code = StrT();
+	if (in.size() > MAX_PHONET_LEN)
+		return code;
+	auto word = in;
+	auto len = word.size();
+	auto at = [&](size_t j) { return j < word.size() ? word[j] : CharT(); };
+	size_t i = 0, k = 0;
+	// matches the rest of the rule after the letters i to i + k
+	auto matches = [&](const Rule& r, size_t& k) {
+		for (auto l : r.letters) {
+			if (at(i + k) != l)
+				return false;
+			++k;
+		}
+		if (r.has_group) {
+			auto c = at(i + k);
+			if (!phonet_isalpha(c) ||
+			    r.group.find(c) == r.group.npos)
+				return false;
+			++k;
+		}
+		return true;
+	};
+	int p0 = 0;
+	bool z = false;
+	while (i < word.size()) {
+		auto c = word[i];
+		auto z0 = false;
+		auto range = rules_of(c);
+		for (auto n = range.first; n != range.second; ++n) {
+			auto& r = *n;
+			k = 1;
+			if (!matches(r, k)) {
+				p0 = 1; // any letter that does not match
+				continue;
+			}
+			p0 = r.after;
+			auto k0 = k;
+			if (r.minus >= k)
+				continue;
+			k -= r.minus;
+			auto p = r.priority;
+			auto start = i == 0 || !phonet_isalpha(word[i - 1]);
+			auto end = !phonet_isalpha(at(i + k0));
+			auto ok = r.anchor == NONE ||
+			          (r.anchor == START && start) ||
+			          (r.anchor == START_END && start && end) ||
+			          (r.anchor == END && !start && end);
+			if (!ok)
+				continue;
+
+			// search for a follow-up rule that matches further
+			auto c0 = at(i + k - 1);
+			auto follow = rules_of(c0);
+			if (k > 1 && p0 != '-' && at(i + k) != 0 &&
+			    follow.first != follow.second) {
+				auto fits = false;
+				for (auto& f : make_iterator_range(follow)) {
+					k0 = k;
+					p0 = 5;
+					if (!matches(f, k0))
+						continue;
+					p0 = f.priority;
+					if (f.anchor != NONE &&
+					    (f.anchor != END ||
+					     phonet_isalpha(at(i + k0))))
+						continue;
+					// k0 == k is just a piece of the string
+					if (k0 == k || p0 < p)
+						continue;
+					fits = true;
+					break;
+				}
+				if (fits)
+					continue;
+			}
+
+			// replace
+			auto& s = r.replacement;
+			p0 = r.lt ? 1 : 0;
+			if (r.lt && !z) {
+				if (!code.empty() && !s.empty() &&
+				    (code.back() == c || code.back() == s[0]))
+					code.pop_back();
+				z0 = z = true;
+				auto n_write = min(s.size(), word.size() - i);
+				word.replace(i, n_write, s, 0, n_write);
+				if (k > n_write)
+					word.erase(i + n_write, k - n_write);
+			}
+			else {
+				i += k - 1;
+				z = false;
+				size_t j = 0;
+				while (j + 1 < s.size() && code.size() < len) {
+					if (code.empty() || code.back() != s[j])
+						code.push_back(s[j]);
+					++j;
+				}
+				c = j < s.size() ? s[j] : CharT();
+				if (r.restart) {
+					if (c != 0)
+						code.push_back(c);
+					word.erase(0, i + 1);
+					i = 0;
+					z0 = true;
+				}
+			}
+			break;
+		}
+		if (!z0) {
+			if (k && !p0 && code.size() < len && c != 0)
+				code.push_back(c);
+			++i;
+			z = false;
+			k = 0;
+		}
+	}
+	return code;
+}
+template class Phonetic_Table<char>;
+template class Phonetic_Table<wchar_t>;
+
+/**
+ * Compiles the rows of KEY.
+ *
+ * @param layout the value of KEY, rows of keys separated by '|'.
+ */
+template <class CharT>
+auto Keyboard_Table<CharT>::compile(const StrT& layout) -> void
+{
+	table.clear();
+	auto add = [&](size_t k, size_t n, size_t d) {
+		if (layout[k] != layout[n])
+			table.push_back({layout[k], layout[n],
+			                 static_cast<unsigned char>(d)});
+	};
+	for (size_t i = 0, j; i <= layout.size(); i = j + 1) {
+		j = min(layout.find('|', i), layout.size());
+		for (auto k = i; k != j; ++k) {
+			for (size_t d = 1; d <= MAX_DISTANCE; ++d) {
+				if (k >= i + d)
+					add(k, k - d, d);
+				if (k + d < j)
+					add(k, k + d, d);
+			}
+		}
+	}
+	stable_sort(begin(table), end(table), [](auto& a, auto& b) {
+		if (a.key != b.key)
+			return a.key < b.key;
+		return a.distance < b.distance;
+	});
+	// a key in several rows keeps the nearest of the same neighbours
+	auto out = begin(table);
+	auto group = out; // the first kept neighbour of the current key
+	for (auto it = begin(table); it != end(table); ++it) {
+		if (group != out && group->key != it->key)
+			group = out;
+		auto same = [&](auto& n) {
+			return n.neighbour == it->neighbour;
+		};
+		if (none_of(group, out, same))
+			*out++ = *it;
+	}
+	table.erase(out, end(table));
+}
+
+/**
+ * Gets the neighbouring keys of a key, nearest first.
+ */
+template <class CharT>
+auto Keyboard_Table<CharT>::neighbours(CharT key) const
+    -> boost::iterator_range<const_iterator>
+{
+	auto n = Neighbour();
+	n.key = key;
+	auto r = equal_range(begin(table), end(table), n,
+	                     [](auto& a, auto& b) { return a.key < b.key; });
+	return {r.first, r.second};
+}
+
+template class Keyboard_Table<char>;
+template class Keyboard_Table<wchar_t>;
+
+/**
+ * Compiles the REP entries.
+ *
+ * @param v the patterns and their replacements.
+ */
+template <class CharT>
+auto Replacement_Table<CharT>::compile(const Table_Pairs& v) -> void
+{
+	rules.clear();
+	nodes.clear();
+	edges.clear();
+	node_rules.clear();
+	// the trie of the patterns, with the children of each node
+	auto children = vector<vector<pair<CharT, uint32_t>>>(1);
+	auto rules_at = vector<vector<uint32_t>>(1);
+	for (auto& e : v) {
+		auto from = e.first;
+		auto r = Rule();
+		r.anchor = NONE;
+		if (!from.empty() && from.front() == '^') {
+			from.erase(0, 1);
+			r.anchor |= START;
+		}
+		if (!from.empty() && from.back() == '$') {
+			from.pop_back();
+			r.anchor |= END;
+		}
+		if (from.empty())
+			continue;
+		uint32_t n = 0;
+		for (auto c : from) {
+			auto& ch = children[n];
+			auto is_c = [&](auto& x) { return x.first == c; };
+			auto it = find_if(begin(ch), end(ch), is_c);
+			if (it != end(ch)) {
+				n = it->second;
+				continue;
+			}
+			ch.emplace_back(c, children.size());
+			n = children.size();
+			children.emplace_back();
+			rules_at.emplace_back();
+		}
+		r.size = from.size();
+		r.replacement = e.second;
+		rules_at[n].push_back(rules.size());
+		rules.push_back(move(r));
+	}
+	if (rules.empty())
+		return;
+	nodes.resize(children.size());
+	for (size_t i = 0; i != nodes.size(); ++i) {
+		auto& n = nodes[i];
+		sort(begin(children[i]), end(children[i]));
+		n.first_edge = edges.size();
+		edges.insert(end(edges), begin(children[i]), end(children[i]));
+		n.last_edge = edges.size();
+		n.first_rule = node_rules.size();
+		node_rules.insert(end(node_rules), begin(rules_at[i]),
+		                  end(rules_at[i]));
+		n.last_rule = node_rules.size();
+		n.fail = n.output = 0;
+	}
+	// the links to the suffixes, breadth first so the shorter are known
+	auto queue = vector<uint32_t>{0};
+	for (size_t q = 0; q != queue.size(); ++q) {
+		auto u = queue[q];
+		for (auto e = nodes[u].first_edge; e != nodes[u].last_edge;
+		     ++e) {
+			auto c = edges[e].first;
+			auto v = edges[e].second;
+			queue.push_back(v);
+			if (u == 0)
+				continue;
+			auto f = nodes[u].fail;
+			while (f != 0 && child(f, c) == 0)
+				f = nodes[f].fail;
+			auto& n = nodes[v];
+			n.fail = child(f, c);
+			auto& fn = nodes[n.fail];
+			n.output = fn.first_rule != fn.last_rule ? n.fail
+			                                         : fn.output;
+		}
+	}
+}
+
+template <class CharT>
+auto Replacement_Table<CharT>::child(uint32_t node, CharT c) const
+    -> uint32_t
+{
+	auto& n = nodes[node];
+	auto first = begin(edges) + n.first_edge;
+	auto last = begin(edges) + n.last_edge;
+	auto it = lower_bound(first, last, c,
+	                      [](auto& e, CharT x) { return e.first < x; });
+	if (it == last || it->first != c)
+		return 0;
+	return it->second;
+}
+
+/**
+ * Makes the words with one replacement each.
+ *
+ * Each occurrence of a pattern is replaced separately. The words are in the
+ * order of the entries of the table, and of the occurrences for each entry.
+ *
+ * @param word the word.
+ * @param out the words with replacements.
+ */
+template <class CharT>
+auto Replacement_Table<CharT>::replace_each(const StrT& word,
+                                            vector<StrT>& out) const -> void
+{
+	out.clear();
+	if (rules.empty())
+		return;
+	// rule and position of each match
+	auto matches = vector<pair<uint32_t, size_t>>();
+	uint32_t state = 0;
+	for (size_t i = 0; i != word.size(); ++i) {
+		auto c = word[i];
+		while (state != 0 && child(state, c) == 0)
+			state = nodes[state].fail;
+		state = child(state, c);
+		auto& n = nodes[state];
+		auto o = n.first_rule != n.last_rule ? state : n.output;
+		for (; o != 0; o = nodes[o].output) {
+			for (auto j = nodes[o].first_rule;
+			     j != nodes[o].last_rule; ++j) {
+				auto& r = rules[node_rules[j]];
+				auto pos = i + 1 - r.size;
+				if ((r.anchor & START) && pos != 0)
+					continue;
+				if ((r.anchor & END) && i + 1 != word.size())
+					continue;
+				matches.emplace_back(node_rules[j], pos);
+			}
+		}
+	}
+	sort(begin(matches), end(matches));
+	for (auto& m : matches) {
+		auto& r = rules[m.first];
+		out.push_back(word);
+		out.back().replace(m.second, r.size, r.replacement);
+	}
+}
+
+/**
+ * Gets the heap memory of the table in bytes.
+ */
+template <class CharT>
+auto Replacement_Table<CharT>::memory_usage() const -> size_t
+{
+	auto ret = rules.capacity() * sizeof(Rule) +
+	           nodes.capacity() * sizeof(Node) +
+	           edges.capacity() * sizeof(edges[0]) +
+	           node_rules.capacity() * sizeof(node_rules[0]);
+	for (auto& r : rules)
+		ret += r.replacement.capacity() * sizeof(CharT);
+	return ret;
+}
+
+template class Replacement_Table<char>;
+template class Replacement_Table<wchar_t>;
+
 /**
  * Constructs a prefix entry.
  *
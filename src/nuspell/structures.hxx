@@ -27,6 +27,7 @@
 #include "condition.hxx"
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -346,6 +347,7 @@ class Substr_Replacer {
 		replace(s);
 		return s;
 	}
+	auto& data() const { return table; }
 };
 extern template class Substr_Replacer<char>;
 extern template class Substr_Replacer<wchar_t>;
@@ -412,6 +414,148 @@ class Break_Table {
 extern template class Break_Table<char>;
 extern template class Break_Table<wchar_t>;
 
+/**
+ * @brief Table of PHONE rules compiled for computing phonetic codes.
+ *
+ * Each rule is parsed once into its parts, and the rules are ordered by
+ * their first letter, so computing a code only looks at the rules of the
+ * current letter and never scans the text of a rule.
+ */
+template <class CharT>
+class Phonetic_Table {
+      public:
+	using StrT = std::basic_string<CharT>;
+	using Table_Pairs = std::vector<std::pair<StrT, StrT>>;
+
+      private:
+	enum Anchor { NONE, START, START_END, END, INVALID };
+	struct Rule {
+		CharT first;
+		StrT letters;     // to match after the first letter
+		StrT group;       // one of these matches after the letters
+		bool has_group;
+		CharT after;      // first character after the group or 0
+		size_t minus;     // letters not consumed, count of '-'
+		bool lt;          // '<', replace in the word and process again
+		bool restart;     // "^^", restart from the replaced letters
+		int priority;
+		Anchor anchor;
+		StrT replacement;
+	};
+	std::vector<Rule> rules;
+	auto compile(const Table_Pairs& v) -> void; // implemented in cxx
+	auto rules_of(CharT c) const
+	    -> std::pair<typename std::vector<Rule>::const_iterator,
+	                 typename std::vector<Rule>::const_iterator>;
+
+      public:
+	Phonetic_Table() = default;
+	Phonetic_Table(const Table_Pairs& v) { compile(v); }
+	auto& operator=(const Table_Pairs& v)
+	{
+		compile(v);
+		return *this;
+	}
+	auto phonetic_code(const StrT& word) const -> StrT;
+	auto empty() const { return rules.empty(); }
+	auto size() const { return rules.size(); }
+};
+extern template class Phonetic_Table<char>;
+extern template class Phonetic_Table<wchar_t>;
+
+/**
+ * @brief Table of the neighbouring keys of each key, compiled from KEY.
+ *
+ * KEY lists rows of keys separated by '|'. The distance of two keys is how
+ * far apart they are in a row, and the neighbours of a key are the keys up
+ * to MAX_DISTANCE apart in any of its rows. The neighbours of a key are
+ * found with one binary search, nearest first, and at equal distance in the
+ * order of KEY with the left one before the right one.
+ */
+template <class CharT>
+class Keyboard_Table {
+      public:
+	using StrT = std::basic_string<CharT>;
+	enum { MAX_DISTANCE = 2 };
+	struct Neighbour {
+		CharT key;
+		CharT neighbour;
+		unsigned char distance;
+	};
+	using const_iterator = typename std::vector<Neighbour>::const_iterator;
+
+      private:
+	std::vector<Neighbour> table; // sorted by key, then by distance
+	auto compile(const StrT& layout) -> void; // implemented in cxx
+
+      public:
+	Keyboard_Table() = default;
+	Keyboard_Table(const StrT& layout) { compile(layout); }
+	auto& operator=(const StrT& layout)
+	{
+		compile(layout);
+		return *this;
+	}
+	auto neighbours(CharT key) const
+	    -> boost::iterator_range<const_iterator>;
+	auto empty() const { return table.empty(); }
+	auto size() const { return table.size(); }
+	auto& data() const { return table; }
+};
+extern template class Keyboard_Table<char>;
+extern template class Keyboard_Table<wchar_t>;
+
+/**
+ * @brief Table of REP replacements compiled into an Aho-Corasick automaton.
+ *
+ * The patterns of all replacements are searched together in one scan of a
+ * word, instead of one search for each pattern. A pattern starting with '^'
+ * matches only at the start of the word, one ending with '$' only at the
+ * end.
+ */
+template <class CharT>
+class Replacement_Table {
+      public:
+	using StrT = std::basic_string<CharT>;
+	using Table_Pairs = std::vector<std::pair<StrT, StrT>>;
+
+      private:
+	enum Anchor : unsigned char { NONE, START = 1, END = 2 };
+	struct Rule {
+		std::size_t size; // of the pattern without the anchors
+		unsigned char anchor;
+		StrT replacement;
+	};
+	struct Node {
+		std::uint32_t first_edge, last_edge; // the children in edges
+		std::uint32_t first_rule, last_rule; // the rules in node_rules
+		std::uint32_t fail;   // the longest proper suffix in the trie
+		std::uint32_t output; // the nearest suffix with rules, or 0
+	};
+	std::vector<Rule> rules;
+	std::vector<Node> nodes; // the root is 0
+	std::vector<std::pair<CharT, std::uint32_t>> edges; // sorted by node
+	std::vector<std::uint32_t> node_rules; // the rules ending at a node
+	auto compile(const Table_Pairs& v) -> void; // implemented in cxx
+	auto child(std::uint32_t node, CharT c) const -> std::uint32_t;
+
+      public:
+	Replacement_Table() = default;
+	Replacement_Table(const Table_Pairs& v) { compile(v); }
+	auto& operator=(const Table_Pairs& v)
+	{
+		compile(v);
+		return *this;
+	}
+	auto replace_each(const StrT& word, std::vector<StrT>& out) const
+	    -> void;
+	auto empty() const { return rules.empty(); }
+	auto size() const { return rules.size(); }
+	auto memory_usage() const -> std::size_t;
+};
+extern template class Replacement_Table<char>;
+extern template class Replacement_Table<wchar_t>;
+
 template <class CharT>
 class Prefix {
       public:
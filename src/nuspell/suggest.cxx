@@ -0,0 +1,1435 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file suggest.cxx
+ * Suggestions for misspelled words.
+ */
+
+#include "dictionary.hxx"
+#include "string_utils.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/locale.hpp>
+
+namespace nuspell {
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Deduplicated list of candidate suggestions, in order of priority.
+ *
+ * The candidates are edits of a base word, either the misspelled word or its
+ * lower case. Those of the lower case are converted back to the casing of
+ * the misspelled word before they are added.
+ *
+ * As in Hunspell, a candidate must be in the dictionary in the same casing,
+ * except the recased ones and those added as lenient, which are spelled
+ * with the rules of their casing, e.g. Vacation for vacation. A candidate
+ * is kept once in each of the two kinds.
+ */
+template <class CharT>
+class Candidate_Buffer {
+	using StrT = basic_string<CharT>;
+	const StrT& word;
+	const locale& loc;
+	size_t limit;
+	Casing recase = Casing::SMALL;
+	vector<StrT> cands;
+	vector<bool> recased; // if the casing of the candidate was changed
+	vector<bool> lenient; // if it is spelled with the rules of casing
+	unordered_set<StrT> seen;
+	unordered_set<StrT> seen_lenient;
+
+      public:
+	Candidate_Buffer(const StrT& word, const locale& loc, size_t limit)
+	    : word(word), loc(loc), limit(limit)
+	{
+	}
+	auto set_recase(Casing c) { recase = c; }
+	auto full() const { return limit != 0 && cands.size() >= limit; }
+	auto add(StrT c, bool any_casing = false) -> void
+	{
+		if (full())
+			return;
+		auto changed = false;
+		if (recase != Casing::SMALL) {
+			auto t = recase == Casing::INIT_CAPITAL
+			             ? to_title(c, loc)
+			             : to_upper(c, loc);
+			changed = t != c;
+			c = move(t);
+		}
+		if (c.empty() || c == word)
+			return;
+		any_casing = any_casing || changed;
+		auto& s = any_casing ? seen_lenient : seen;
+		if (s.insert(c).second) {
+			cands.push_back(move(c));
+			recased.push_back(changed);
+			lenient.push_back(any_casing);
+		}
+	}
+	auto& data() const { return cands; }
+	auto was_recased(size_t i) const -> bool { return recased[i]; }
+	auto is_lenient(size_t i) const -> bool { return lenient[i]; }
+};
+
+// maximal distance of the swapped and moved characters
+const size_t MAX_CHAR_DISTANCE = 4;
+
+// maximal number of MAP substitutions in one candidate
+const size_t MAX_MAP_CHANGES = 3;
+
+/**
+ * @brief Adds the word in other casing, e.g. for proper nouns.
+ *
+ * The upper case is a valid spelling of any word, so it is suggested only if
+ * the dictionary has the word in upper case, e.g. nasa -> NASA but not
+ * Mcdonald -> MCDONALD. It is not tried for words in mixed case. The lower
+ * case is added later, with its edits.
+ */
+template <class CharT>
+auto case_candidates(const basic_string<CharT>& w, Casing casing,
+                     const locale& loc, Candidate_Buffer<CharT>& out) -> void
+{
+	// as Hunspell capitalizes the suggestions for e.g. BAr -> Bar
+	out.add(to_title(w, loc), casing == Casing::PASCAL);
+	// a missing space after a sentence, e.g. something.The
+	auto dot = w.find('.');
+	if ((casing == Casing::CAMEL || casing == Casing::PASCAL) &&
+	    dot != w.npos &&
+	    classify_casing(w.substr(dot + 1), loc) == Casing::INIT_CAPITAL)
+		out.add(basic_string<CharT>(w).insert(dot + 1, 1, ' '), true);
+	if (casing == Casing::SMALL || casing == Casing::INIT_CAPITAL)
+		out.add(to_upper(w, loc));
+}
+
+/**
+ * @brief Adds the replacements of the REP table.
+ *
+ * Each occurrence of a pattern is replaced separately. The anchors ^ and $
+ * restrict a pattern to the start or end of the word.
+ */
+template <class CharT>
+auto rep_candidates(const basic_string<CharT>& w,
+                    const Aff_Structures<CharT>& d,
+                    Candidate_Buffer<CharT>& out) -> void
+{
+	auto found = vector<basic_string<CharT>>();
+	d.replacement_table.replace_each(w, found);
+	for (auto& x : found)
+		out.add(move(x));
+}
+
+template <class CharT>
+auto map_candidates(basic_string<CharT>& w, size_t i, size_t changes,
+                    const Aff_Structures<CharT>& d,
+                    Candidate_Buffer<CharT>& out) -> void
+{
+	if (changes == MAX_MAP_CHANGES || out.full())
+		return;
+	for (; i != w.size(); ++i) {
+		for (auto& group : d.map_related_chars) {
+			for (auto& a : group) {
+				if (w.compare(i, a.size(), a) != 0)
+					continue;
+				for (auto& b : group) {
+					if (&a == &b)
+						continue;
+					auto c = w;
+					c.replace(i, a.size(), b);
+					out.add(c);
+					map_candidates(c, i + b.size(),
+					               changes + 1, d, out);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Adds the substitutions of related characters of the MAP table.
+ *
+ * Up to MAX_MAP_CHANGES characters of a word are substituted.
+ */
+template <class CharT>
+auto map_candidates(const basic_string<CharT>& w,
+                    const Aff_Structures<CharT>& d,
+                    Candidate_Buffer<CharT>& out) -> void
+{
+	auto c = w;
+	map_candidates(c, 0, 0, d, out);
+}
+
+/**
+ * @brief Adds the swaps of adjacent and nearby characters.
+ */
+template <class CharT>
+auto swap_candidates(const basic_string<CharT>& w,
+                     Candidate_Buffer<CharT>& out) -> void
+{
+	auto c = w;
+	for (size_t i = 0; i + 1 < c.size(); ++i) {
+		std::swap(c[i], c[i + 1]);
+		out.add(c);
+		std::swap(c[i], c[i + 1]);
+	}
+	// two swaps in short words, e.g. ahev -> have, hwihc -> which
+	if (c.size() == 4 || c.size() == 5) {
+		auto n = c.size();
+		std::swap(c[n - 2], c[n - 1]);
+		std::swap(c[0], c[1]);
+		out.add(c);
+		std::swap(c[0], c[1]);
+		if (n == 5) {
+			std::swap(c[1], c[2]);
+			out.add(c);
+			std::swap(c[1], c[2]);
+		}
+		std::swap(c[n - 2], c[n - 1]);
+	}
+	for (size_t i = 0; i != c.size(); ++i) {
+		for (size_t j = i + 2;
+		     j < c.size() && j - i <= MAX_CHAR_DISTANCE; ++j) {
+			std::swap(c[i], c[j]);
+			out.add(c);
+			std::swap(c[i], c[j]);
+		}
+	}
+}
+
+// maximal score of the KEY edits, see key_candidates()
+const size_t MAX_KEY_SCORE = 2;
+
+/**
+ * @brief Adds the upper case of each character and the keys near it.
+ *
+ * The keys come from the compiled KEY table. A substitution with a key at
+ * distance d scores d, an insertion of a key next to the character before
+ * or after it scores 2. The edits are added from the lowest score up, so
+ * the likeliest ones are kept when the buffer fills up. At score 1 these
+ * are the edits of Hunspell, the upper case and the keys next to each
+ * character.
+ */
+template <class CharT>
+auto key_candidates(const basic_string<CharT>& w, const locale& loc,
+                    const Aff_Structures<CharT>& d,
+                    Candidate_Buffer<CharT>& out) -> void
+{
+	auto& ct = use_facet<ctype<CharT>>(loc);
+	auto& keys = d.keyboard_table;
+	auto c = w;
+	for (size_t score = 1; score <= MAX_KEY_SCORE; ++score) {
+		for (size_t i = 0; i != c.size(); ++i) {
+			auto old = c[i];
+			c[i] = ct.toupper(old);
+			if (score == 1 && c[i] != old)
+				out.add(c);
+			for (auto& n : keys.neighbours(old)) {
+				if (n.distance != score)
+					continue;
+				c[i] = n.neighbour;
+				out.add(c);
+			}
+			c[i] = old;
+		}
+		for (size_t i = 0; i != w.size(); ++i) {
+			for (auto& n : keys.neighbours(w[i])) {
+				if (n.distance + 1u != score)
+					continue;
+				c.insert(i, 1, n.neighbour);
+				out.add(c);
+				c.erase(i, 1);
+				c.insert(i + 1, 1, n.neighbour);
+				out.add(c);
+				c.erase(i + 1, 1);
+			}
+		}
+		if (out.full())
+			return;
+	}
+}
+
+/**
+ * @brief Adds the removals of one character.
+ */
+template <class CharT>
+auto extra_char_candidates(const basic_string<CharT>& w,
+                           Candidate_Buffer<CharT>& out) -> void
+{
+	for (size_t i = 0; i != w.size(); ++i)
+		out.add(basic_string<CharT>(w).erase(i, 1));
+}
+
+/**
+ * @brief Adds the insertions of each character of the TRY option.
+ */
+template <class CharT>
+auto forgot_char_candidates(const basic_string<CharT>& w,
+                            const Aff_Structures<CharT>& d,
+                            Candidate_Buffer<CharT>& out) -> void
+{
+	for (auto t : d.try_chars)
+		for (size_t i = 0; i <= w.size(); ++i)
+			out.add(basic_string<CharT>(w).insert(i, 1, t));
+}
+
+/**
+ * @brief Adds the moves of one character by two or more positions.
+ *
+ * The moves by one position are the adjacent swaps.
+ */
+template <class CharT>
+auto move_char_candidates(const basic_string<CharT>& w,
+                          Candidate_Buffer<CharT>& out) -> void
+{
+	for (size_t i = 0; i != w.size(); ++i) {
+		for (size_t j = i + 2;
+		     j < w.size() && j - i <= MAX_CHAR_DISTANCE; ++j) {
+			auto c = w;
+			rotate(&c[i], &c[i + 1], &c[j] + 1);
+			out.add(c);
+			c = w;
+			rotate(&c[i], &c[j], &c[j] + 1);
+			out.add(c);
+		}
+	}
+}
+
+/**
+ * @brief Adds the substitutions of each character with those of TRY.
+ */
+template <class CharT>
+auto bad_char_candidates(const basic_string<CharT>& w,
+                         const Aff_Structures<CharT>& d,
+                         Candidate_Buffer<CharT>& out) -> void
+{
+	auto c = w;
+	for (auto t : d.try_chars) {
+		for (size_t i = 0; i != c.size(); ++i) {
+			auto old = c[i];
+			if (old == t)
+				continue;
+			c[i] = t;
+			out.add(c);
+			c[i] = old;
+		}
+	}
+}
+
+/**
+ * @brief Adds the removals of a repeated pair of characters.
+ *
+ * For example, vacacation -> vacation.
+ */
+template <class CharT>
+auto double_two_chars_candidates(const basic_string<CharT>& w,
+                                 Candidate_Buffer<CharT>& out) -> void
+{
+	for (size_t i = 0; i + 3 < w.size(); ++i)
+		if (w[i] == w[i + 2] && w[i + 1] == w[i + 3])
+			out.add(basic_string<CharT>(w).erase(i + 2, 2));
+}
+
+/**
+ * @brief Adds the words of the delete index or of the trie near the word.
+ */
+template <class CharT, class IndexT>
+auto index_candidates(const basic_string<CharT>& w, const IndexT& index,
+                      Candidate_Buffer<CharT>& out) -> void
+{
+	auto found = vector<basic_string<CharT>>();
+	index.lookup(w, found);
+	for (auto& x : found)
+		out.add(move(x));
+}
+
+template <class CharT, class AffixT>
+auto add_derived(const basic_string<CharT>& root,
+                 const vector<const AffixT*>& affixes,
+                 vector<basic_string<CharT>>& out) -> void
+{
+	using boost::algorithm::ends_with;
+	using boost::algorithm::starts_with;
+	for (auto a : affixes) {
+		auto& strip = a->stripping;
+		auto fits = is_same<AffixT, Prefix<CharT>>::value
+		                ? starts_with(root, strip)
+		                : ends_with(root, strip);
+		if (fits && a->check_condition(root))
+			out.push_back(a->to_derived_copy(root));
+	}
+}
+
+/**
+ * @brief Collects the words for the delete index.
+ *
+ * These are the roots that can be suggested, and if affixed is true also
+ * the words made with one prefix or one suffix.
+ */
+template <class CharT>
+auto index_words(const Dictionary& dic, bool affixed)
+    -> vector<basic_string<CharT>>
+{
+	using StrT = basic_string<CharT>;
+	auto& d = dic.get_structures<CharT>();
+	auto ret = vector<StrT>();
+	auto can_suggest = [&](const Flag_Set& flags) {
+		return !flags.contains(dic.forbiddenword_flag) &&
+		       !flags.contains(dic.nosuggest_flag) &&
+		       !flags.contains(dic.need_affix_flag) &&
+		       !flags.contains(dic.compound_onlyin_flag);
+	};
+	// the affixes by flag
+	auto prefixes = unordered_map<char16_t, vector<const Prefix<CharT>*>>();
+	auto suffixes = unordered_map<char16_t, vector<const Suffix<CharT>*>>();
+	if (affixed) {
+		for (auto& a : d.prefixes)
+			if (can_suggest(a.cont_flags))
+				prefixes[a.flag].push_back(&a);
+		for (auto& a : d.suffixes)
+			if (can_suggest(a.cont_flags))
+				suffixes[a.flag].push_back(&a);
+	}
+	for (auto&& w : dic.words) {
+		auto& flags = w.second;
+		auto root = StrT(from_dict_to_wide_encoding<CharT>(
+		    string(w.first.data(), w.first.size())));
+		if (can_suggest(flags))
+			ret.push_back(root);
+		if (!affixed || flags.contains(dic.forbiddenword_flag) ||
+		    flags.contains(dic.nosuggest_flag))
+			continue;
+		for (auto f : flags) {
+			auto p = prefixes.find(f);
+			if (p != end(prefixes))
+				add_derived(root, p->second, ret);
+			auto s = suffixes.find(f);
+			if (s != end(suffixes))
+				add_derived(root, s->second, ret);
+		}
+	}
+	return ret;
+}
+
+/**
+ * @brief Collects the keys and the words for the n-gram index.
+ *
+ * The key of a word is its lower case. The roots are indexed, also those
+ * that need an affix as their forms are made at lookup, and the words with
+ * a ph: field once more under the pronunciation. If affixed is true, the
+ * forms with one affix are indexed too.
+ */
+template <class CharT>
+auto ngram_index_words(const Dictionary& dic, bool affixed)
+    -> vector<pair<basic_string<CharT>, basic_string<CharT>>>
+{
+	using StrT = basic_string<CharT>;
+	auto& loc = dic.locale_aff;
+	auto ret = vector<pair<StrT, StrT>>();
+	for (auto&& w : dic.words) {
+		auto& flags = w.second;
+		if (flags.contains(dic.forbiddenword_flag) ||
+		    flags.contains(dic.nosuggest_flag) ||
+		    flags.contains(dic.compound_onlyin_flag) ||
+		    flags.contains(HIDDEN_HOMONYM_FLAG))
+			continue;
+		auto root = StrT(from_dict_to_wide_encoding<CharT>(
+		    string(w.first.data(), w.first.size())));
+		ret.emplace_back(to_lower(root, loc), move(root));
+	}
+	if (affixed)
+		for (auto& w : index_words<CharT>(dic, true))
+			ret.emplace_back(to_lower(w, loc), w);
+	for (auto& p : dic.pronunciations)
+		ret.emplace_back(
+		    to_lower(StrT(from_dict_to_wide_encoding<CharT>(p.second)),
+		             loc),
+		    from_dict_to_wide_encoding<CharT>(p.first));
+	return ret;
+}
+
+// the options of ngram_score()
+enum Ngram_Options : unsigned char {
+	NGRAM_LONGER_WORSE = 1,
+	NGRAM_ANY_MISMATCH = 2,
+	NGRAM_WEIGHTED = 4
+};
+
+/**
+ * @brief Scores the similarity of two words by their substrings.
+ *
+ * As in Hunspell, counts the substrings of a of each length up to n that
+ * are in b, stopping at a length with fewer than two unless weighted. With
+ * NGRAM_WEIGHTED, each missing substring counts -1, and -2 at the ends of
+ * a. A difference of lengths over 2 is subtracted if b is longer with
+ * NGRAM_LONGER_WORSE, or in any case with NGRAM_ANY_MISMATCH.
+ */
+template <class CharT>
+auto ngram_score(size_t n, const basic_string<CharT>& a,
+                 const basic_string<CharT>& b, unsigned char options) -> int
+{
+	auto la = int(a.size());
+	auto lb = int(b.size());
+	if (lb == 0)
+		return 0;
+	auto score = 0;
+	for (auto j = 1; j <= int(n); ++j) {
+		auto k = 0;
+		for (auto i = 0; i <= la - j; ++i) {
+			if (b.find(a.data() + i, 0, j) != b.npos)
+				++k;
+			else if (options & NGRAM_WEIGHTED)
+				k -= i == 0 || i == la - j ? 2 : 1;
+		}
+		score += k;
+		if (k < 2 && !(options & NGRAM_WEIGHTED))
+			break;
+	}
+	auto diff = 0;
+	if (options & NGRAM_LONGER_WORSE)
+		diff = lb - la - 2;
+	if (options & NGRAM_ANY_MISMATCH)
+		diff = abs(lb - la) - 2;
+	return score - max(diff, 0);
+}
+
+/**
+ * @brief Gets the length of the common beginning, the first character of b
+ * can be in upper case.
+ */
+template <class CharT>
+auto left_common_length(const basic_string<CharT>& a,
+                        const basic_string<CharT>& b, const locale& loc)
+    -> int
+{
+	if (a.empty() || b.empty())
+		return 0;
+	if (a[0] != b[0] && a[0] != to_lower(b.substr(0, 1), loc)[0])
+		return 0;
+	auto i = size_t(1);
+	while (i != a.size() && i != b.size() && a[i] == b[i])
+		++i;
+	return int(i);
+}
+
+/**
+ * @brief Gets the length of the longest common subsequence.
+ */
+template <class CharT>
+auto lcs_length(const basic_string<CharT>& a, const basic_string<CharT>& b)
+    -> int
+{
+	auto row = vector<int>(b.size() + 1);
+	for (auto c : a) {
+		auto diagonal = 0;
+		for (size_t j = 0; j != b.size(); ++j) {
+			auto up = row[j + 1];
+			row[j + 1] = c == b[j] ? diagonal + 1 : max(up, row[j]);
+			diagonal = up;
+		}
+	}
+	return row.back();
+}
+
+/**
+ * @brief Tests if an affix can be added to a word, as in Hunspell.
+ */
+template <class AffixT, class CharT>
+auto can_derive(const AffixT& a, const basic_string<CharT>& w,
+                bool fullstrip) -> bool
+{
+	using boost::algorithm::ends_with;
+	using boost::algorithm::starts_with;
+	auto& strip = a.stripping;
+	auto fits = is_same<AffixT, Prefix<CharT>>::value
+	                ? starts_with(w, strip)
+	                : ends_with(w, strip);
+	return fits && (w.size() > strip.size() || fullstrip) &&
+	       a.check_condition(w);
+}
+
+/**
+ * @brief Scores the forms of the roots most similar to a word, as the n-gram
+ * suggestions of Hunspell do.
+ *
+ * The candidate roots are looked up in the n-gram index by the lower case of
+ * the word and in the phonetic index by its code. They are scored by common
+ * substrings, then expanded with the affixes of their flags whose added
+ * part is in the word, and the forms that score over a threshold are scored
+ * again by the longest common subsequence, the common substrings of two
+ * characters and the swaps of characters. A form with the same characters
+ * as the word in other case scores over 1000, a poor form under -100.
+ *
+ * The roots with the most similar phonetic code are ranked separately.
+ *
+ * @param word the misspelled word in lower case.
+ * @param guesses the forms with their scores, best first.
+ * @param phonetic the roots with their scores by similarity of the phonetic
+ * code, best first, they do not go under -100.
+ */
+template <class CharT>
+auto ngram_guesses(const Dictionary& dic, const basic_string<CharT>& word,
+                   vector<pair<int, basic_string<CharT>>>& guesses,
+                   vector<pair<int, basic_string<CharT>>>& phonetic)
+    -> void
+{
+	using StrT = basic_string<CharT>;
+	using StrV = my_string_view<CharT>;
+	// as in Hunspell
+	const size_t MAX_ROOTS = 100;
+	const size_t MAX_GUESSES = 200;
+	auto& d = dic.get_structures<CharT>();
+	auto& loc = dic.locale_aff;
+	auto& table = d.phonetic_table;
+	guesses.clear();
+	phonetic.clear();
+
+	// As in Hunspell, a word with characters outside the Basic
+	// Multilingual Plane is compared with all the words by the bytes of
+	// UTF-8, without the measures that need whole characters.
+	auto bytes = any_of(begin(word), end(word), [](CharT c) {
+		return char_traits<CharT>::to_int_type(c) > 0xFFFF;
+	});
+	auto text = [&](const StrT& x) {
+		if (!bytes)
+			return to_lower(x, loc);
+		auto ret = StrT();
+		for (unsigned char c : to_dict_encoding(x))
+			ret.push_back(CharT(c));
+		return ret;
+	};
+	auto left_common = [&](const StrT& a, const StrT& b) {
+		return bytes ? 0 : left_common_length(a, b, loc);
+	};
+	auto w = text(word);
+	auto n = int(w.size());
+
+	auto found = vector<StrT>();
+	if (bytes)
+		for (auto&& x : dic.words)
+			found.push_back(from_dict_to_wide_encoding<CharT>(
+			    string(x.first.data(), x.first.size())));
+	else
+		dic.get_ngram_index<CharT>().lookup(word, MAX_ROOTS, found);
+	auto code = StrT();
+	if (!table.empty() && !bytes) {
+		code = table.phonetic_code(to_upper(word, loc));
+		auto same_code = vector<StrT>();
+		dic.get_phonetic_index<CharT>().lookup(code, same_code);
+		for (auto& x : same_code)
+			if (find(begin(found), end(found), x) == end(found))
+				found.push_back(move(x));
+	}
+	// the guesses of equal score stay in the order of their roots
+	sort(begin(found), end(found));
+	found.erase(unique(begin(found), end(found)), end(found));
+
+	struct Root {
+		StrT word;
+		Flag_Set flags;
+		vector<StrT> pronunciations;
+		int score;
+	};
+	auto roots = vector<Root>();
+	auto phonetic_roots = vector<pair<int, StrT>>();
+	auto score_root = [&](const StrT& r) {
+		return ngram_score(3, w, text(r), NGRAM_LONGER_WORSE) +
+		       left_common(word, r);
+	};
+	for (auto& r : found) {
+		auto dict_r = to_dict_encoding(r);
+		auto prons = vector<StrT>();
+		auto p = equal_range(
+		    begin(dic.pronunciations), end(dic.pronunciations),
+		    make_pair(dict_r, string()),
+		    [](auto& a, auto& b) { return a.first < b.first; });
+		for (; p.first != p.second; ++p.first)
+			prons.push_back(
+			    from_dict_to_wide_encoding<CharT>(p.first->second));
+		auto score = score_root(r);
+		for (auto& x : prons)
+			score = max(score, score_root(x));
+		auto homonyms = dic.words.equal_range(r);
+		auto usable = homonyms.first == homonyms.second;
+		if (usable) // an affixed form
+			roots.push_back({r, {}, prons, score});
+		for (; homonyms.first != homonyms.second; ++homonyms.first) {
+			auto& flags = (*homonyms.first).second;
+			if (flags.contains(dic.forbiddenword_flag) ||
+			    flags.contains(dic.nosuggest_flag) ||
+			    flags.contains(dic.compound_onlyin_flag) ||
+			    flags.contains(HIDDEN_HOMONYM_FLAG))
+				continue;
+			roots.push_back({r, flags, prons, score});
+			usable = true;
+		}
+		if (usable && !code.empty() && score > 2 &&
+		    abs(n - int(text(r).size())) <= 3) {
+			auto r_code = table.phonetic_code(to_upper(r, loc));
+			phonetic_roots.emplace_back(
+			    2 * ngram_score(3, code, r_code,
+			                    NGRAM_LONGER_WORSE),
+			    r);
+		}
+	}
+	stable_sort(begin(roots), end(roots),
+	            [](auto& a, auto& b) { return a.score > b.score; });
+	if (roots.size() > MAX_ROOTS)
+		roots.resize(MAX_ROOTS);
+
+	// the average score of the word with every fourth character replaced
+	auto threshold = 0;
+	for (auto start = 1; start != 4; ++start) {
+		auto mangled = w;
+		for (auto i = start; i < n; i += 4)
+			mangled[i] = '*';
+		threshold += ngram_score(n, w, mangled, NGRAM_ANY_MISMATCH);
+	}
+	threshold = threshold / 3 - 1;
+
+	// the forms of the roots with the affixes whose added part is in the
+	// word, as pairs of the form to score, which can be made from a
+	// pronunciation, and the form
+	auto forms = vector<pair<StrT, StrT>>();
+	auto crossable = vector<StrT>(); // the suffixed forms
+	auto scored = vector<pair<int, pair<StrT, StrT>>>();
+	auto is_bound = [&](const Flag_Set& cont) {
+		return cont.contains(dic.need_affix_flag) ||
+		       cont.contains(dic.circumfix_flag) ||
+		       cont.contains(dic.compound_onlyin_flag);
+	};
+	for (auto& root : roots) {
+		auto& r = root.word;
+		auto& flags = root.flags;
+		forms.clear();
+		crossable.clear();
+		if (!flags.contains(dic.need_affix_flag) &&
+		    !flags.contains(dic.compound_onlyin_flag)) {
+			forms.emplace_back(r, r);
+			for (auto& x : root.pronunciations)
+				forms.emplace_back(x, r);
+		}
+		// the empty suffix and the ends of the word
+		for (size_t i = 1; i <= word.size(); ++i) {
+			auto range =
+			    d.suffixes.equal_range(StrV(word).substr(i));
+			for (auto it = range.first; it != range.second; ++it) {
+				auto& a = *it;
+				if (!flags.contains(a.flag) ||
+				    is_bound(a.cont_flags) ||
+				    !can_derive(a, r, dic.fullstrip))
+					continue;
+				auto f = a.to_derived_copy(r);
+				for (auto& x : root.pronunciations)
+					forms.emplace_back(x + a.appending, f);
+				if (a.cross_product)
+					crossable.push_back(f);
+				forms.emplace_back(f, f);
+			}
+		}
+		// the empty prefix and the beginnings of the word
+		for (size_t i = 0; i < word.size(); ++i) {
+			auto range =
+			    d.prefixes.equal_range(StrV(word).substr(0, i));
+			for (auto it = range.first; it != range.second; ++it) {
+				auto& a = *it;
+				if (!flags.contains(a.flag))
+					continue;
+				for (auto& f : crossable) {
+					if (!a.cross_product ||
+					    !can_derive(a, f, dic.fullstrip))
+						continue;
+					auto g = a.to_derived_copy(f);
+					forms.emplace_back(g, g);
+				}
+				if (is_bound(a.cont_flags) ||
+				    !can_derive(a, r, dic.fullstrip))
+					continue;
+				auto f = a.to_derived_copy(r);
+				forms.emplace_back(f, f);
+			}
+		}
+		for (auto& f : forms) {
+			auto sc = ngram_score(n, w, text(f.first),
+			                      NGRAM_ANY_MISMATCH) +
+			          left_common(word, f.first);
+			if (sc > threshold)
+				scored.emplace_back(sc, move(f));
+		}
+	}
+	auto by_score = [](auto& a, auto& b) { return a.first > b.first; };
+	stable_sort(begin(scored), end(scored), by_score);
+	if (scored.size() > MAX_GUESSES)
+		scored.resize(MAX_GUESSES);
+
+	// scored again by similarity
+	auto fact = 1.0;
+	if (dic.max_diff_factor >= 0)
+		fact = (10.0 - dic.max_diff_factor) / 5.0;
+	for (auto& s : scored) {
+		auto g = text(s.second.first);
+		auto len = int(g.size());
+		auto lcs = lcs_length(w, g);
+		// only the same characters in other case, as in Hunspell the
+		// rest keep the first score
+		if (n == len && n == lcs) {
+			s.first += 2000;
+			break;
+		}
+		auto re = ngram_score(2, w, g,
+		                      NGRAM_ANY_MISMATCH | NGRAM_WEIGHTED) +
+		          ngram_score(2, g, w,
+		                      NGRAM_ANY_MISMATCH | NGRAM_WEIGHTED);
+		auto same_pos = 0;
+		auto diff_pos = vector<size_t>();
+		auto common = bytes ? size_t(0) : min(w.size(), g.size());
+		for (size_t i = 0; i != common; ++i) {
+			if (w[i] == g[i])
+				++same_pos;
+			else
+				diff_pos.push_back(i);
+		}
+		auto is_swap = n == len && diff_pos.size() == 2 &&
+		               w[diff_pos[0]] == g[diff_pos[1]] &&
+		               w[diff_pos[1]] == g[diff_pos[0]];
+		auto limit = table.empty() ? n + len : len;
+		s.first = 2 * lcs - abs(n - len) + left_common(w, g) +
+		          (same_pos ? 1 : 0) + (is_swap ? 10 : 0) +
+		          ngram_score(4, w, g, NGRAM_ANY_MISMATCH) + re +
+		          (re < limit * fact ? -1000 : 0);
+	}
+	stable_sort(begin(scored), end(scored), by_score);
+	for (auto& s : scored)
+		guesses.emplace_back(s.first, move(s.second.second));
+
+	for (auto& p : phonetic_roots) {
+		auto g = to_lower(p.second, loc);
+		auto len = int(g.size());
+		p.first += 2 * lcs_length(w, g) - abs(n - len) +
+		           left_common_length(w, g, loc);
+	}
+	stable_sort(begin(phonetic_roots), end(phonetic_roots), by_score);
+	phonetic = move(phonetic_roots);
+}
+
+/**
+ * @brief Adds the splits into two words.
+ *
+ * As in Hunspell, the words are also joined with a dash if the TRY
+ * characters have a or a dash and both are longer than one character,
+ * e.g. rottenday -> rotten day, rotten-day.
+ */
+template <class CharT>
+auto two_words_candidates(const basic_string<CharT>& w,
+                          const basic_string<CharT>& try_chars,
+                          Candidate_Buffer<CharT>& out) -> void
+{
+	auto dash = try_chars.find_first_of(LITERAL(CharT, "a-")) !=
+	            try_chars.npos;
+	// the words keep their casing, e.g. fooBar -> foo Bar
+	for (size_t i = 1; i < w.size(); ++i) {
+		auto c = basic_string<CharT>(w).insert(i, 1, ' ');
+		out.add(c, true);
+		if (dash && i > 1 && w.size() - i > 1) {
+			c[i] = '-';
+			out.add(move(c), true);
+		}
+	}
+}
+} // namespace
+
+/**
+ * Checks if a candidate is a valid suggestion.
+ *
+ * The candidate is spelled with its casing and must not be forbidden or
+ * marked with NOSUGGEST. Candidates with spaces are checked word by word,
+ * those with a break pattern also by the parts around it.
+ *
+ * @param s the candidate.
+ * @param exact_casing true if the candidate must be in the dictionary in
+ * the same casing, not only as a hidden homonym.
+ * @return true if the candidate can be suggested.
+ */
+template <class CharT>
+auto Dictionary::check_suggestion(const std::basic_string<CharT>& s,
+                                  bool exact_casing) -> bool
+{
+	auto i = s.find(' ');
+	if (i != s.npos) {
+		auto first = s.substr(0, i);
+		// the first word can end a sentence, e.g. permanent. Vacation
+		if (first.size() > 1 && first.back() == '.' &&
+		    !check_suggestion(first, exact_casing))
+			first.pop_back();
+		return check_suggestion(first, exact_casing) &&
+		       check_suggestion(s.substr(i + 1), exact_casing);
+	}
+	if (s.empty())
+		return false;
+	auto word = s;
+	auto res = exact_casing ? checkword(word) : spell_casing(word);
+	if (!res) {
+		// the parts around a break pattern, as in spell_break()
+		auto& break_table = get_structures<CharT>().break_table;
+		for (auto& pat : break_table.middle_word_breaks()) {
+			i = s.find(pat);
+			if (i == 0 || i == s.npos || i + pat.size() >= s.size())
+				continue;
+			if (check_suggestion(s.substr(0, i), exact_casing) &&
+			    check_suggestion(s.substr(i + pat.size()),
+			                     exact_casing))
+				return true;
+		}
+		return false;
+	}
+	if (exact_casing && res->contains(HIDDEN_HOMONYM_FLAG))
+		return false;
+	if (res->contains(forbiddenword_flag) ||
+	    res->contains(nosuggest_flag))
+		return false;
+	if (forbid_warn && res->contains(warn_flag))
+		return false;
+	return true;
+}
+
+/**
+ * Suggests corrections of a word in the intermediate encoding.
+ *
+ * The strategies run in the order of Suggest_Strategy, which is the order
+ * of priority of the kinds of edits. Each adds its edits of the word to one
+ * deduplicated buffer, and the new candidates are verified before the next
+ * strategy runs, so the suggestions found are kept when the search stops at
+ * the deadline or when there are enough of them. The edits are changes of
+ * case, REP, MAP, swaps of characters, KEY, removals of characters,
+ * insertions and substitutions of TRY characters, moves of characters,
+ * removals of repeated pairs and splits into two words. The work is also
+ * limited by suggest_budget.
+ *
+ * If the delete index is built, the words near the misspelled word are
+ * looked up in it instead of generating the edits of single characters.
+ * Otherwise the same is done with the word trie if it is built. If no
+ * change of case, REP or MAP gave a suggestion, the most similar forms of
+ * the roots found by the n-gram index are suggested as in Hunspell, up to
+ * MAXNGRAMSUGS or 4 if it is not set, and then up to two roots with the
+ * most similar phonetic code. The n-gram and phonetic indexes are built
+ * then if they are not, unless MAXNGRAMSUGS is 0 and neither is built. As
+ * in Hunspell, a word with characters outside the Basic Multilingual Plane
+ * gets only these suggestions.
+ *
+ * @param word the misspelled word.
+ * @param out the suggestions, in dictionary encoding after OCONV.
+ * @param deadline time when the search stops.
+ * @return which strategies completed.
+ */
+template <class CharT>
+auto Dictionary::suggest_priv(std::basic_string<CharT> word,
+                              std::vector<std::basic_string<CharT>>& out,
+                              chrono::steady_clock::time_point deadline)
+    -> Suggest_Report
+{
+	using clock = chrono::steady_clock;
+	using StrT = basic_string<CharT>;
+	auto start = clock::now();
+	auto& d = get_structures<CharT>();
+	auto& b = suggest_budget;
+	if (b.max_seconds > 0) {
+		auto budget = chrono::duration<double>(b.max_seconds);
+		deadline = min(deadline, start + chrono::duration_cast<
+		                                     clock::duration>(budget));
+	}
+	auto report = Suggest_Report();
+	out.clear();
+
+	size_t MAXWORDLENGTH = 180;
+	if (word.empty() || word.size() >= MAXWORDLENGTH)
+		return report;
+	d.input_substr_replacer.replace(word);
+
+	auto buf = Candidate_Buffer<CharT>(word, locale_aff, b.max_candidates);
+	auto casing = classify_casing(word, locale_aff);
+	auto enough = [&]() {
+		auto m = b.max_suggestions;
+		return m != 0 && out.size() >= m;
+	};
+	size_t checked = 0;
+	auto stopped = false;
+	auto check_candidate = [&](size_t i) {
+		return check_suggestion(buf.data()[i], !buf.is_lenient(i));
+	};
+	auto accept = [&](const StrT& c) {
+		if (find(begin(out), end(out), c) != end(out))
+			return false;
+		out.push_back(c);
+		return true;
+	};
+	// The recasing as the misspelled word can be wrong for the word found,
+	// e.g. with KEEPCASE, then it is tried as lower case and title case.
+	auto dictionary_casing = [&](const StrT& c) {
+		auto& loc = locale_aff;
+		for (auto& t : {to_lower(c, loc), to_title(c, loc)})
+			if (t != c && t != word && check_suggestion(t))
+				return t;
+		return StrT();
+	};
+	// verifies the new candidates, true if all of them were verified
+	auto verify = [&](size_t max_added) {
+		auto& cands = buf.data();
+		for (size_t added = 0; checked != cands.size(); ++checked) {
+			if (enough() || added == max_added)
+				break;
+			if (clock::now() >= deadline) {
+				stopped = report.timed_out = true;
+				break;
+			}
+			auto& c = cands[checked];
+			if (check_candidate(checked)) {
+				if (accept(c))
+					++added;
+			}
+			else if (buf.was_recased(checked)) {
+				auto t = dictionary_casing(c);
+				if (!t.empty() && accept(t))
+					++added;
+			}
+		}
+		if (enough())
+			stopped = true;
+		if (checked == cands.size())
+			return true;
+		if (stopped)
+			return false;
+		// the rest is over the limit of the strategy
+		checked = cands.size();
+		return true;
+	};
+	// if a change of case, REP or MAP gave a suggestion
+	auto good_edit = false;
+	auto run = [&](Suggest_Strategy s, auto generate,
+	               size_t max_added = -1) {
+		if (!stopped && clock::now() >= deadline)
+			stopped = report.timed_out = true;
+		if (stopped) {
+			report.completed[s] = false;
+			return;
+		}
+		auto old_size = out.size();
+		generate();
+		if (!verify(max_added) || buf.full())
+			report.completed[s] = false;
+		if (s <= SUGGEST_MAP && out.size() != old_size)
+			good_edit = true;
+	};
+
+	auto& index = get_delete_index<CharT>();
+	auto& trie = get_word_trie<CharT>();
+	auto generate = [&](const StrT& w) {
+		run(SUGGEST_REP, [&]() { rep_candidates(w, d, buf); });
+		run(SUGGEST_MAP, [&]() { map_candidates(w, d, buf); });
+		if (!index.empty() || !trie.empty()) {
+			// the index replaces the edits of single characters
+			run(SUGGEST_INDEX, [&]() {
+				if (!index.empty())
+					index_candidates(w, index, buf);
+				else
+					index_candidates(w, trie, buf);
+			});
+			run(SUGGEST_KEY,
+			    [&]() { key_candidates(w, locale_aff, d, buf); });
+			return;
+		}
+		run(SUGGEST_SWAP, [&]() { swap_candidates(w, buf); });
+		run(SUGGEST_KEY,
+		    [&]() { key_candidates(w, locale_aff, d, buf); });
+		run(SUGGEST_EXTRA_CHAR,
+		    [&]() { extra_char_candidates(w, buf); });
+		run(SUGGEST_FORGOT_CHAR,
+		    [&]() { forgot_char_candidates(w, d, buf); });
+		run(SUGGEST_MOVE_CHAR, [&]() { move_char_candidates(w, buf); });
+		run(SUGGEST_BAD_CHAR,
+		    [&]() { bad_char_candidates(w, d, buf); });
+		run(SUGGEST_DOUBLE_TWO_CHARS,
+		    [&]() { double_two_chars_candidates(w, buf); });
+	};
+	// the edits of the lower case, in the casing of the word if it starts
+	// with a capital, e.g. fOO -> foo, BAr -> Bar
+	auto base = word;
+	auto recase = casing == Casing::PASCAL ? Casing::INIT_CAPITAL : casing;
+	if (casing == Casing::CAMEL)
+		recase = Casing::SMALL;
+	if (casing != Casing::SMALL)
+		base = to_lower(word, locale_aff);
+	// As in Hunspell, a word with characters outside the Basic
+	// Multilingual Plane gets only the n-gram suggestions.
+	auto outside_bmp = any_of(begin(word), end(word), [](CharT c) {
+		return char_traits<CharT>::to_int_type(c) > 0xFFFF;
+	});
+	if (!outside_bmp) {
+		run(SUGGEST_CASE, [&]() {
+			case_candidates(word, casing, locale_aff, buf);
+		});
+		generate(word);
+	}
+	if (!outside_bmp && casing != Casing::SMALL) {
+		buf.set_recase(recase);
+		run(SUGGEST_CASE, [&]() {
+			// The lower case in the casing of the word, e.g.
+			// İmply -> Imply. If that is the word, then only the
+			// lower case can be right, e.g. Foo -> foo with
+			// KEEPCASE.
+			buf.add(base);
+			buf.set_recase(Casing::SMALL);
+			if (to_title(base, locale_aff) == word ||
+			    to_upper(base, locale_aff) == word)
+				buf.add(base);
+			buf.set_recase(recase);
+		});
+		generate(base);
+		buf.set_recase(Casing::SMALL);
+	}
+	run(SUGGEST_TWO_WORDS, [&]() {
+		if (!no_split_suggestions && !outside_bmp)
+			two_words_candidates(word, d.try_chars, buf);
+	});
+
+	// As in Hunspell, the n-gram and phonetic suggestions are made if no
+	// good edit was found. They are made of the lower case and then put in
+	// the casing of the word, e.g. unesco's -> UNESCO's, Unesco's ->
+	// UNESCO's, and they are not given if they contain an earlier one.
+	if (!good_edit && (max_ngram_suggestions != 0 ||
+	                   !get_ngram_index<CharT>().empty() ||
+	                   !get_phonetic_index<CharT>().empty())) {
+		build_ngram_indexes_once();
+		size_t max_ngrams = max_ngram_suggestions > 0
+		                        ? max_ngram_suggestions
+		                        : 4;
+		const size_t MAX_PHONETIC_SUGGESTIONS = 2;
+		auto guesses = vector<pair<int, StrT>>();
+		auto phonetic = vector<pair<int, StrT>>();
+		if (!stopped)
+			ngram_guesses(*this, base, guesses, phonetic);
+		auto in_casing = [&](StrT g) {
+			if (casing == Casing::ALL_CAPITAL)
+				return to_upper(g, locale_aff);
+			if (recase == Casing::INIT_CAPITAL && !g.empty())
+				g.replace(0, 1,
+				          to_upper(g.substr(0, 1), locale_aff));
+			return g;
+		};
+		// adds the guesses that are correct and do not contain one
+		// of the earlier suggestions, compared in lower case
+		auto add_guesses = [&](const vector<pair<int, StrT>>& v,
+		                       size_t max) {
+			auto taken = vector<StrT>();
+			for (auto& t : out)
+				taken.push_back(to_lower(t, locale_aff));
+			auto same = false;
+			for (auto& x : v) {
+				if (taken.size() - out.size() == max)
+					break;
+				auto score = x.first;
+				if (same && score <= 1000)
+					continue;
+				if (score > 1000) {
+					same = true;
+				}
+				else if (score < -100) {
+					// only excellent guesses or the best
+					same = true;
+					if (taken.size() != out.size() ||
+					    only_max_diff)
+						continue;
+				}
+				auto& g = x.second;
+				auto c = in_casing(g);
+				auto lower_g = to_lower(g, locale_aff);
+				auto contains = [&](const StrT& t) {
+					return lower_g.find(t) != lower_g.npos;
+				};
+				auto has_earlier =
+				    any_of(begin(taken), end(taken), contains);
+				if (has_earlier || !check_suggestion(g, true))
+					continue;
+				taken.push_back(move(lower_g));
+				buf.add(c, c != g);
+			}
+		};
+		buf.set_recase(Casing::SMALL);
+		run(SUGGEST_NGRAM, [&]() { add_guesses(guesses, max_ngrams); },
+		    max_ngrams);
+		run(SUGGEST_PHONETIC,
+		    [&]() { add_guesses(phonetic, MAX_PHONETIC_SUGGESTIONS); },
+		    MAX_PHONETIC_SUGGESTIONS);
+	}
+	for (auto& s : out)
+		d.output_substr_replacer.replace(s);
+	report.candidates = buf.data().size();
+	report.seconds = chrono::duration<double>(clock::now() - start).count();
+	return report;
+}
+template auto Dictionary::suggest_priv(string word, vector<string>& out,
+                                       chrono::steady_clock::time_point)
+    -> Suggest_Report;
+template auto Dictionary::suggest_priv(wstring word, vector<wstring>& out,
+                                       chrono::steady_clock::time_point)
+    -> Suggest_Report;
+
+/**
+ * Suggests corrections of a misspelled word.
+ *
+ * @param word the misspelled word, in the encoding of loc.
+ * @param out the suggestions, in the encoding of loc, best first.
+ * @param loc locale of the encoding of the word and of the suggestions.
+ */
+auto Dictionary::suggest(const std::string& word, std::vector<std::string>& out,
+                         std::locale loc) -> void
+{
+	suggest(word, out, chrono::steady_clock::time_point::max(), loc);
+}
+
+/**
+ * Suggests corrections of a misspelled word until a deadline.
+ *
+ * The suggestions found until the deadline are returned, best first. The
+ * cheap strategies run first, so usually only the n-gram and phonetic
+ * suggestions are lost with a short deadline.
+ *
+ * @param word the misspelled word, in the encoding of loc.
+ * @param out the suggestions, in the encoding of loc, best first.
+ * @param deadline time when the search stops.
+ * @param loc locale of the encoding of the word and of the suggestions.
+ * @return which strategies completed and if the deadline was reached.
+ */
+auto Dictionary::suggest(const std::string& word, std::vector<std::string>& out,
+                         std::chrono::steady_clock::time_point deadline,
+                         std::locale loc) -> Suggest_Report
+{
+	using info_t = boost::locale::info;
+	auto& dic_info = use_facet<info_t>(locale_aff);
+	auto report = Suggest_Report();
+	out.clear();
+	if (dic_info.utf8()) {
+		auto sugs = vector<wstring>();
+		report = suggest_priv(Locale_Input::cvt_for_u8_dict(word, loc),
+		                      sugs, deadline);
+		for (auto& s : sugs)
+			out.push_back(Locale_Output::cvt_from_u8_dict(s, loc));
+	}
+	else {
+		auto sugs = vector<string>();
+		report = suggest_priv(
+		    Locale_Input::cvt_for_byte_dict(word, loc, locale_aff),
+		    sugs, deadline);
+		for (auto& s : sugs)
+			out.push_back(Locale_Output::cvt_from_byte_dict(
+			    s, loc, locale_aff));
+	}
+	return report;
+}
+
+/**
+ * Suggests corrections of many misspelled words.
+ *
+ * The words are spread over suggest_threads threads, each word is
+ * corrected on one thread. The suggestions are the same as those of
+ * suggest() for each word, except when suggest_budget stops the search of a
+ * word by time, as then they depend on how fast the threads run.
+ *
+ * @param words the misspelled words, in the encoding of loc.
+ * @param out the suggestions for each word, in the encoding of loc.
+ * @param loc locale of the encoding of the words and of the suggestions.
+ */
+auto Dictionary::suggest_batch(const std::vector<std::string>& words,
+                               std::vector<std::vector<std::string>>& out,
+                               std::locale loc) -> void
+{
+	out.assign(words.size(), {});
+	auto threads = checkword_stats ? 1 : max<size_t>(suggest_threads, 1);
+	atomic<size_t> next(0);
+	auto never = chrono::steady_clock::time_point::max();
+	auto worker = [&]() {
+		for (size_t i; (i = next++) < words.size();)
+			suggest(words[i], out[i], never, loc);
+	};
+	auto results = vector<future<void>>();
+	for (size_t i = 1; i < min(threads, words.size()); ++i)
+		results.push_back(async(launch::async, worker));
+	worker();
+	for (auto& r : results)
+		r.get();
+}
+
+/**
+ * Gets the name of a strategy of suggest(), for reports.
+ */
+auto suggest_strategy_name(Suggest_Strategy strategy) -> const char*
+{
+	static const char* names[] = {"case",
+	                              "rep",
+	                              "map",
+	                              "index",
+	                              "swap_char",
+	                              "key",
+	                              "extra_char",
+	                              "forgot_char",
+	                              "move_char",
+	                              "bad_char",
+	                              "double_two_chars",
+	                              "two_words",
+	                              "ngram",
+	                              "phonetic"};
+	static_assert(sizeof(names) / sizeof(names[0]) == SUGGEST_STRATEGIES,
+	              "a name for each strategy");
+	return names[strategy];
+}
+
+/**
+ * Builds the delete index used by suggest().
+ *
+ * With the index, the words within the edit distance are looked up instead
+ * of checking every edit of one character of a misspelled word. Only the
+ * forms in the index are found that way, so without affixed forms the
+ * inflections of a misspelled word are suggested only by REP, MAP and KEY.
+ *
+ * @param max_distance maximal edit distance of the suggested words, the
+ * memory of the index grows quickly with it.
+ * @param affixed true to also index the forms with one affix.
+ */
+auto Dictionary::build_delete_index(size_t max_distance, bool affixed) -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		wide_delete_index.build(index_words<wchar_t>(*this, affixed),
+		                        max_distance);
+	else
+		delete_index.build(index_words<char>(*this, affixed),
+		                   max_distance);
+}
+
+/**
+ * Builds the n-gram index used by suggest().
+ *
+ * With the index, the roots most similar to a misspelled word are found
+ * without scanning all words, by the lower case and the ph: fields. Their
+ * forms are made at lookup with the affixes in the misspelled word.
+ * suggest() builds the index on first use if it is not built.
+ *
+ * @param affixed true to also index the forms with one affix.
+ */
+auto Dictionary::build_ngram_index(bool affixed) -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		wide_ngram_index.build(
+		    ngram_index_words<wchar_t>(*this, affixed));
+	else
+		ngram_index.build(ngram_index_words<char>(*this, affixed));
+}
+
+/**
+ * Builds the n-gram and phonetic indexes that are not built, once.
+ *
+ * Called by suggest() when it first gets to the n-gram suggestions, so the
+ * indexes cost nothing if there are none. Thread-safe with other calls of
+ * suggest().
+ */
+auto Dictionary::build_ngram_indexes_once() -> void
+{
+	lock_guard<mutex> lock(*ngram_indexes_mutex);
+	if (ngram_indexes_built)
+		return;
+	auto utf8 = use_facet<boost::locale::info>(locale_aff).utf8();
+	if (utf8 ? wide_ngram_index.empty() : ngram_index.empty())
+		build_ngram_index();
+	if (utf8 ? wide_phonetic_index.empty() : phonetic_index.empty())
+		build_phonetic_index();
+	ngram_indexes_built = true;
+}
+
+/**
+ * Builds the word trie used by suggest().
+ *
+ * The trie is an alternative to the delete index that needs much less
+ * memory, at the cost of slower lookups for long words. It is used only if
+ * the delete index is not built. The words found are verified as any other
+ * suggestion, so the affixed forms are found only if they are in the trie.
+ *
+ * @param max_distance maximal edit distance of the suggested words.
+ * @param affixed true to also store the forms with one affix.
+ */
+auto Dictionary::build_word_trie(size_t max_distance, bool affixed) -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		wide_word_trie.build(index_words<wchar_t>(*this, affixed),
+		                     max_distance);
+	else
+		word_trie.build(index_words<char>(*this, affixed),
+		                max_distance);
+}
+
+/**
+ * Builds the phonetic index used by suggest().
+ *
+ * The PHONE codes of the words are computed once here. Without a PHONE
+ * table in the affix file the index stays empty. suggest() builds the index
+ * on first use if it is not built.
+ *
+ * @param affixed true to also index the forms with one affix.
+ */
+auto Dictionary::build_phonetic_index(bool affixed) -> void
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		wide_phonetic_index.build(index_words<wchar_t>(*this, affixed),
+		                          wide_structures.phonetic_table,
+		                          locale_aff);
+	else
+		phonetic_index.build(index_words<char>(*this, affixed),
+		                     structures.phonetic_table, locale_aff);
+}
+
+/**
+ * Writes the delete index, see Delete_Index::write().
+ */
+auto Dictionary::write_delete_index(std::ostream& out) const -> bool
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		return wide_delete_index.write(out);
+	return delete_index.write(out);
+}
+
+/**
+ * Reads a delete index written by write_delete_index().
+ *
+ * The index should have been built from the same dictionary.
+ */
+auto Dictionary::read_delete_index(std::istream& in) -> bool
+{
+	if (use_facet<boost::locale::info>(locale_aff).utf8())
+		return wide_delete_index.read(in);
+	return delete_index.read(in);
+}
+} // namespace nuspell
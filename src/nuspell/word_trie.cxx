@@ -0,0 +1,187 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file word_trie.cxx
+ * Trie of words searched within an edit distance.
+ */
+
+#include "word_trie.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
+namespace nuspell {
+
+using namespace std;
+
+/**
+ * Builds the trie.
+ *
+ * @param words the words, duplicates are stored once.
+ * @param max_distance the maximal edit distance of lookups.
+ */
+template <class CharT>
+auto Word_Trie<CharT>::build(const vector<StrT>& words, size_t max_distance)
+    -> void
+{
+	auto t1 = chrono::steady_clock::now();
+	clear();
+	auto sorted = words;
+	sort(begin(sorted), end(sorted));
+	sorted.erase(unique(begin(sorted), end(sorted)), end(sorted));
+	max_dist = max_distance;
+	this->words = sorted.size();
+
+	// each node covers the range of sorted words with its prefix
+	auto ranges = vector<tuple<size_t, size_t, size_t>>();
+	nodes.push_back({0, 0, false});
+	labels.push_back(CharT());
+	ranges.emplace_back(0, sorted.size(), 0);
+	for (size_t n = 0; n != nodes.size(); ++n) {
+		size_t lo, hi, depth;
+		tie(lo, hi, depth) = ranges[n];
+		if (lo != hi && sorted[lo].size() == depth) {
+			nodes[n].is_word = true;
+			++lo;
+		}
+		nodes[n].first_child = nodes.size();
+		while (lo != hi) {
+			auto c = sorted[lo][depth];
+			auto group_end = lo + 1;
+			while (group_end != hi && sorted[group_end][depth] == c)
+				++group_end;
+			nodes.push_back({0, 0, false});
+			labels.push_back(c);
+			ranges.emplace_back(lo, group_end, depth + 1);
+			lo = group_end;
+		}
+		nodes[n].last_child = nodes.size();
+	}
+	nodes.shrink_to_fit();
+	labels.shrink_to_fit();
+	auto t2 = chrono::steady_clock::now();
+	seconds = chrono::duration<double>(t2 - t1).count();
+}
+
+/**
+ * Finds the words within the maximal distance of the trie.
+ *
+ * @param word the misspelled word.
+ * @param out the words, nearest first, in alphabetical order at equal
+ * distance. The word itself is not included.
+ */
+template <class CharT>
+auto Word_Trie<CharT>::lookup(const StrT& word, vector<StrT>& out) const
+    -> void
+{
+	lookup(word, max_dist, out);
+}
+
+/**
+ * Finds the words within a distance.
+ *
+ * @param word the misspelled word.
+ * @param max_distance the distance, at most the one the trie was built for.
+ * @param out the words, nearest first, in alphabetical order at equal
+ * distance. The word itself is not included.
+ */
+template <class CharT>
+auto Word_Trie<CharT>::lookup(const StrT& word, size_t max_distance,
+                              vector<StrT>& out) const -> void
+{
+	out.clear();
+	if (empty())
+		return;
+	max_distance = min(max_distance, max_dist);
+	auto n = word.size();
+	// rows[d] is the row of the table for the prefix of depth d
+	auto rows = vector<vector<size_t>>(1, vector<size_t>(n + 1));
+	for (size_t j = 0; j <= n; ++j)
+		rows[0][j] = j;
+	auto prefix = StrT();
+	auto found = vector<pair<size_t, StrT>>();
+	// stack of nodes to visit with their depth
+	auto stack = vector<pair<uint32_t, size_t>>();
+	auto push_children = [&](uint32_t node, size_t depth) {
+		auto& x = nodes[node];
+		// reversed, so they are popped in alphabetical order
+		for (auto c = x.last_child; c != x.first_child; --c)
+			stack.emplace_back(c - 1, depth + 1);
+	};
+	push_children(0, 0);
+	while (!stack.empty()) {
+		uint32_t node;
+		size_t i;
+		tie(node, i) = stack.back();
+		stack.pop_back();
+		prefix.resize(i - 1);
+		prefix.push_back(labels[node]);
+		if (rows.size() <= i)
+			rows.emplace_back(n + 1);
+		auto& r2 = rows[i];
+		auto& r1 = rows[i - 1];
+		auto c = labels[node];
+		r2[0] = i;
+		auto row_min = r2[0];
+		for (size_t j = 1; j <= n; ++j) {
+			auto cost = c == word[j - 1] ? 0 : 1;
+			r2[j] = min({r1[j] + 1, r2[j - 1] + 1,
+			             r1[j - 1] + cost});
+			if (i > 1 && j > 1 && c == word[j - 2] &&
+			    prefix[i - 2] == word[j - 1])
+				r2[j] = min(r2[j], rows[i - 2][j - 2] + 1);
+			row_min = min(row_min, r2[j]);
+		}
+		if (nodes[node].is_word && r2[n] != 0 && r2[n] <= max_distance)
+			found.emplace_back(r2[n], prefix);
+		if (row_min <= max_distance)
+			push_children(node, i);
+	}
+	// found in alphabetical order, keep it at equal distance
+	stable_sort(begin(found), end(found), [](auto& a, auto& b) {
+		return a.first < b.first;
+	});
+	for (auto& f : found)
+		out.push_back(move(f.second));
+}
+
+template <class CharT>
+auto Word_Trie<CharT>::clear() -> void
+{
+	nodes.clear();
+	labels.clear();
+	max_dist = 0;
+	words = 0;
+	seconds = 0;
+}
+
+/**
+ * Gets the heap memory of the trie in bytes.
+ */
+template <class CharT>
+auto Word_Trie<CharT>::memory_usage() const -> size_t
+{
+	return nodes.capacity() * sizeof(Node) +
+	       labels.capacity() * sizeof(CharT);
+}
+
+template class Word_Trie<char>;
+template class Word_Trie<wchar_t>;
+} // namespace nuspell
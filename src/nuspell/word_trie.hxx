@@ -0,0 +1,82 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file word_trie.hxx
+ * Trie of words searched within an edit distance.
+ */
+
+#ifndef NUSPELL_WORD_TRIE_HXX
+#define NUSPELL_WORD_TRIE_HXX
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Trie of words searched within an edit distance.
+ *
+ * The words near a misspelled word are found with a depth-first traversal
+ * that keeps the rows of the edit distance table of the prefix of the
+ * current node. A branch is left as soon as every entry of the row exceeds
+ * the distance, so the work depends on the length of the word and on the
+ * distance, and only slowly on the number of words.
+ *
+ * The nodes are stored breadth-first, so the children of a node are
+ * consecutive and sorted by their characters. The distance is the optimal
+ * string alignment distance, as for Delete_Index.
+ */
+template <class CharT>
+class Word_Trie {
+      public:
+	using StrT = std::basic_string<CharT>;
+
+      private:
+	struct Node {
+		std::uint32_t first_child;
+		std::uint32_t last_child; // one past the last
+		bool is_word;
+	};
+	std::vector<Node> nodes;
+	StrT labels; // the character of the edge to each node
+	std::size_t max_dist = 0;
+	std::size_t words = 0;
+	double seconds = 0;
+
+      public:
+	auto build(const std::vector<StrT>& words, std::size_t max_distance)
+	    -> void;
+	auto lookup(const StrT& word, std::vector<StrT>& out) const -> void;
+	auto lookup(const StrT& word, std::size_t max_distance,
+	            std::vector<StrT>& out) const -> void;
+	auto clear() -> void;
+
+	auto empty() const { return nodes.empty(); }
+	auto size() const { return words; }
+	auto node_count() const { return nodes.size(); }
+	auto max_distance() const { return max_dist; }
+	auto build_seconds() const { return seconds; }
+	auto memory_usage() const -> std::size_t;
+};
+extern template class Word_Trie<char>;
+extern template class Word_Trie<wchar_t>;
+} // namespace nuspell
+
+#endif // NUSPELL_WORD_TRIE_HXX
@@ -18,9 +18,13 @@
 
 #include "catch.hpp"
 
+#include <cstdint>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 #include "../src/nuspell/aff_data.hxx"
+#include "../src/nuspell/load_stats.hxx"
 
 using namespace std;
 using namespace nuspell;
@@ -38,3 +42,266 @@ TEST_CASE("method get_locale_name", "[aff_data]")
 	CHECK("nl_NL.UTF-8" ==
 	      get_locale_name("nl_NL", "UTF-8", "somefilename"));
 }
+
+namespace {
+auto flags_of(const Aff_Data& a, const string& word)
+{
+	auto ret = vector<u16string>();
+	auto r = a.words.equal_range(word);
+	for (auto it = r.first; it != r.second; ++it)
+		ret.push_back((*it).second.data());
+	return ret;
+}
+} // namespace
+
+TEST_CASE("method parse_dic", "[aff_data]")
+{
+	auto a = Aff_Data();
+	auto aff = istringstream("SET UTF-8\nFLAG long\n");
+	auto dic = istringstream(
+	    "\xEF\xBB\xBF" "5\n"
+	    "hello/AaBb\n"
+	    "a\\/b/Cc\n"
+	    "tab\tpo:noun\n"
+	    "morph st:x\n"
+	    "\n"
+	    "iPod/Aa\n"
+	    "IPOD/Bb");
+	REQUIRE(a.parse_aff(aff));
+	REQUIRE(a.parse_dic(dic));
+	CHECK(flags_of(a, "hello") == vector<u16string>{u"\x4161\x4262"});
+	CHECK(flags_of(a, "a\\/b") == vector<u16string>{u"\x4363"});
+	CHECK(flags_of(a, "tab") == vector<u16string>{u""});
+	CHECK(flags_of(a, "morph") == vector<u16string>{u""});
+	CHECK(flags_of(a, "iPod") == vector<u16string>{u"\x4161"});
+	// the hidden homonym is replaced by the explicit word
+	CHECK(flags_of(a, "IPOD") == vector<u16string>{u"\x4262"});
+	CHECK(a.words.size() == 6);
+
+	auto b = Aff_Data();
+	aff = istringstream("FLAG num\n");
+	dic = istringstream("3\nfoo/1,22 po:x\nbar/3,\nbaz/7\n");
+	REQUIRE(b.parse_aff(aff));
+	REQUIRE(b.parse_dic(dic));
+	CHECK(flags_of(b, "foo") == vector<u16string>{{1, 22}});
+	CHECK(flags_of(b, "bar").empty());
+	CHECK(flags_of(b, "baz") == vector<u16string>{{7}});
+
+	auto c = Aff_Data();
+	aff = istringstream("AF 2\nAF AB\nAF C\n");
+	dic = istringstream("2\nfoo/2\nbar/1\n");
+	REQUIRE(c.parse_aff(aff));
+	REQUIRE(c.parse_dic(dic));
+	CHECK(flags_of(c, "foo") == vector<u16string>{u"C"});
+	CHECK(flags_of(c, "bar") == vector<u16string>{u"AB"});
+
+	auto d = Aff_Data();
+	aff = istringstream("");
+	dic = istringstream("");
+	REQUIRE(d.parse_aff(aff));
+	CHECK_FALSE(d.parse_dic(dic));
+}
+
+TEST_CASE("method parse_dic in parallel", "[aff_data]")
+{
+	// Enough text for several threads. A hidden homonym is often in
+	// another region than its camel case word and an all-caps word later
+	// in the file replaces it.
+	auto dic = "60000\n"s;
+	for (size_t i = 0; i != 15000; ++i) {
+		auto n = to_string(i % 5000);
+		dic += "word" + n + "/A\n";
+		dic += "iPod" + n + "/B\n";
+		dic += "IPOD" + n + "/C\n";
+		dic += "McDonald" + n + "\n";
+	}
+	auto aff = "SET UTF-8\n"s;
+
+	auto seq = Aff_Data();
+	auto par = Aff_Data();
+	auto aff_ss = istringstream(aff);
+	auto dic_ss = istringstream(dic);
+	REQUIRE(seq.parse_aff(aff_ss));
+	REQUIRE(seq.parse_dic(dic_ss, 1));
+	aff_ss = istringstream(aff);
+	dic_ss = istringstream(dic);
+	REQUIRE(par.parse_aff(aff_ss));
+	REQUIRE(par.parse_dic(dic_ss, 4));
+
+	// the words are split in regions, all parsed at load
+	REQUIRE(par.words.is_lazy());
+	auto stats = par.words.lazy_stats();
+	CHECK(stats.regions_materialized == stats.regions);
+	REQUIRE(par.words.size() == seq.words.size());
+	auto mismatches = vector<string>();
+	for (auto&& w : seq.words) {
+		auto word = string(w.first.data(), w.first.size());
+		if (flags_of(par, word) != flags_of(seq, word))
+			mismatches.push_back(word);
+	}
+	CHECK(mismatches.empty());
+	CHECK(flags_of(par, "IPOD7") ==
+	      vector<u16string>{u"C", u"C", u"C"});
+	CHECK(flags_of(par, "MCDONALD7") == vector<u16string>{{u'\xFFFF'}});
+}
+
+TEST_CASE("method parse_dic_lazy", "[aff_data]")
+{
+	auto dic = "4000\n"s;
+	for (size_t i = 0; i != 1000; ++i) {
+		auto n = to_string(i % 300);
+		dic += "word" + n + "/A\n";
+		dic += "iPod" + n + "/B\n";
+		dic += "IPOD" + n + "/C\n";
+		dic += "McDonald" + n + "\n";
+	}
+	auto aff = "SET UTF-8\n"s;
+
+	auto eager = Aff_Data();
+	auto lazy = Aff_Data();
+	auto aff_ss = istringstream(aff);
+	auto dic_ss = istringstream(dic);
+	REQUIRE(eager.parse_aff(aff_ss));
+	REQUIRE(eager.parse_dic(dic_ss));
+	aff_ss = istringstream(aff);
+	dic_ss = istringstream(dic);
+	REQUIRE(lazy.parse_aff(aff_ss));
+	REQUIRE(lazy.parse_dic_lazy(dic_ss));
+	REQUIRE(lazy.words.is_lazy());
+
+	auto stats = lazy.words.lazy_stats();
+	CHECK(stats.regions == 16);
+	CHECK(stats.lines_indexed == 4000);
+	CHECK(stats.regions_materialized == 0);
+	CHECK_FALSE(lazy.words.empty());
+	CHECK(lazy.words.lazy_stats().regions_materialized == 0);
+	CHECK_THROWS_AS(lazy.words.emplace("foo", u"A"), logic_error);
+
+	CHECK(flags_of(lazy, "IPOD7") ==
+	      vector<u16string>{u"C", u"C", u"C", u"C"});
+	CHECK(flags_of(lazy, "MCDONALD7") ==
+	      vector<u16string>{{u'\xFFFF'}});
+	stats = lazy.words.lazy_stats();
+	CHECK(stats.regions_materialized >= 1);
+	CHECK(stats.regions_materialized <= 2);
+
+	REQUIRE(lazy.words.size() == eager.words.size());
+	CHECK(lazy.words.lazy_stats().regions_materialized == 16);
+	CHECK(size_t(distance(lazy.words.begin(), lazy.words.end())) ==
+	      eager.words.size());
+	auto mismatches = vector<string>();
+	for (auto&& w : eager.words) {
+		auto word = string(w.first.data(), w.first.size());
+		if (flags_of(lazy, word) != flags_of(eager, word))
+			mismatches.push_back(word);
+	}
+	CHECK(mismatches.empty());
+
+	// everything is parsed at load
+	auto all = Aff_Data();
+	aff_ss = istringstream(aff);
+	dic_ss = istringstream(dic);
+	REQUIRE(all.parse_aff(aff_ss));
+	REQUIRE(all.parse_dic_lazy(dic_ss, SIZE_MAX));
+	CHECK(all.words.lazy_stats().regions_materialized == 16);
+}
+
+TEST_CASE("load statistics", "[aff_data]")
+{
+	auto aff_text = "SET UTF-8\nPFX A Y 1\nPFX A 0 re .\nSFX B Y 1\n"
+	                "SFX B 0 s .\n";
+	auto dic_text = "4\nhello/AB\niPod/A\nMcDonald\nIPOD/B\n";
+	auto stats = Load_Stats();
+	set_load_stats(&stats);
+	auto a = Aff_Data();
+	auto aff = istringstream(aff_text);
+	auto dic = istringstream(dic_text);
+	REQUIRE(a.parse_aff(aff));
+	REQUIRE(a.parse_dic(dic));
+	set_load_stats(nullptr);
+
+	CHECK(stats.aff_lines == 5);
+	CHECK(stats.prefixes == 1);
+	CHECK(stats.suffixes == 1);
+	CHECK(stats.ctype_facets_installed == 1);
+	CHECK(stats.aff_seconds > 0);
+	CHECK(stats.aff_structures_seconds <= stats.aff_seconds);
+	CHECK(stats.ctype_facets_seconds <= stats.aff_structures_seconds);
+	CHECK(stats.dic_lines == 4);
+	// the hidden homonym of iPod is replaced by IPOD
+	CHECK(stats.words_inserted == 5);
+	CHECK(stats.hidden_homonyms == 1);
+	CHECK(stats.word_count == a.words.size());
+	CHECK(stats.word_buckets >= stats.word_count);
+	CHECK(stats.dic_bytes > 0);
+	CHECK(stats.dic_seconds > 0);
+	CHECK(stats.dic_read_seconds <= stats.dic_seconds);
+
+	// nothing is collected when disabled
+	auto b = Aff_Data();
+	aff = istringstream(aff_text);
+	dic = istringstream(dic_text);
+	REQUIRE(b.parse_aff(aff));
+	REQUIRE(b.parse_dic(dic));
+	CHECK(stats.aff_lines == 5);
+	CHECK(stats.dic_lines == 4);
+	CHECK(get_load_stats() == nullptr);
+}
+
+TEST_CASE("method memory_usage", "[aff_data]")
+{
+	auto aff = istringstream("SET UTF-8\nFLAG long\nPFX Aa Y 1\n"
+	                         "PFX Aa 0 re [^r]\nSFX Bb Y 1\nSFX Bb 0 s .\n"
+	                         "BREAK 1\nBREAK -\nICONV 1\nICONV ' ’\n");
+	auto dic = istringstream("4\nhello/AaBb\nnondescriptive-word/AaBb\n"
+	                         "iPod/Aa\nMcDonaldsRestaurant\n");
+	auto a = Aff_Data();
+	REQUIRE(a.parse_aff(aff));
+	REQUIRE(a.parse_dic(dic));
+
+	auto m = a.memory_usage();
+	CHECK(m.word_buckets > 0);
+	CHECK(m.word_nodes > 0);
+	CHECK(m.word_strings > 0);
+	CHECK(m.word_index == 0);
+	CHECK(m.prefixes > 0);
+	CHECK(m.suffixes > 0);
+	CHECK(m.conditions > 0);
+	CHECK(m.substr_replacers > 0);
+	CHECK(m.break_tables > 0);
+	CHECK(m.flag_sets == a.words.size());
+	// AaBb, Aa, none, and the two hidden homonyms
+	CHECK(m.distinct_flag_sets == 5);
+	CHECK(m.total() > m.word_nodes + m.prefixes + m.suffixes);
+
+	auto compiled = stringstream();
+	REQUIRE(a.write_compiled(compiled));
+	auto b = Aff_Data();
+	REQUIRE(b.parse_compiled(compiled));
+	auto n = b.memory_usage();
+	CHECK(n.flag_sets == a.words.size());
+	CHECK(n.distinct_flag_sets == 5);
+	CHECK(n.word_nodes > 0);
+	CHECK(n.word_strings > 0);
+	CHECK(n.prefixes == m.prefixes);
+}
+
+TEST_CASE("method set_suggest_structures", "[aff_data]")
+{
+	auto aff = istringstream(
+	    "SET UTF-8\nTRY aä\nKEY qwe|asd\nREP 2\nREP ^a_b ab\n"
+	    "REP f ph\nMAP 1\nMAP uü(ue)\n");
+	auto a = Aff_Data();
+	REQUIRE(a.parse_aff(aff));
+	auto& s = a.wide_structures;
+	CHECK(s.try_chars == L"aä");
+	CHECK(s.keyboard_table.size() == 12);
+	CHECK(s.keyboard_table.neighbours(L'w').size() == 2);
+	CHECK(s.replacement_table.size() == 2);
+	auto reps = vector<wstring>();
+	s.replacement_table.replace_each(L"a bf", reps);
+	CHECK(reps == vector<wstring>{L"abf", L"a bph"});
+	REQUIRE(s.map_related_chars.size() == 1);
+	CHECK(s.map_related_chars[0] == vector<wstring>{L"u", L"ü", L"ue"});
+	CHECK(a.structures.try_chars.empty());
+}
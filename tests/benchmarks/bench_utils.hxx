@@ -0,0 +1,228 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_utils.hxx
+ * Timing and reporting helpers shared by the benchmarks.
+ */
+
+#ifndef NUSPELL_BENCH_UTILS_HXX
+#define NUSPELL_BENCH_UTILS_HXX
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuspell {
+
+/**
+ * @brief Times of repeated calls of a function over a list of inputs.
+ *
+ * The latencies are in nanoseconds, sorted.
+ */
+struct Call_Timing {
+	size_t calls = 0;
+	double seconds = 0;
+	std::vector<double> latencies;
+};
+
+/**
+ * @brief Times calls of f for each element of the inputs.
+ *
+ * The list is passed over repeatedly until at least min_calls calls. The
+ * time of the passes is the best of the repeats. The latencies are from one
+ * extra pass that times each call.
+ *
+ * @param f function that returns a value convertible to size_t, the values
+ * are summed up so the calls are not optimized away.
+ */
+template <class Input, class Func>
+auto time_calls(const std::vector<Input>& inputs, size_t min_calls,
+                int repeats, Func f) -> Call_Timing
+{
+	using namespace std;
+	using clock = chrono::steady_clock;
+	static volatile size_t sink;
+	auto ret = Call_Timing();
+	if (inputs.empty())
+		return ret;
+	auto passes = (min_calls + inputs.size() - 1) / inputs.size();
+	size_t n = 0;
+	auto best = chrono::duration<double>::max();
+	for (int i = 0; i != repeats; ++i) {
+		auto t1 = clock::now();
+		for (size_t p = 0; p != passes; ++p)
+			for (auto& x : inputs)
+				n += f(x);
+		auto t2 = clock::now();
+		best = min(best, chrono::duration<double>(t2 - t1));
+	}
+	ret.latencies.reserve(passes * inputs.size());
+	for (size_t p = 0; p != passes; ++p) {
+		for (auto& x : inputs) {
+			auto t1 = clock::now();
+			n += f(x);
+			auto t2 = clock::now();
+			auto ns = chrono::duration<double, nano>(t2 - t1);
+			ret.latencies.push_back(ns.count());
+		}
+	}
+	sink = sink + n;
+	sort(begin(ret.latencies), end(ret.latencies));
+	ret.calls = passes * inputs.size();
+	ret.seconds = best.count();
+	return ret;
+}
+
+/**
+ * @brief Gets the value at quantile q, between 0 and 1, of sorted values.
+ */
+inline auto percentile(const std::vector<double>& sorted, double q) -> double
+{
+	if (sorted.empty())
+		return 0;
+	auto i = size_t(q * (sorted.size() - 1) + 0.5);
+	return sorted[i];
+}
+
+/**
+ * @brief Latency percentiles, in nanoseconds.
+ *
+ * The quantiles are the sorted latencies reduced to QUANTILES evenly spaced
+ * points, they are used to merge the latencies of several runs.
+ */
+struct Latency_Summary {
+	enum { QUANTILES = 1001 };
+	double p50 = 0, p90 = 0, p99 = 0, max = 0;
+	std::vector<double> quantiles;
+
+	auto set_percentiles() -> void
+	{
+		p50 = percentile(quantiles, 0.50);
+		p90 = percentile(quantiles, 0.90);
+		p99 = percentile(quantiles, 0.99);
+	}
+};
+
+inline auto summarize_latencies(const std::vector<double>& sorted)
+    -> Latency_Summary
+{
+	auto ret = Latency_Summary();
+	if (sorted.empty())
+		return ret;
+	ret.quantiles.resize(ret.QUANTILES);
+	for (size_t i = 0; i != ret.QUANTILES; ++i)
+		ret.quantiles[i] =
+		    percentile(sorted, double(i) / (ret.QUANTILES - 1));
+	ret.set_percentiles();
+	ret.max = sorted.back();
+	return ret;
+}
+
+/**
+ * @brief Merges latencies of several runs.
+ *
+ * @param runs the latencies of each run and its weight, the number of calls.
+ */
+inline auto merge_latencies(
+    const std::vector<std::pair<const Latency_Summary*, double>>& runs)
+    -> Latency_Summary
+{
+	auto points = std::vector<std::pair<double, double>>();
+	auto ret = Latency_Summary();
+	for (auto& r : runs) {
+		for (auto q : r.first->quantiles)
+			points.emplace_back(q, r.second);
+		ret.max = std::max(ret.max, r.first->max);
+	}
+	if (points.empty())
+		return ret;
+	std::sort(begin(points), end(points));
+	auto total = 0.0;
+	for (auto& p : points)
+		total += p.second;
+	auto step = total / (ret.QUANTILES - 1);
+	auto acc = 0.0;
+	for (auto& p : points) {
+		acc += p.second;
+		while (ret.quantiles.size() * step <= acc &&
+		       ret.quantiles.size() != ret.QUANTILES)
+			ret.quantiles.push_back(p.first);
+	}
+	ret.quantiles.resize(ret.QUANTILES, points.back().first);
+	ret.set_percentiles();
+	return ret;
+}
+
+/**
+ * @brief Appends the words of a file, separated by white space.
+ */
+inline auto read_words(const std::string& path, std::vector<std::string>& out)
+    -> void
+{
+	std::ifstream f(path);
+	for (std::string w; f >> w;)
+		out.push_back(w);
+}
+
+/**
+ * @brief Gets the path of the dictionary being loaded, empty if none.
+ *
+ * See report_exit_while_loading().
+ */
+inline auto loading_path() -> std::string&
+{
+	// never destroyed, it is used by the atexit() handler
+	static auto path = new std::string();
+	return *path;
+}
+
+/**
+ * @brief Reports that the process ends during loading of a dictionary.
+ *
+ * The parsers end the process on some malformed dictionaries. Registered
+ * with atexit(), this makes the benchmark fail instead of exiting silently
+ * with no results.
+ */
+inline auto report_exit_while_loading() -> void
+{
+	if (loading_path().empty())
+		return;
+	std::cerr << "Loading of " << loading_path()
+	          << " ended the process\n";
+	std::_Exit(1);
+}
+
+inline auto json_string(const std::string& s) -> std::string
+{
+	auto ret = std::string("\"");
+	for (auto c : s) {
+		if (c == '"' || c == '\\')
+			ret += '\\';
+		ret += c;
+	}
+	return ret + '"';
+}
+} // namespace nuspell
+
+#endif // NUSPELL_BENCH_UTILS_HXX
@@ -0,0 +1,448 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file compare_bench.cxx
+ * Comparison of Nuspell with Hunspell.
+ *
+ * Loads the same dictionaries into Hunspell and nuspell::Dictionary, checks
+ * the same words with both and reports load time, memory, throughput and
+ * latency of each, and the words on which they disagree.
+ */
+
+#include "bench_utils.hxx"
+#include "dictionary.hxx"
+
+#include <hunspell.hxx>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/locale.hpp>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace nuspell;
+
+namespace {
+
+auto print_help(const string& program_name) -> void
+{
+	auto& p = program_name;
+	cout << "Usage:\n"
+	        "\n";
+	cout << p << " [--json] [-e ENGINE] [-r REPEATS] [-c CALLS] "
+	             "[-w WORDS_FILE] [-m MISMATCHES]\n"
+	     << string(p.size(), ' ') << " dict_PATH...\n";
+	cout << "\n"
+	        "Loads each dictionary into Hunspell and Nuspell and checks "
+	        "the words\n"
+	        "from dict_PATH.good and dict_PATH.wrong, or from WORDS_FILE "
+	        "if given,\n"
+	        "with both. The words must be in the encoding of the "
+	        "dictionary. The\n"
+	        "path can end with .dic.\n"
+	        "\n"
+	        "For each engine reports the load time, the growth of the "
+	        "resident\n"
+	        "memory by loading, the peak resident memory of the process, "
+	        "words per\n"
+	        "second and latency percentiles. Words per second is the best "
+	        "of REPEATS\n"
+	        "runs, by default 3, each with at least CALLS checks, by "
+	        "default 100000.\n"
+	        "The engines run one after the other, Nuspell first, so the "
+	        "peak memory of\n"
+	        "Hunspell includes that of Nuspell. Use -e nuspell or -e "
+	        "hunspell to run\n"
+	        "only one engine.\n"
+	        "\n"
+	        "Words that the engines check differently are counted, and up "
+	        "to\n"
+	        "MISMATCHES of them per dictionary are listed, by default 10.\n"
+	        "--json prints one JSON object per line instead of a table. "
+	        "The rows\n"
+	        "with dictionary \"TOTAL\" sum up all dictionaries.\n"
+	        "Memory is measured only on Linux.\n";
+}
+
+struct Options {
+	bool run_nuspell = true;
+	bool run_hunspell = true;
+	int repeats = 3;
+	size_t min_calls = 100000;
+	size_t max_mismatches = 10;
+	string words_file;
+	bool json = false;
+};
+
+/**
+ * @brief Results of one engine on one dictionary.
+ *
+ * Memory is in KiB, zero if not measured.
+ */
+struct Engine_Result {
+	string dictionary;
+	string engine;
+	double load_seconds = 0;
+	long load_rss = 0;
+	long peak_rss = 0;
+	size_t words = 0;
+	size_t good_words = 0;
+	size_t calls = 0;
+	double seconds = 0;
+	Latency_Summary latency;
+};
+
+struct Mismatch {
+	string dictionary;
+	string word;
+	bool hunspell_good;
+};
+
+/**
+ * @brief Gets the current resident memory of the process in KiB.
+ */
+auto current_rss() -> long
+{
+#ifdef __linux__
+	auto statm = ifstream("/proc/self/statm");
+	long size = 0, resident = 0;
+	if (statm >> size >> resident)
+		return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+	return 0;
+}
+
+/**
+ * @brief Gets the peak resident memory of the process in KiB.
+ */
+auto peak_rss() -> long
+{
+#ifdef __linux__
+	auto usage = rusage();
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+#endif
+	return 0;
+}
+
+/**
+ * @brief Loads a dictionary into an engine and checks the words.
+ *
+ * @param load function that loads the dictionary and returns the function
+ * that checks a word, or nullptr if loading fails.
+ * @param results results of the words, true for good words.
+ * @return false if loading failed.
+ */
+template <class Load>
+auto run_engine(Load load, const vector<string>& words, const Options& opt,
+                Engine_Result& r, vector<bool>& results) -> bool
+{
+	auto rss_before = current_rss();
+	auto t1 = chrono::steady_clock::now();
+	loading_path() = r.dictionary;
+	auto spell = load();
+	loading_path().clear();
+	auto t2 = chrono::steady_clock::now();
+	if (!spell)
+		return false;
+	r.load_seconds = chrono::duration<double>(t2 - t1).count();
+	r.load_rss = current_rss() - rss_before;
+	results.clear();
+	for (auto& w : words)
+		results.push_back(spell(w));
+	r.words = words.size();
+	r.good_words = count(begin(results), end(results), true);
+	auto t = time_calls(words, opt.min_calls, opt.repeats, spell);
+	r.calls = t.calls;
+	r.seconds = t.seconds;
+	r.latency = summarize_latencies(t.latencies);
+	r.peak_rss = peak_rss();
+	return true;
+}
+
+/**
+ * @brief Loads the dictionary into Nuspell.
+ *
+ * The words are checked as they would be by Dictionary::spell() with input
+ * in the encoding of the dictionary, so UTF-8 is converted on each check
+ * like Hunspell does.
+ */
+auto load_nuspell(const string& path, unique_ptr<Dictionary>& d)
+    -> function<bool(const string&)>
+{
+	try {
+		d.reset(new Dictionary(Dictionary::load_from_aff_dic(path)));
+	}
+	catch (const ios_base::failure& e) {
+		cerr << "Nuspell can not load " << path << ": " << e.what()
+		     << '\n';
+		return nullptr;
+	}
+	auto dic = d.get();
+	auto& info = use_facet<boost::locale::info>(dic->locale_aff);
+	if (info.utf8())
+		return [dic](const string& w) {
+			auto wide = boost::locale::conv::utf_to_utf<wchar_t>(w);
+			return dic->spell_priv<wchar_t>(wide) != BAD_WORD;
+		};
+	return [dic](const string& w) {
+		return dic->spell_priv<char>(w) != BAD_WORD;
+	};
+}
+
+auto load_hunspell(const string& path, unique_ptr<Hunspell>& h)
+    -> function<bool(const string&)>
+{
+	auto aff = path + ".aff";
+	auto dic = path + ".dic";
+	h.reset(new Hunspell(aff.c_str(), dic.c_str()));
+	auto hun = h.get();
+	return [hun](const string& w) { return hun->spell(w); };
+}
+
+/**
+ * @brief Compares the engines on one dictionary.
+ */
+auto compare(string path, const Options& opt, vector<Engine_Result>& results,
+             vector<Mismatch>& mismatches, size_t& mismatch_count) -> void
+{
+	if (path.size() > 4 && path.compare(path.size() - 4, 4, ".dic") == 0)
+		path.erase(path.size() - 4);
+	auto words = vector<string>();
+	if (opt.words_file.empty()) {
+		read_words(path + ".good", words);
+		read_words(path + ".wrong", words);
+	}
+	else {
+		read_words(opt.words_file, words);
+	}
+	if (words.empty())
+		return;
+
+	auto nuspell_results = vector<bool>();
+	auto nuspell_loaded = false;
+	if (opt.run_nuspell) {
+		auto r = Engine_Result();
+		r.dictionary = path;
+		r.engine = "nuspell";
+		auto d = unique_ptr<Dictionary>();
+		auto load = [&] { return load_nuspell(path, d); };
+		nuspell_loaded =
+		    run_engine(load, words, opt, r, nuspell_results);
+		if (nuspell_loaded)
+			results.push_back(move(r));
+	}
+	auto hunspell_results = vector<bool>();
+	if (opt.run_hunspell) {
+		auto r = Engine_Result();
+		r.dictionary = path;
+		r.engine = "hunspell";
+		auto h = unique_ptr<Hunspell>();
+		auto load = [&] { return load_hunspell(path, h); };
+		run_engine(load, words, opt, r, hunspell_results);
+		results.push_back(move(r));
+	}
+	if (!nuspell_loaded || !opt.run_hunspell)
+		return;
+	size_t listed = 0;
+	for (size_t i = 0; i != words.size(); ++i) {
+		if (nuspell_results[i] == hunspell_results[i])
+			continue;
+		++mismatch_count;
+		if (listed++ < opt.max_mismatches)
+			mismatches.push_back({path, words[i],
+			                      hunspell_results[i]});
+	}
+}
+
+auto sum_results(const vector<Engine_Result>& results)
+    -> vector<Engine_Result>
+{
+	auto ret = vector<Engine_Result>();
+	for (auto engine : {"nuspell", "hunspell"}) {
+		auto sum = Engine_Result();
+		sum.dictionary = "TOTAL";
+		sum.engine = engine;
+		auto latencies = vector<pair<const Latency_Summary*, double>>();
+		for (auto& r : results) {
+			if (r.engine != engine)
+				continue;
+			sum.load_seconds += r.load_seconds;
+			sum.load_rss += r.load_rss;
+			sum.peak_rss = max(sum.peak_rss, r.peak_rss);
+			sum.words += r.words;
+			sum.good_words += r.good_words;
+			sum.calls += r.calls;
+			sum.seconds += r.seconds;
+			latencies.emplace_back(&r.latency, double(r.calls));
+		}
+		if (latencies.empty())
+			continue;
+		sum.latency = merge_latencies(latencies);
+		ret.push_back(move(sum));
+	}
+	return ret;
+}
+
+auto print_table_header() -> void
+{
+	cout << left << setw(30) << "dictionary" << setw(9) << "engine"
+	     << right << setw(9) << "load ms" << setw(10) << "load KiB"
+	     << setw(10) << "peak KiB" << setw(7) << "words" << setw(7)
+	     << "good" << setw(11) << "words/sec" << setw(8) << "p50 ns"
+	     << setw(8) << "p90 ns" << setw(8) << "p99 ns" << setw(9)
+	     << "max ns" << '\n';
+}
+
+auto print_result(const Engine_Result& r, bool json) -> void
+{
+	auto words_per_second = r.calls / r.seconds;
+	auto& l = r.latency;
+	if (json) {
+		cout << fixed << setprecision(1) << "{\"dictionary\": "
+		     << json_string(r.dictionary) << ", \"engine\": \""
+		     << r.engine << "\", \"load_seconds\": " << setprecision(6)
+		     << r.load_seconds << ", \"load_rss_kib\": " << r.load_rss
+		     << ", \"peak_rss_kib\": " << r.peak_rss
+		     << ", \"words\": " << r.words
+		     << ", \"good_words\": " << r.good_words
+		     << ", \"calls\": " << r.calls
+		     << ", \"seconds\": " << r.seconds << setprecision(1)
+		     << ", \"words_per_second\": " << words_per_second
+		     << ", \"p50_ns\": " << l.p50 << ", \"p90_ns\": " << l.p90
+		     << ", \"p99_ns\": " << l.p99 << ", \"max_ns\": " << l.max
+		     << "}\n";
+		return;
+	}
+	auto name = r.dictionary;
+	if (name.size() > 29)
+		name = "..." + name.substr(name.size() - 26);
+	cout << left << setw(30) << name << setw(9) << r.engine << right
+	     << fixed << setprecision(1) << setw(9) << r.load_seconds * 1000
+	     << setw(10) << r.load_rss << setw(10) << r.peak_rss << setw(7)
+	     << r.words << setw(7) << r.good_words << setprecision(0)
+	     << setw(11) << words_per_second << setw(8) << l.p50 << setw(8)
+	     << l.p90 << setw(8) << l.p99 << setw(9) << l.max << '\n';
+}
+
+auto print_mismatches(const vector<Mismatch>& mismatches, size_t count,
+                      bool json) -> void
+{
+	for (auto& m : mismatches) {
+		auto h = m.hunspell_good ? "good" : "wrong";
+		auto n = m.hunspell_good ? "wrong" : "good";
+		if (json)
+			cout << "{\"dictionary\": " << json_string(m.dictionary)
+			     << ", \"mismatch\": " << json_string(m.word)
+			     << ", \"hunspell\": \"" << h
+			     << "\", \"nuspell\": \"" << n << "\"}\n";
+		else
+			cout << "mismatch in " << m.dictionary << ": "
+			     << m.word << " is " << h << " in Hunspell, " << n
+			     << " in Nuspell\n";
+	}
+	if (json)
+		cout << "{\"dictionary\": \"TOTAL\", \"mismatches\": " << count
+		     << "}\n";
+	else
+		cout << "mismatches: " << count << '\n';
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto program_name = string("compare-bench");
+	if (argc != 0 && argv[0] && argv[0][0] != '\0')
+		program_name = argv[0];
+	auto paths = vector<string>();
+	auto opt = Options();
+	for (int i = 1; i != argc; ++i) {
+		auto arg = string(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			print_help(program_name);
+			return 0;
+		}
+		else if (arg == "--json") {
+			opt.json = true;
+		}
+		else if ((arg == "-e" || arg == "-w") && i + 1 != argc) {
+			auto value = string(argv[++i]);
+			if (arg == "-w") {
+				opt.words_file = value;
+			}
+			else if (value == "nuspell" || value == "hunspell") {
+				opt.run_nuspell = value == "nuspell";
+				opt.run_hunspell = value == "hunspell";
+			}
+			else {
+				cerr << "Unknown engine " << value << '\n';
+				return 1;
+			}
+		}
+		else if ((arg == "-r" || arg == "-c" || arg == "-m") &&
+		         i + 1 != argc) {
+			auto x = stoul(argv[++i]);
+			if (arg == "-r")
+				opt.repeats = max(1ul, x);
+			else if (arg == "-c")
+				opt.min_calls = max(1ul, x);
+			else
+				opt.max_mismatches = x;
+		}
+		else {
+			paths.push_back(arg);
+		}
+	}
+	if (paths.empty()) {
+		print_help(program_name);
+		return 1;
+	}
+
+	atexit(report_exit_while_loading);
+	auto results = vector<Engine_Result>();
+	auto mismatches = vector<Mismatch>();
+	size_t mismatch_count = 0;
+	for (auto& p : paths)
+		compare(p, opt, results, mismatches, mismatch_count);
+	if (results.empty()) {
+		cerr << "No words to check\n";
+		return 1;
+	}
+	if (!opt.json)
+		print_table_header();
+	for (auto& r : results)
+		print_result(r, opt.json);
+	if (paths.size() > 1)
+		for (auto& r : sum_results(results))
+			print_result(r, opt.json);
+	if (opt.run_nuspell && opt.run_hunspell)
+		print_mismatches(mismatches, mismatch_count, opt.json);
+	return 0;
+}
@@ -0,0 +1,191 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file load_bench.cxx
+ * Benchmark of dictionary loading.
+ *
+ * Measures lines per second of the .dic parser on generated dictionaries of
+ * growing size, or on existing dictionaries given on the command line. For
+ * those that have .dic.hz file, measures the decompression too.
+ */
+
+#include "dictionary.hxx"
+#include "hzip.hxx"
+#include "synthetic_dic.hxx"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace nuspell;
+
+namespace {
+
+auto print_help(const string& program_name) -> void
+{
+	auto& p = program_name;
+	cout << "Usage:\n"
+	        "\n";
+	cout << p << " [-r REPEATS] [-j THREADS] [-n WORDS]... [dict_PATH]...\n";
+	cout << "\n"
+	        "Measures the time to parse .dic files. Without dict_PATH "
+	        "generates\n"
+	        "synthetic UTF-8 dictionaries with WORDS entries, by default "
+	        "100000,\n"
+	        "1000000 and 4000000. Each measurement is the best of REPEATS "
+	        "runs,\n"
+	        "by default 3. THREADS is passed to Aff_Data::parse_dic(), by "
+	        "default 1,\n"
+	        "0 means one thread per hardware thread.\n"
+	        "If dict_PATH.dic.hz exists, the time to decompress it is "
+	        "measured too.\n";
+}
+
+auto count_lines(const string& s) { return count(begin(s), end(s), '\n'); }
+
+/**
+ * @brief Times parsing of dic with the affix data parsed from aff.
+ *
+ * @return best time of all repeats, in seconds.
+ */
+auto time_parse(const string& aff, const string& dic, int repeats,
+                size_t threads, size_t& word_count) -> double
+{
+	auto best = chrono::duration<double>::max();
+	for (int i = 0; i != repeats; ++i) {
+		auto a = Aff_Data();
+		auto aff_ss = istringstream(aff);
+		auto dic_ss = istringstream(dic);
+		a.parse_aff(aff_ss);
+		auto t1 = chrono::steady_clock::now();
+		a.parse_dic(dic_ss, threads);
+		auto t2 = chrono::steady_clock::now();
+		best = min(best, chrono::duration<double>(t2 - t1));
+		word_count = a.words.size();
+	}
+	return best.count();
+}
+
+/**
+ * @brief Times decompression of .hz data.
+ *
+ * @return best time of all repeats, in seconds.
+ */
+auto time_hz_decode(const string& hz, int repeats, string& text) -> double
+{
+	auto best = chrono::duration<double>::max();
+	for (int i = 0; i != repeats; ++i) {
+		auto in = istringstream(hz);
+		auto t1 = chrono::steady_clock::now();
+		Hzip_Istream hz_in(in);
+		text.assign(istreambuf_iterator<char>(hz_in), {});
+		auto t2 = chrono::steady_clock::now();
+		best = min(best, chrono::duration<double>(t2 - t1));
+	}
+	return best.count();
+}
+
+auto report(const string& name, size_t lines, size_t words, double secs)
+    -> void
+{
+	cout << left << setw(30) << name << right << setw(10) << lines
+	     << setw(10) << words << setw(10) << fixed << setprecision(3)
+	     << secs << setw(14) << setprecision(0) << lines / secs << '\n';
+}
+
+auto read_file(const string& path, string& out) -> bool
+{
+	ifstream f(path, ios_base::binary);
+	if (!f.is_open())
+		return false;
+	out.assign(istreambuf_iterator<char>(f), {});
+	return true;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto program_name = string("load-bench");
+	if (argc != 0 && argv[0] && argv[0][0] != '\0')
+		program_name = argv[0];
+	auto sizes = vector<size_t>();
+	auto paths = vector<string>();
+	auto repeats = 3;
+	size_t threads = 1;
+	for (int i = 1; i != argc; ++i) {
+		auto arg = string(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			print_help(program_name);
+			return 0;
+		}
+		else if ((arg == "-n" || arg == "-r" || arg == "-j") &&
+		         i + 1 != argc) {
+			auto x = stoul(argv[++i]);
+			if (arg == "-n")
+				sizes.push_back(x);
+			else if (arg == "-r")
+				repeats = max(1ul, x);
+			else
+				threads = x;
+		}
+		else {
+			paths.push_back(arg);
+		}
+	}
+	if (sizes.empty() && paths.empty())
+		sizes = {100000, 1000000, 4000000};
+
+	cout << left << setw(30) << "dictionary" << right << setw(10)
+	     << "lines" << setw(10) << "words" << setw(10) << "seconds"
+	     << setw(14) << "lines/second" << '\n';
+	for (auto n : sizes) {
+		auto dic = generate_dic(n);
+		size_t words;
+		auto secs = time_parse(synthetic_aff, dic, repeats, threads, words);
+		report("synthetic " + to_string(n), count_lines(dic), words,
+		       secs);
+	}
+	for (auto& p : paths) {
+		string aff, dic;
+		if (!read_file(p + ".aff", aff) || !read_file(p + ".dic", dic)) {
+			cerr << "Can not read " << p << ".aff/.dic\n";
+			return 1;
+		}
+		size_t words;
+		auto secs = time_parse(aff, dic, repeats, threads, words);
+		report(p, count_lines(dic), words, secs);
+
+		string hz, text;
+		if (!read_file(p + ".dic.hz", hz))
+			continue;
+		secs = time_hz_decode(hz, repeats, text);
+		if (text != dic) {
+			cerr << "Decompressed " << p << ".dic.hz differs from "
+			     << p << ".dic\n";
+			return 1;
+		}
+		report(p + ".dic.hz decompress", count_lines(text), 0, secs);
+	}
+	return 0;
+}
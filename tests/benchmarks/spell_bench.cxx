@@ -0,0 +1,522 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file spell_bench.cxx
+ * Benchmark of spell checking.
+ *
+ * Measures words per second and latency percentiles of the spelling of
+ * words, separately for dictionaries in single byte encodings (the char path)
+ * and in UTF-8 (the wchar_t path), and for three kinds of words: words that
+ * are in the dictionary as they are, words that are accepted in other ways,
+ * mostly with affixes, and misses. Optionally measures the same again with
+ * the form index of the dictionary, and reports its memory and gain.
+ */
+
+#include "bench_utils.hxx"
+#include "dictionary.hxx"
+#include "synthetic_dic.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/locale.hpp>
+
+using namespace std;
+using namespace nuspell;
+
+namespace {
+
+auto print_help(const string& program_name) -> void
+{
+	auto& p = program_name;
+	cout << "Usage:\n"
+	        "\n";
+	cout << p << " [--json] [-f] [-r REPEATS] [-c CALLS] [-n WORDS]... "
+	             "[dict_PATH]...\n";
+	cout << "\n"
+	        "Measures the time to check the spelling of words. The words "
+	        "are read\n"
+	        "from dict_PATH.good and dict_PATH.wrong. The path can end "
+	        "with .dic.\n"
+	        "Without dict_PATH generates synthetic dictionary with WORDS "
+	        "entries,\n"
+	        "by default 100000, in UTF-8 and in ISO8859-1, and checks its "
+	        "roots,\n"
+	        "derived words and misspellings.\n"
+	        "\n"
+	        "Each list of words is checked repeatedly until at least "
+	        "CALLS checks,\n"
+	        "by default 100000. Words per second is the best of REPEATS "
+	        "runs, by\n"
+	        "default 3. The latency percentiles are from one extra run "
+	        "that times\n"
+	        "each check.\n"
+	        "\n"
+	        "The words are grouped by the result into unaffixed (the "
+	        "word is in\n"
+	        "the dictionary as it is), affixed (accepted in other way, "
+	        "mostly with\n"
+	        "affixes, but also by casing, compounding or BREAK) and "
+	        "miss.\n"
+	        "-f also checks the words with the form index built, mode "
+	        "index, after\n"
+	        "the checks with stripping of affixes, mode strip, and "
+	        "reports for each\n"
+	        "dictionary the forms in the index, its memory and build "
+	        "time, and the\n"
+	        "words per second of all its words in both modes.\n"
+	        "\n"
+	        "--json prints one JSON object per line instead of a table. "
+	        "The rows\n"
+	        "with dictionary \"TOTAL\" sum up all dictionaries.\n";
+}
+
+enum Category { UNAFFIXED, AFFIXED, MISS, CATEGORY_COUNT };
+const char* category_names[] = {"unaffixed", "affixed", "miss"};
+
+struct Options {
+	int repeats = 3;
+	size_t min_calls = 100000;
+	bool json = false;
+	bool form_index = false;
+};
+
+/**
+ * @brief Result of checking one list of words.
+ */
+struct Result {
+	string dictionary;
+	string path;
+	string mode;
+	Category category;
+	size_t words = 0;
+	size_t calls = 0;
+	double seconds = 0;
+	Latency_Summary latency;
+};
+
+/**
+ * @brief Cost and gain of the form index of one dictionary.
+ */
+struct Index_Report {
+	string dictionary;
+	string path;
+	size_t forms = 0;
+	size_t kib = 0;
+	double build_seconds = 0;
+	double strip_words_per_second = 0;
+	double index_words_per_second = 0;
+};
+
+/**
+ * @brief Times checking of words.
+ *
+ * @param d the dictionary.
+ * @param words the words, all of them of the same category.
+ * @param opt the options.
+ * @param r where to store the result.
+ */
+template <class CharT>
+auto time_spell(Dictionary& d, const vector<basic_string<CharT>>& words,
+                const Options& opt, Result& r) -> void
+{
+	auto t = time_calls(words, opt.min_calls, opt.repeats, [&](auto& w) {
+		return d.spell_priv<CharT>(w);
+	});
+	r.words = words.size();
+	r.calls = t.calls;
+	r.seconds = t.seconds;
+	r.latency = summarize_latencies(t.latencies);
+}
+
+template <class CharT>
+auto is_in_dictionary(const Dictionary& d, const basic_string<CharT>& word)
+{
+	auto range = d.words.equal_range(word);
+	return range.first != range.second;
+}
+
+/**
+ * @brief Times each group of words of a dictionary.
+ *
+ * @return words per second of all groups together.
+ */
+template <class CharT>
+auto bench_groups(Dictionary& d, const string& name, const string& mode,
+                  const vector<basic_string<CharT>>* groups,
+                  const Options& opt, vector<Result>& results) -> double
+{
+	size_t calls = 0;
+	double seconds = 0;
+	for (auto c : {UNAFFIXED, AFFIXED, MISS}) {
+		if (groups[c].empty())
+			continue;
+		auto r = Result();
+		r.dictionary = name;
+		r.path = is_same<CharT, char>::value ? "char" : "wchar_t";
+		r.mode = mode;
+		r.category = c;
+		time_spell(d, groups[c], opt, r);
+		calls += r.calls;
+		seconds += r.seconds;
+		results.push_back(move(r));
+	}
+	return calls / seconds;
+}
+
+/**
+ * @brief Groups the words by category and times each group.
+ *
+ * With the option form_index, builds the form index and times each group
+ * again.
+ */
+template <class CharT>
+auto bench_words(Dictionary& d, const string& name,
+                 const vector<basic_string<CharT>>& words,
+                 const Options& opt, vector<Result>& results,
+                 vector<Index_Report>& reports) -> void
+{
+	vector<basic_string<CharT>> groups[CATEGORY_COUNT];
+	for (auto& w : words) {
+		auto category = MISS;
+		if (d.spell_priv<CharT>(w))
+			category =
+			    is_in_dictionary(d, w) ? UNAFFIXED : AFFIXED;
+		groups[category].push_back(w);
+	}
+	auto strip = bench_groups(d, name, "strip", groups, opt, results);
+	if (!opt.form_index)
+		return;
+	auto r = Index_Report();
+	r.dictionary = name;
+	r.path = is_same<CharT, char>::value ? "char" : "wchar_t";
+	auto t1 = chrono::steady_clock::now();
+	d.build_form_index();
+	auto t2 = chrono::steady_clock::now();
+	r.build_seconds = chrono::duration<double>(t2 - t1).count();
+	auto& index = d.get_form_index<CharT>();
+	r.forms = index.size();
+	r.kib = index.memory_usage() / 1024;
+	r.strip_words_per_second = strip;
+	r.index_words_per_second =
+	    bench_groups(d, name, "index", groups, opt, results);
+	reports.push_back(move(r));
+}
+
+/**
+ * @brief Checks words given in the encoding of the dictionary.
+ *
+ * UTF-8 dictionaries are checked with wchar_t strings, others with char
+ * strings, as Dictionary::spell() does after the conversion of the input.
+ */
+auto bench_dictionary(Dictionary& d, const string& name,
+                      const vector<string>& words, const Options& opt,
+                      vector<Result>& results,
+                      vector<Index_Report>& reports) -> void
+{
+	using namespace boost::locale;
+	auto& info = use_facet<boost::locale::info>(d.locale_aff);
+	if (!info.utf8()) {
+		bench_words(d, name, words, opt, results, reports);
+		return;
+	}
+	auto wide_words = vector<wstring>();
+	for (auto& w : words)
+		wide_words.push_back(conv::utf_to_utf<wchar_t>(w));
+	bench_words(d, name, wide_words, opt, results, reports);
+}
+
+/**
+ * @brief Makes words to check from the synthetic dictionary.
+ *
+ * Each root is followed by one of its derived words, if it has any, and by
+ * a misspelling with two letters swapped.
+ */
+auto synthetic_words(const string& dic) -> vector<string>
+{
+	auto words = vector<string>();
+	auto in = istringstream(dic);
+	auto line = string();
+	getline(in, line);
+	for (size_t i = 0; getline(in, line); ++i) {
+		auto word = line.substr(0, line.find_first_of("/ "));
+		auto slash = line.find('/');
+		auto flags = string();
+		if (slash != line.npos)
+			flags = line.substr(slash + 1,
+			                    line.find(' ', slash) - slash - 1);
+		words.push_back(word);
+
+		auto derived = vector<string>();
+		if (flags.find("Aa") != flags.npos)
+			derived.push_back("re" + word);
+		if (flags.find("Bb") != flags.npos) {
+			if (word.back() != 'y')
+				derived.push_back(word + 's');
+			else if (string("aeiou").find(word.end()[-2]) ==
+			         string::npos)
+				derived.push_back(word.substr(0, word.size() - 1) +
+				                  "ies");
+		}
+		if (flags.find("Cc") != flags.npos)
+			derived.push_back(word + "ed");
+		if (!derived.empty())
+			words.push_back(derived[i % derived.size()]);
+
+		auto typo = word;
+		auto j = typo.size() / 2;
+		if (typo[j] != typo[j - 1] && typo[j] > 0 && typo[j - 1] > 0) {
+			swap(typo[j], typo[j - 1]);
+			words.push_back(typo);
+		}
+	}
+	return words;
+}
+
+auto utf8_to_latin1(string s)
+{
+	boost::replace_all(s, u8"é", "\xE9");
+	return s;
+}
+
+auto bench_synthetic(size_t n, const Options& opt, vector<Result>& results,
+                     vector<Index_Report>& reports) -> void
+{
+	auto dic = generate_dic(n);
+	auto words = synthetic_words(dic);
+	auto name = "synthetic " + to_string(n);
+	{
+		auto aff_in = istringstream(synthetic_aff);
+		auto dic_in = istringstream(dic);
+		auto d = Dictionary::load_from_aff_dic(aff_in, dic_in);
+		bench_dictionary(d, name + " UTF-8", words, opt, results,
+		                 reports);
+	}
+	auto aff = string(synthetic_aff);
+	boost::replace_first(aff, "SET UTF-8", "SET ISO8859-1");
+	auto aff_in = istringstream(aff);
+	auto dic_in = istringstream(utf8_to_latin1(dic));
+	auto d = Dictionary::load_from_aff_dic(aff_in, dic_in);
+	for (auto& w : words)
+		w = utf8_to_latin1(w);
+	bench_dictionary(d, name + " ISO8859-1", words, opt, results,
+	                 reports);
+}
+
+auto bench_path(string path, const Options& opt, vector<Result>& results,
+                vector<Index_Report>& reports) -> void
+{
+	if (path.size() > 4 && path.compare(path.size() - 4, 4, ".dic") == 0)
+		path.erase(path.size() - 4);
+	auto words = vector<string>();
+	read_words(path + ".good", words);
+	read_words(path + ".wrong", words);
+	if (words.empty())
+		return;
+	auto d = Dictionary();
+	auto loaded = true;
+	loading_path() = path;
+	try {
+		d = Dictionary::load_from_aff_dic(path);
+	}
+	catch (const ios_base::failure& e) {
+		cerr << "Skipping " << path << ": " << e.what() << '\n';
+		loaded = false;
+	}
+	loading_path().clear();
+	if (!loaded)
+		return;
+	bench_dictionary(d, path, words, opt, results, reports);
+}
+
+/**
+ * @brief Sums up results of all dictionaries by path, mode and category.
+ *
+ * The latencies of the results are weighted by their number of calls.
+ */
+auto sum_results(const vector<Result>& results) -> vector<Result>
+{
+	using Key = tuple<string, string, Category>;
+	auto groups = map<Key, vector<const Result*>>();
+	for (auto& r : results)
+		groups[Key(r.path, r.mode, r.category)].push_back(&r);
+	auto ret = vector<Result>();
+	for (auto& g : groups) {
+		auto sum = Result();
+		sum.dictionary = "TOTAL";
+		sum.path = get<0>(g.first);
+		sum.mode = get<1>(g.first);
+		sum.category = get<2>(g.first);
+		auto latencies = vector<pair<const Latency_Summary*, double>>();
+		for (auto r : g.second) {
+			sum.words += r->words;
+			sum.calls += r->calls;
+			sum.seconds += r->seconds;
+			latencies.emplace_back(&r->latency, double(r->calls));
+		}
+		sum.latency = merge_latencies(latencies);
+		ret.push_back(move(sum));
+	}
+	return ret;
+}
+
+auto print_table_header() -> void
+{
+	cout << left << setw(36) << "dictionary" << setw(8) << "path"
+	     << setw(6) << "mode" << setw(10) << "category" << right
+	     << setw(7) << "words" << setw(12) << "words/sec" << setw(9)
+	     << "p50 ns" << setw(9) << "p90 ns" << setw(9) << "p99 ns"
+	     << setw(10) << "max ns" << '\n';
+}
+
+auto print_result(const Result& r, bool json) -> void
+{
+	auto words_per_second = r.calls / r.seconds;
+	if (json) {
+		cout << fixed << setprecision(1) << "{\"dictionary\": "
+		     << json_string(r.dictionary) << ", \"path\": \""
+		     << r.path << "\", \"mode\": \"" << r.mode
+		     << "\", \"category\": \""
+		     << category_names[r.category] << "\", \"words\": "
+		     << r.words << ", \"calls\": " << r.calls
+		     << ", \"seconds\": " << setprecision(6) << r.seconds
+		     << setprecision(1)
+		     << ", \"words_per_second\": " << words_per_second
+		     << ", \"p50_ns\": " << r.latency.p50
+		     << ", \"p90_ns\": " << r.latency.p90
+		     << ", \"p99_ns\": " << r.latency.p99
+		     << ", \"max_ns\": " << r.latency.max
+		     << "}\n";
+		return;
+	}
+	auto name = r.dictionary;
+	if (name.size() > 35)
+		name = "..." + name.substr(name.size() - 32);
+	cout << left << setw(36) << name << setw(8) << r.path << setw(6)
+	     << r.mode << setw(10) << category_names[r.category] << right
+	     << setw(7) << r.words << fixed << setprecision(0) << setw(12)
+	     << words_per_second
+	     << setw(9) << r.latency.p50 << setw(9) << r.latency.p90
+	     << setw(9) << r.latency.p99 << setw(10) << r.latency.max << '\n';
+}
+
+auto print_index_report(const Index_Report& r, bool json) -> void
+{
+	auto gain = r.index_words_per_second / r.strip_words_per_second;
+	if (json) {
+		cout << fixed << setprecision(1) << "{\"dictionary\": "
+		     << json_string(r.dictionary) << ", \"path\": \""
+		     << r.path << "\", \"form_index_forms\": " << r.forms
+		     << ", \"form_index_kib\": " << r.kib
+		     << ", \"build_seconds\": " << setprecision(6)
+		     << r.build_seconds << setprecision(1)
+		     << ", \"strip_words_per_second\": "
+		     << r.strip_words_per_second
+		     << ", \"index_words_per_second\": "
+		     << r.index_words_per_second << setprecision(2)
+		     << ", \"gain\": " << gain << "}\n";
+		return;
+	}
+	auto name = r.dictionary;
+	if (name.size() > 35)
+		name = "..." + name.substr(name.size() - 32);
+	cout << left << setw(36) << name << setw(8) << r.path << right
+	     << setw(9) << r.forms << setw(10) << r.kib << fixed
+	     << setprecision(0) << setw(10) << r.build_seconds * 1000
+	     << setw(12) << r.strip_words_per_second << setw(12)
+	     << r.index_words_per_second << setprecision(2) << setw(7)
+	     << gain << '\n';
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto program_name = string("spell-bench");
+	if (argc != 0 && argv[0] && argv[0][0] != '\0')
+		program_name = argv[0];
+	auto sizes = vector<size_t>();
+	auto paths = vector<string>();
+	auto opt = Options();
+	for (int i = 1; i != argc; ++i) {
+		auto arg = string(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			print_help(program_name);
+			return 0;
+		}
+		else if (arg == "--json") {
+			opt.json = true;
+		}
+		else if (arg == "-f") {
+			opt.form_index = true;
+		}
+		else if ((arg == "-n" || arg == "-r" || arg == "-c") &&
+		         i + 1 != argc) {
+			auto x = stoul(argv[++i]);
+			if (arg == "-n")
+				sizes.push_back(x);
+			else if (arg == "-r")
+				opt.repeats = max(1ul, x);
+			else
+				opt.min_calls = max(1ul, x);
+		}
+		else {
+			paths.push_back(arg);
+		}
+	}
+	if (sizes.empty() && paths.empty())
+		sizes = {100000};
+
+	atexit(report_exit_while_loading);
+	auto results = vector<Result>();
+	auto reports = vector<Index_Report>();
+	for (auto n : sizes)
+		bench_synthetic(n, opt, results, reports);
+	for (auto& p : paths)
+		bench_path(p, opt, results, reports);
+	if (results.empty()) {
+		cerr << "No words to check\n";
+		return 1;
+	}
+	if (!opt.json)
+		print_table_header();
+	for (auto& r : results)
+		print_result(r, opt.json);
+	if (results.size() > 1)
+		for (auto& r : sum_results(results))
+			print_result(r, opt.json);
+	if (reports.empty())
+		return 0;
+	if (!opt.json)
+		cout << '\n'
+		     << left << setw(36) << "dictionary" << setw(8) << "path"
+		     << right << setw(9) << "forms" << setw(10) << "KiB"
+		     << setw(10) << "build ms" << setw(12) << "strip w/s"
+		     << setw(12) << "index w/s" << setw(7) << "gain" << '\n';
+	for (auto& r : reports)
+		print_index_report(r, opt.json);
+	return 0;
+}
@@ -0,0 +1,455 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file suggest_bench.cxx
+ * Benchmark of the speed and quality of suggestions.
+ *
+ * Asks Hunspell and the suggestion engines of Nuspell for suggestions for
+ * the misspellings of a list with their corrections, like the one in
+ * tests/suggestiontest, and reports the throughput, the latency and how often
+ * a correction is among the first suggestions.
+ */
+
+#include "bench_utils.hxx"
+#include "dictionary.hxx"
+
+#include <hunspell.hxx>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/locale.hpp>
+
+using namespace std;
+using namespace nuspell;
+
+namespace {
+
+const char* const engines[] = {"nuspell", "nuspell-delete-index",
+                               "nuspell-trie", "nuspell-ngram", "hunspell"};
+
+auto print_help(const string& program_name) -> void
+{
+	auto& p = program_name;
+	cout << "Usage:\n"
+	        "\n";
+	cout << p << " [--json] [-e ENGINE]... [-r REPEATS] [-c CALLS] "
+	             "[-n MISSPELLINGS]\n"
+	     << string(p.size(), ' ') << " LIST_FILE [dict_PATH]\n";
+	cout << "\n"
+	        "Asks each engine for suggestions for the misspellings in "
+	        "LIST_FILE. Each\n"
+	        "line of it is a misspelling, a tab and the corrections "
+	        "separated by\n"
+	        "commas, lines starting with # are comments, e.g.\n"
+	        "tests/suggestiontest/List_of_common_misspellings.txt. The "
+	        "list must be\n"
+	        "in the encoding of the dictionary. The path can end with "
+	        ".dic. Without\n"
+	        "dict_PATH a UTF-8 dictionary of the one word corrections of "
+	        "the list is\n"
+	        "made. Misspellings that Nuspell accepts as correct are "
+	        "skipped, only the\n"
+	        "first MISSPELLINGS of the others are used if given.\n"
+	        "\n"
+	        "The engines are hunspell, nuspell that only edits the "
+	        "misspelling, and\n"
+	        "nuspell-delete-index, nuspell-trie and nuspell-ngram that "
+	        "also use the\n"
+	        "index of that kind. All run by default, -e selects some of "
+	        "them. For\n"
+	        "each engine reports the build time and the memory of its "
+	        "index,\n"
+	        "misspellings per second, latency percentiles per "
+	        "misspelling and the\n"
+	        "share of the misspellings whose first suggestion, or one of "
+	        "the first\n"
+	        "five, is a correction. Misspellings per second is the best "
+	        "of REPEATS\n"
+	        "runs, by default 1, each with at least CALLS calls, by "
+	        "default 1, so\n"
+	        "one pass over the list.\n"
+	        "--json prints one JSON object per line instead of a table.\n";
+}
+
+struct Options {
+	vector<string> engines;
+	int repeats = 1;
+	size_t min_calls = 1;
+	size_t max_misspellings = 0;
+	bool json = false;
+};
+
+struct Misspelling {
+	string word;
+	vector<string> corrections;
+};
+
+/**
+ * @brief Results of one engine.
+ *
+ * Index memory is in KiB. Latencies are in nanoseconds.
+ */
+struct Engine_Result {
+	string dictionary;
+	string engine;
+	double index_seconds = 0;
+	size_t index_kib = 0;
+	size_t misspellings = 0;
+	size_t top1 = 0;
+	size_t top5 = 0;
+	size_t calls = 0;
+	double seconds = 0;
+	Latency_Summary latency;
+};
+
+auto trim(const string& s) -> string
+{
+	auto first = s.find_first_not_of(" \t\r");
+	if (first == s.npos)
+		return {};
+	auto last = s.find_last_not_of(" \t\r");
+	return s.substr(first, last - first + 1);
+}
+
+auto read_misspellings(const string& path, vector<Misspelling>& out) -> bool
+{
+	auto in = ifstream(path);
+	if (!in)
+		return false;
+	for (string line; getline(in, line);) {
+		auto tab = line.find('\t');
+		if (line.empty() || line[0] == '#' || tab == line.npos)
+			continue;
+		auto m = Misspelling();
+		m.word = trim(line.substr(0, tab));
+		auto corrections = istringstream(line.substr(tab + 1));
+		for (string c; getline(corrections, c, ',');)
+			if (!trim(c).empty())
+				m.corrections.push_back(trim(c));
+		if (!m.word.empty() && !m.corrections.empty())
+			out.push_back(move(m));
+	}
+	return true;
+}
+
+/**
+ * @brief Writes a dictionary of the one word corrections of the list.
+ *
+ * The TRY line is the one of the English dictionaries.
+ */
+auto write_list_dictionary(const vector<Misspelling>& misspellings,
+                           const string& path) -> bool
+{
+	auto words = set<string>();
+	for (auto& m : misspellings)
+		for (auto& c : m.corrections)
+			if (c.find(' ') == c.npos)
+				words.insert(c);
+	auto aff = ofstream(path + ".aff");
+	aff << "SET UTF-8\n"
+	       "TRY esianrtolcdugmphbyfvkwzESIANRTOLCDUGMPHBYFVKWZ'\n";
+	auto dic = ofstream(path + ".dic");
+	dic << words.size() << '\n';
+	for (auto& w : words)
+		dic << w << '\n';
+	return aff.good() && dic.good();
+}
+
+auto load_nuspell(const string& path) -> unique_ptr<Dictionary>
+{
+	try {
+		loading_path() = path;
+		auto d = Dictionary::load_from_aff_dic(path);
+		loading_path().clear();
+		return unique_ptr<Dictionary>(new Dictionary(move(d)));
+	}
+	catch (const ios_base::failure& e) {
+		loading_path().clear();
+		cerr << "Nuspell can not load " << path << ": " << e.what()
+		     << '\n';
+		return nullptr;
+	}
+}
+
+template <class CharT>
+auto index_memory(const Dictionary& d, const string& engine) -> size_t
+{
+	if (engine == "nuspell-delete-index")
+		return d.get_delete_index<CharT>().memory_usage();
+	if (engine == "nuspell-trie")
+		return d.get_word_trie<CharT>().memory_usage();
+	if (engine == "nuspell-ngram")
+		return d.get_ngram_index<CharT>().memory_usage();
+	return 0;
+}
+
+/**
+ * @brief Loads the dictionary into a Nuspell engine and builds its index.
+ *
+ * @return function that gets the suggestions for a misspelling, or nullptr
+ * if loading fails.
+ */
+auto load_nuspell_engine(const string& path, Engine_Result& r,
+                         unique_ptr<Dictionary>& d)
+    -> function<void(const string&, vector<string>&)>
+{
+	d = load_nuspell(path);
+	if (!d)
+		return nullptr;
+	auto t1 = chrono::steady_clock::now();
+	if (r.engine == "nuspell-delete-index")
+		d->build_delete_index();
+	else if (r.engine == "nuspell-trie")
+		d->build_word_trie();
+	else if (r.engine == "nuspell-ngram")
+		d->build_ngram_index();
+	auto t2 = chrono::steady_clock::now();
+	r.index_seconds = chrono::duration<double>(t2 - t1).count();
+	if (use_facet<boost::locale::info>(d->locale_aff).utf8())
+		r.index_kib = index_memory<wchar_t>(*d, r.engine) / 1024;
+	else
+		r.index_kib = index_memory<char>(*d, r.engine) / 1024;
+	auto dic = d.get();
+	return [dic](const string& w, vector<string>& out) {
+		dic->suggest(w, out, dic->locale_aff);
+	};
+}
+
+auto load_hunspell_engine(const string& path, unique_ptr<Hunspell>& h)
+    -> function<void(const string&, vector<string>&)>
+{
+	auto aff = path + ".aff";
+	auto dic = path + ".dic";
+	loading_path() = path;
+	h.reset(new Hunspell(aff.c_str(), dic.c_str()));
+	loading_path().clear();
+	auto hun = h.get();
+	return [hun](const string& w, vector<string>& out) {
+		out = hun->suggest(w);
+	};
+}
+
+/**
+ * @brief Gets the suggestions of one engine for the misspellings.
+ *
+ * The first pass counts how often a correction is the first suggestion or
+ * one of the first five, then the calls are timed.
+ */
+auto run_engine(const string& path, const vector<Misspelling>& misspellings,
+                const Options& opt, Engine_Result& r) -> bool
+{
+	auto d = unique_ptr<Dictionary>();
+	auto h = unique_ptr<Hunspell>();
+	auto suggest = function<void(const string&, vector<string>&)>();
+	if (r.engine == "hunspell")
+		suggest = load_hunspell_engine(path, h);
+	else
+		suggest = load_nuspell_engine(path, r, d);
+	if (!suggest)
+		return false;
+	auto words = vector<string>();
+	auto out = vector<string>();
+	for (auto& m : misspellings) {
+		words.push_back(m.word);
+		suggest(m.word, out);
+		auto& c = m.corrections;
+		auto is_correction = [&](auto& s) {
+			return find(begin(c), end(c), s) != end(c);
+		};
+		if (!out.empty() && is_correction(out[0]))
+			++r.top1;
+		auto first5 = begin(out) + min(out.size(), size_t(5));
+		if (any_of(begin(out), first5, is_correction))
+			++r.top5;
+	}
+	r.misspellings = misspellings.size();
+	auto t = time_calls(words, opt.min_calls, opt.repeats,
+	                    [&](const string& w) {
+		                    suggest(w, out);
+		                    return out.size();
+	                    });
+	r.calls = t.calls;
+	r.seconds = t.seconds;
+	r.latency = summarize_latencies(t.latencies);
+	return true;
+}
+
+auto print_table_header() -> void
+{
+	cout << left << setw(30) << "dictionary" << setw(21) << "engine"
+	     << right << setw(9) << "index ms" << setw(10) << "index KiB"
+	     << setw(7) << "words" << setw(7) << "top-1" << setw(7)
+	     << "top-5" << setw(10) << "words/sec" << setw(9) << "p50 us"
+	     << setw(9) << "p99 us" << '\n';
+}
+
+auto print_result(const Engine_Result& r, bool json) -> void
+{
+	auto words_per_second = r.calls / r.seconds;
+	auto n = max(r.misspellings, size_t(1));
+	auto top1 = double(r.top1) / n;
+	auto top5 = double(r.top5) / n;
+	auto& l = r.latency;
+	if (json) {
+		cout << fixed << setprecision(6) << "{\"dictionary\": "
+		     << json_string(r.dictionary) << ", \"engine\": \""
+		     << r.engine << "\", \"index_seconds\": " << r.index_seconds
+		     << ", \"index_kib\": " << r.index_kib
+		     << ", \"misspellings\": " << r.misspellings
+		     << ", \"top1\": " << r.top1 << ", \"top5\": " << r.top5
+		     << setprecision(4) << ", \"top1_accuracy\": " << top1
+		     << ", \"top5_accuracy\": " << top5
+		     << ", \"calls\": " << r.calls << setprecision(6)
+		     << ", \"seconds\": " << r.seconds << setprecision(1)
+		     << ", \"words_per_second\": " << words_per_second
+		     << ", \"p50_ns\": " << l.p50 << ", \"p90_ns\": " << l.p90
+		     << ", \"p99_ns\": " << l.p99 << ", \"max_ns\": " << l.max
+		     << "}\n";
+		return;
+	}
+	auto name = r.dictionary;
+	if (name.size() > 29)
+		name = "..." + name.substr(name.size() - 26);
+	cout << left << setw(30) << name << setw(21) << r.engine << right
+	     << fixed << setprecision(1) << setw(9) << r.index_seconds * 1000
+	     << setw(10) << r.index_kib << setw(7) << r.misspellings
+	     << setw(6) << top1 * 100 << '%' << setw(6) << top5 * 100 << '%'
+	     << setprecision(0) << setw(10) << words_per_second
+	     << setprecision(1) << setw(9) << l.p50 / 1000 << setw(9)
+	     << l.p99 / 1000 << '\n';
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto program_name = string("suggest-bench");
+	if (argc != 0 && argv[0] && argv[0][0] != '\0')
+		program_name = argv[0];
+	auto paths = vector<string>();
+	auto opt = Options();
+	for (int i = 1; i != argc; ++i) {
+		auto arg = string(argv[i]);
+		if (arg == "-h" || arg == "--help") {
+			print_help(program_name);
+			return 0;
+		}
+		else if (arg == "--json") {
+			opt.json = true;
+		}
+		else if (arg == "-e" && i + 1 != argc) {
+			auto value = string(argv[++i]);
+			if (find(begin(engines), end(engines), value) ==
+			    end(engines)) {
+				cerr << "Unknown engine " << value << '\n';
+				return 1;
+			}
+			opt.engines.push_back(value);
+		}
+		else if ((arg == "-r" || arg == "-c" || arg == "-n") &&
+		         i + 1 != argc) {
+			auto x = stoul(argv[++i]);
+			if (arg == "-r")
+				opt.repeats = max(1ul, x);
+			else if (arg == "-c")
+				opt.min_calls = max(1ul, x);
+			else
+				opt.max_misspellings = x;
+		}
+		else {
+			paths.push_back(arg);
+		}
+	}
+	if (paths.empty() || paths.size() > 2) {
+		print_help(program_name);
+		return 1;
+	}
+	if (opt.engines.empty())
+		opt.engines.assign(begin(engines), end(engines));
+
+	auto misspellings = vector<Misspelling>();
+	if (!read_misspellings(paths[0], misspellings)) {
+		cerr << "Can not read " << paths[0] << '\n';
+		return 1;
+	}
+	auto path = string();
+	auto made_dictionary = paths.size() == 1;
+	if (made_dictionary) {
+		auto tmp = getenv("TMPDIR");
+		auto stamp = chrono::steady_clock::now().time_since_epoch();
+		path = string(tmp && *tmp ? tmp : "/tmp") + "/suggest-bench-" +
+		       to_string(stamp.count());
+		if (!write_list_dictionary(misspellings, path)) {
+			cerr << "Can not write " << path << ".dic\n";
+			return 1;
+		}
+	}
+	else {
+		path = paths[1];
+		if (path.size() > 4 &&
+		    path.compare(path.size() - 4, 4, ".dic") == 0)
+			path.erase(path.size() - 4);
+	}
+
+	atexit(report_exit_while_loading);
+	auto results = vector<Engine_Result>();
+	if (auto d = load_nuspell(path)) {
+		auto is_correct = [&](const Misspelling& m) {
+			return d->spell(m.word, d->locale_aff) != BAD_WORD;
+		};
+		misspellings.erase(remove_if(begin(misspellings),
+		                             end(misspellings), is_correct),
+		                   end(misspellings));
+		if (opt.max_misspellings != 0 &&
+		    misspellings.size() > opt.max_misspellings)
+			misspellings.resize(opt.max_misspellings);
+		for (auto& e : opt.engines) {
+			if (misspellings.empty())
+				break;
+			auto r = Engine_Result();
+			r.dictionary = made_dictionary ? paths[0] : path;
+			r.engine = e;
+			if (run_engine(path, misspellings, opt, r))
+				results.push_back(move(r));
+		}
+	}
+	if (made_dictionary) {
+		remove((path + ".aff").c_str());
+		remove((path + ".dic").c_str());
+	}
+	if (results.empty()) {
+		cerr << "No misspellings to suggest for\n";
+		return 1;
+	}
+	if (!opt.json)
+		print_table_header();
+	for (auto& r : results)
+		print_result(r, opt.json);
+	return 0;
+}
@@ -0,0 +1,89 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file synthetic_dic.hxx
+ * Generator of synthetic dictionaries for the benchmarks.
+ */
+
+#ifndef NUSPELL_SYNTHETIC_DIC_HXX
+#define NUSPELL_SYNTHETIC_DIC_HXX
+
+#include <random>
+#include <string>
+
+namespace nuspell {
+
+const char synthetic_aff[] = R"(SET UTF-8
+FLAG long
+PFX Aa Y 1
+PFX Aa 0 re .
+SFX Bb Y 2
+SFX Bb y ies [^aeiou]y
+SFX Bb 0 s [^y]
+SFX Cc Y 1
+SFX Cc 0 ed .
+)";
+
+/**
+ * @brief Generates .dic file with mix of words similar to real dictionaries.
+ *
+ * Mostly lower case words with flags, some capitalized, all caps and camel
+ * case words, some words with morphological fields. The flags are those of
+ * synthetic_aff. The output is the same for the same n.
+ */
+inline auto generate_dic(size_t n) -> std::string
+{
+	using namespace std;
+	auto rng = minstd_rand(n);
+	auto letters = string("abcdefghijklmnopqrstuvwxyz");
+	auto letter = uniform_int_distribution<size_t>(0, 25);
+	auto length = uniform_int_distribution<size_t>(3, 14);
+	auto kind = uniform_int_distribution<int>(0, 99);
+	const char* flags[] = {"", "/Aa", "/Bb", "/AaBb", "/BbCc", "/AaBbCc"};
+	auto flag = uniform_int_distribution<size_t>(0, 5);
+
+	auto out = to_string(n) + '\n';
+	out.reserve(n * 16);
+	auto word = string();
+	for (size_t i = 0; i != n; ++i) {
+		word.clear();
+		auto len = length(rng);
+		for (size_t j = 0; j != len; ++j)
+			word += letters[letter(rng)];
+		auto k = kind(rng);
+		if (k < 10)
+			word[0] -= 'a' - 'A';
+		else if (k < 12)
+			for (auto& c : word)
+				c -= 'a' - 'A';
+		else if (k < 13)
+			word[len / 2] -= 'a' - 'A';
+		if (k % 7 == 0)
+			word += u8"é";
+		out += word;
+		out += flags[flag(rng)];
+		if (k >= 95)
+			out += " po:noun";
+		out += '\n';
+	}
+	return out;
+}
+} // namespace nuspell
+
+#endif // NUSPELL_SYNTHETIC_DIC_HXX
@@ -0,0 +1,208 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../src/nuspell/dictionary.hxx"
+
+using namespace std;
+using namespace std::literals::string_literals;
+using namespace nuspell;
+
+namespace {
+auto aff_utf8 = R"(SET UTF-8
+LANG en_US
+TRY esianrtolcdugmphbyfvkwz
+KEY qwertyuiop|asdfghjkl|zxcvbnm
+BREAK 2
+BREAK ^-
+BREAK ‒
+ICONV 1
+ICONV ’ '
+REP 1
+REP f ph
+COMPOUNDFLAG X
+FORBIDDENWORD !
+PFX A Y 1
+PFX A 0 re .
+SFX B Y 3
+SFX B y ies [^aeiou]y
+SFX B 0 s [aeiou]y
+SFX B 0 s [^y]
+SFX C N 1
+SFX C 0 ção/B .
+)";
+auto dic_utf8 = R"(8
+work/AB
+hello/B
+Paris
+fly/B
+wörk/X
+bëll/X
+bad/!
+bad/B
+)";
+
+auto aff_latin1 = "SET ISO8859-1\nSFX B Y 1\nSFX B 0 s .\n";
+auto dic_latin1 = "2\ncaf\xE9/B\nd\xE9j\xE0\n";
+
+auto parse(const char* aff, const char* dic)
+{
+	auto aff_ss = istringstream(aff);
+	auto dic_ss = istringstream(dic);
+	return Dictionary::load_from_aff_dic(aff_ss, dic_ss);
+}
+
+auto roundtrip(const Dictionary& d)
+{
+	auto ss = stringstream();
+	REQUIRE(d.write_compiled(ss));
+	return Dictionary::load_from_compiled(ss);
+}
+
+template <class Table>
+auto affix_keys(const Table& t)
+{
+	using StrT = typename Table::value_type::StrT;
+	auto ret = vector<pair<char16_t, StrT>>();
+	for (auto& x : t)
+		ret.emplace_back(x.flag, x.appending);
+	return ret;
+}
+} // namespace
+
+TEST_CASE("compiled dictionary round trip UTF-8", "[compiled_dic]")
+{
+	auto d = parse(aff_utf8, dic_utf8);
+	auto c = roundtrip(d);
+
+	REQUIRE(c.words.size() == d.words.size());
+	CHECK(c.words.is_compiled());
+	for (auto&& w : d.words) {
+		auto word = string(w.first.data(), w.first.size());
+		auto r1 = d.words.equal_range(word);
+		auto r2 = c.words.equal_range(word);
+		REQUIRE(distance(r1.first, r1.second) ==
+		        distance(r2.first, r2.second));
+		CHECK(equal(r1.first, r1.second, r2.first,
+		            [](auto&& a, auto&& b) {
+			            return a.first == b.first &&
+			                   a.second == b.second;
+		            }));
+	}
+	CHECK(distance(c.words.begin(), c.words.end()) ==
+	      ptrdiff_t(c.words.size()));
+	auto missing = c.words.equal_range("xyz"s);
+	CHECK(missing.first == missing.second);
+	CHECK(c.try_chars == d.try_chars);
+	CHECK(c.keyboard_layout == d.keyboard_layout);
+	CHECK(c.replacements == d.replacements);
+	CHECK(c.compound_flag == d.compound_flag);
+	CHECK(c.forbiddenword_flag == d.forbiddenword_flag);
+	CHECK(affix_keys(c.wide_structures.prefixes) ==
+	      affix_keys(d.wide_structures.prefixes));
+	CHECK(affix_keys(c.wide_structures.suffixes) ==
+	      affix_keys(d.wide_structures.suffixes));
+	auto& b1 = d.wide_structures.break_table;
+	auto& b2 = c.wide_structures.break_table;
+	CHECK(equal(begin(b1.start_word_breaks()), end(b1.start_word_breaks()),
+	            begin(b2.start_word_breaks()), end(b2.start_word_breaks())));
+	CHECK(equal(begin(b1.middle_word_breaks()),
+	            end(b1.middle_word_breaks()),
+	            begin(b2.middle_word_breaks()),
+	            end(b2.middle_word_breaks())));
+
+	auto words = {L"work",     L"works",    L"rework",     L"reworks",
+	              L"hello",    L"hellos",   L"Paris",      L"PARIS",
+	              L"flies",    L"flys",     L"wörkbëll",   L"bëllwörk",
+	              L"bad",      L"bads",     L"work‒hello", L"-work",
+	              L"work’s",   L"Hello",    L"worked",     L"xyz"};
+	for (auto& w : words)
+		CHECK(c.spell_priv<wchar_t>(w) == d.spell_priv<wchar_t>(w));
+	CHECK(c.spell_priv<wchar_t>(L"reworks") == GOOD_WORD);
+	CHECK(c.spell_priv<wchar_t>(L"flies") == GOOD_WORD);
+	CHECK(c.spell_priv<wchar_t>(L"bad") == BAD_WORD);
+}
+
+TEST_CASE("compiled dictionary round trip singlebyte", "[compiled_dic]")
+{
+	auto d = parse(aff_latin1, dic_latin1);
+	auto c = roundtrip(d);
+
+	REQUIRE(c.words.size() == d.words.size());
+	CHECK(affix_keys(c.structures.suffixes) ==
+	      affix_keys(d.structures.suffixes));
+	auto words = {"caf\xE9"s, "caf\xE9s"s, "d\xE9j\xE0"s, "d\xE9j\xE0s"s};
+	for (auto& w : words)
+		CHECK(c.spell_priv<char>(w) == d.spell_priv<char>(w));
+	CHECK(c.spell_priv<char>("caf\xE9s") == GOOD_WORD);
+}
+
+TEST_CASE("compiled dictionary validation", "[compiled_dic]")
+{
+	auto d = parse(aff_utf8, dic_utf8);
+	auto ss = stringstream();
+	REQUIRE(d.write_compiled(ss));
+	auto data = ss.str();
+
+	auto load = [](const string& s) {
+		auto in = istringstream(s);
+		auto c = Dictionary();
+		return c.parse_compiled(in);
+	};
+	CHECK(load(data));
+	CHECK_FALSE(load(""));
+	CHECK_FALSE(load(data.substr(0, data.size() / 2)));
+
+	// flipped byte in the word table
+	auto corrupted = data;
+	corrupted[corrupted.size() - 9] ^= 0x55;
+	CHECK_FALSE(load(corrupted));
+
+	corrupted = data;
+	corrupted[0] = 'X';
+	CHECK_FALSE(load(corrupted));
+}
+
+TEST_CASE("compiled dictionary loaded from file", "[compiled_dic]")
+{
+	auto d = parse(aff_utf8, dic_utf8);
+	auto path = "compiled_dic_test.cdic"s;
+	{
+		ofstream out(path, ios_base::binary);
+		REQUIRE(d.write_compiled(out));
+	}
+	auto c = Dictionary::load_from_compiled(path);
+	auto c2 = Dictionary::load_from_compiled(path);
+	remove(path.c_str());
+
+	CHECK(c.words.is_compiled());
+	REQUIRE(c.words.size() == d.words.size());
+	auto words = {L"work", L"reworks", L"hellos", L"PARIS",  L"flies",
+	              L"bad",  L"bads",    L"wörk",   L"Wörk",   L"xyz"};
+	for (auto& w : words) {
+		CHECK(c.spell_priv<wchar_t>(w) == d.spell_priv<wchar_t>(w));
+		CHECK(c2.spell_priv<wchar_t>(w) == d.spell_priv<wchar_t>(w));
+	}
+	CHECK_THROWS_AS(Dictionary::load_from_compiled(path),
+	                std::ios_base::failure);
+}
@@ -0,0 +1,81 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <sstream>
+
+#include "../src/nuspell/delete_index.hxx"
+
+using namespace std;
+using namespace std::literals::string_literals;
+using namespace nuspell;
+
+TEST_CASE("function osa_distance", "[delete_index]")
+{
+	CHECK(osa_distance(""s, ""s) == 0);
+	CHECK(osa_distance("abc"s, ""s) == 3);
+	CHECK(osa_distance("kitten"s, "sitting"s) == 3);
+	CHECK(osa_distance("teh"s, "the"s) == 1);
+	CHECK(osa_distance("ca"s, "abc"s) == 3);
+	CHECK(osa_distance(L"grüßen"s, L"grüssen"s) == 2);
+}
+
+TEST_CASE("class Delete_Index", "[delete_index]")
+{
+	auto words = vector<string>{"the", "then", "than", "hello", "help",
+	                            "the", "cat",  "act"};
+	auto index = Delete_Index<char>();
+	CHECK(index.empty());
+	index.build(words, 2);
+	CHECK(index.size() == 7);
+	CHECK(index.max_distance() == 2);
+	CHECK(index.deletes() > index.size());
+	CHECK(index.memory_usage() > 0);
+	CHECK(index.build_seconds() >= 0);
+
+	auto out = vector<string>();
+	index.lookup("teh", 1, out);
+	CHECK(out == vector<string>{"the"});
+	index.lookup("teh", out);
+	CHECK(out == vector<string>{"the", "then"});
+	index.lookup("the", 1, out);
+	CHECK(out == vector<string>{"then"});
+	index.lookup("helo", 1, out);
+	CHECK(out == vector<string>{"hello", "help"});
+	index.lookup("tac", 1, out);
+	CHECK(out.empty());
+	index.lookup("tac", 2, out);
+	CHECK(out == vector<string>{"act", "cat", "than", "the"});
+
+	auto ss = stringstream();
+	REQUIRE(index.write(ss));
+	auto index2 = Delete_Index<char>();
+	REQUIRE(index2.read(ss));
+	CHECK(index2.size() == index.size());
+	CHECK(index2.deletes() == index.deletes());
+	index2.lookup("teh", out);
+	CHECK(out == vector<string>{"the", "then"});
+
+	auto wide = Delete_Index<wchar_t>();
+	auto bad = stringstream(ss.str());
+	CHECK(!wide.read(bad));
+	bad = stringstream(ss.str().substr(0, ss.str().size() - 3));
+	CHECK(!index2.read(bad));
+	CHECK(index2.empty());
+}
@@ -71,6 +71,50 @@ TEST_CASE("suffixes", "[dictionary]")
 		CHECK(d.spell_priv<char>(w) == BAD_WORD);
 }
 
+TEST_CASE("checkword stats", "[dictionary]")
+{
+	boost::locale::generator gen;
+	auto d = Dictionary();
+	d.set_encoding_and_language("UTF-8");
+
+	d.words.emplace("berry", u"T");
+	d.words.emplace("vary", u"");
+
+	d.structures.suffixes.emplace(u'T', true, "y"s, "ies"s, Flag_Set(),
+	                              ".[^aeiou]y"s);
+
+	CHECK(d.get_checkword_stats() == nullptr);
+	d.enable_checkword_stats();
+	auto s = d.get_checkword_stats();
+	REQUIRE(s != nullptr);
+
+	CHECK(d.spell_priv<char>("berry") == GOOD_WORD);
+	CHECK(s->calls == 1);
+	CHECK(s->stages[CHECK_ROOT].accepted == 1);
+	CHECK(s->stages[CHECK_ROOT].dictionary_probes == 1);
+	CHECK(s->stages[CHECK_SUFFIX].calls == 0);
+
+	CHECK(d.spell_priv<char>("berries") == GOOD_WORD);
+	CHECK(s->calls == 2);
+	CHECK(s->stages[CHECK_ROOT].accepted == 1);
+	CHECK(s->stages[CHECK_SUFFIX].accepted == 1);
+	CHECK(s->stages[CHECK_SUFFIX].affix_candidates >= 1);
+	CHECK(s->stages[CHECK_SUFFIX].dictionary_probes >= 1);
+	CHECK(s->misses == 0);
+
+	CHECK(d.spell_priv<char>("varies") == BAD_WORD);
+	CHECK(s->misses != 0);
+	CHECK(s->stages[CHECK_COMPOUND].calls != 0);
+	CHECK(s->stages[CHECK_COMPOUND].accepted == 0);
+
+	CHECK(checkword_stage_name(CHECK_ROOT) == "root"s);
+	CHECK(checkword_stage_name(CHECK_COMPOUND) == "compound_check"s);
+
+	d.enable_checkword_stats(false);
+	CHECK(d.get_checkword_stats() == nullptr);
+	CHECK(d.spell_priv<char>("berry") == GOOD_WORD);
+}
+
 TEST_CASE("break_pattern", "[dictionary]")
 {
 	boost::locale::generator gen;
@@ -91,3 +135,380 @@ TEST_CASE("break_pattern", "[dictionary]")
 	for (auto& w : wrong)
 		CHECK(d.spell_priv<char>(w) == BAD_WORD);
 }
+
+TEST_CASE("compound rep", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("foo", u"A");
+	d.words.emplace("bar", u"A");
+	d.words.emplace("foobaz", u"");
+	d.compound_flag = u'A';
+	d.structures.replacement_table =
+	    vector<pair<string, string>>{{"r", "z"}};
+
+	CHECK(d.spell_priv<char>("foobar") == GOOD_WORD);
+	CHECK(d.spell_priv<char>("barfoo") == GOOD_WORD);
+	d.compound_check_rep = true;
+	CHECK(d.spell_priv<char>("foobar") == BAD_WORD);
+	CHECK(d.spell_priv<char>("barfoo") == GOOD_WORD);
+}
+
+TEST_CASE("analyze", "[dictionary]")
+{
+	boost::locale::generator gen;
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("work", u"PS");
+	d.words.emplace("works", u"");
+	d.words.emplace("berry", u"T");
+	d.words.emplace("bad", u"FS");
+	d.forbiddenword_flag = u'F';
+	d.structures.prefixes.emplace(u'P', true, ""s, "re"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'S', true, ""s, "ed"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'S', true, ""s, "s"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'T', true, "y"s, "ies"s, Flag_Set(),
+	                              ".[^aeiou]y"s);
+
+	auto out = vector<Word_Analysis>();
+	d.analyze_priv("reworked"s, out);
+	REQUIRE(out.size() == 1);
+	CHECK(out[0].root == "work");
+	CHECK(out[0].prefix_count == 1);
+	CHECK(out[0].prefixes[0] == u'P');
+	CHECK(out[0].suffix_count == 1);
+	CHECK(out[0].suffixes[0] == u'S');
+
+	d.analyze_priv("works"s, out);
+	REQUIRE(out.size() == 2);
+	CHECK(out[0].root == "works");
+	CHECK(out[0].prefix_count + out[0].suffix_count == 0);
+	CHECK(out[1].root == "work");
+	CHECK(out[1].suffix_count == 1);
+
+	d.analyze_priv("Berries"s, out);
+	REQUIRE(out.size() == 1);
+	CHECK(out[0].root == "berry");
+
+	d.analyze_priv("bads"s, out);
+	CHECK(out.empty());
+	d.analyze_priv("worker"s, out);
+	CHECK(out.empty());
+
+	auto loc = gen("en_US.UTF-8");
+	auto stems = vector<string>();
+	d.stem("REWORKS", stems, loc);
+	CHECK(stems == vector<string>{"work"});
+	d.stem("works", stems, loc);
+	CHECK(stems == vector<string>{"works", "work"});
+
+	auto batch = vector<vector<Word_Analysis>>();
+	d.analyze_batch({"reworks", "xyz", "berry"}, batch, loc);
+	REQUIRE(batch.size() == 3);
+	CHECK(batch[0].size() == 1);
+	CHECK(batch[1].empty());
+	CHECK(batch[2].size() == 1);
+}
+
+TEST_CASE("generate forms", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("work", u"PRS");
+	d.words.emplace("reworks", u"F");
+	d.words.emplace("berry", u"T");
+	d.words.emplace("bad", u"FS");
+	d.forbiddenword_flag = u'F';
+	d.structures.prefixes.emplace(u'P', true, ""s, "re"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'S', true, ""s, "ed"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'S', true, ""s, "s"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'R', true, ""s, "er"s, Flag_Set(u"S"),
+	                              "."s);
+	d.structures.suffixes.emplace(u'T', true, "y"s, "ies"s, Flag_Set(),
+	                              ".[^aeiou]y"s);
+
+	auto forms = vector<string>();
+	auto analyses = vector<Word_Analysis>();
+	d.generate_all_forms([&](auto& form, auto& a) {
+		forms.push_back(form);
+		analyses.push_back(a);
+	});
+	for (auto& f : forms)
+		CHECK(d.spell_priv<char>(f) != BAD_WORD);
+	auto expected = vector<string>{
+	    "berries", "berry",    "rework",    "reworked",
+	    "reworker", "reworkered", "reworkers", "work",
+	    "worked",  "worker",   "workered",  "workers",
+	    "works"};
+	auto sorted = forms;
+	sort(begin(sorted), end(sorted));
+	CHECK(sorted == expected);
+
+	auto i = find(begin(forms), end(forms), "reworkers") - begin(forms);
+	REQUIRE(i != ptrdiff_t(forms.size()));
+	CHECK(analyses[i].root == "work");
+	CHECK(analyses[i].prefix_count == 1);
+	CHECK(analyses[i].prefixes[0] == u'P');
+	CHECK(analyses[i].suffix_count == 2);
+	CHECK(analyses[i].suffixes[0] == u'S');
+	CHECK(analyses[i].suffixes[1] == u'R');
+
+	forms.clear();
+	d.generate_forms("berry", [&](auto& form, auto&) {
+		forms.push_back(form);
+	});
+	CHECK(forms == vector<string>{"berry", "berries"});
+	forms.clear();
+	d.generate_forms("bad", [&](auto& form, auto&) {
+		forms.push_back(form);
+	});
+	CHECK(forms.empty());
+}
+
+TEST_CASE("spell with form index", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("work", u"PS");
+	d.words.emplace("berry", u"TA");
+	d.words.emplace("foo", u"A");
+	d.words.emplace("bad", u"FS");
+	d.forbiddenword_flag = u'F';
+	d.compound_flag = u'A';
+	d.structures.prefixes.emplace(u'P', true, ""s, "re"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'S', true, ""s, "s"s, Flag_Set(),
+	                              "."s);
+	d.structures.suffixes.emplace(u'T', true, "y"s, "ies"s, Flag_Set(),
+	                              ".[^aeiou]y"s);
+
+	auto words = vector<string>{"work",   "works",  "reworks", "Reworks",
+	                            "berries", "BERRY", "bad",     "bads",
+	                            "fooberry", "foowork", "worx", ""};
+	auto expected = vector<Spell_Result>();
+	for (auto& w : words)
+		expected.push_back(d.spell_priv<char>(w));
+	d.build_form_index();
+	// the forbidden words are kept with their flags
+	CHECK(d.get_form_index<char>().size() == 9);
+	CHECK(d.get_form_index<wchar_t>().empty());
+	for (size_t i = 0; i != words.size(); ++i)
+		CHECK(d.spell_priv<char>(words[i]) == expected[i]);
+	// compounds are not in the index, but are still checked
+	CHECK(d.get_form_index<char>().lookup("fooberry") == nullptr);
+	CHECK(d.spell_priv<char>("fooberry") == GOOD_WORD);
+}
+
+TEST_CASE("suggest", "[dictionary]")
+{
+	boost::locale::generator gen;
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("berry", u"T");
+	d.words.emplace("have", u"");
+	d.words.emplace("the", u"");
+	d.words.emplace("vacation", u"");
+	d.words.emplace("Paris", u"");
+	d.words.emplace("cat", u"");
+	d.words.emplace("forbidden", u"F");
+	d.words.emplace("phone", u"");
+	d.forbiddenword_flag = u'F';
+
+	d.structures.suffixes.emplace(u'T', true, "y"s, "ies"s, Flag_Set(),
+	                              ".[^aeiou]y"s);
+	d.structures.try_chars = "aeiorntsh";
+	d.structures.replacement_table =
+	    vector<pair<string, string>>{{"f", "ph"}};
+
+	auto sugs = vector<string>();
+	auto first = [&](string w) {
+		d.suggest_priv(w, sugs);
+		return sugs.empty() ? ""s : sugs[0];
+	};
+	CHECK(first("teh") == "the");
+	CHECK(first("Teh") == "The");
+	CHECK(first("TEH") == "THE");
+	CHECK(first("ahev") == "have");
+	CHECK(first("berrie") == "berries");
+	CHECK(first("vacacation") == "vacation");
+	CHECK(first("paris") == "Paris");
+	CHECK(first("fone") == "phone");
+	CHECK(first("thecat") == "the cat");
+	CHECK(first("forbiden") != "forbidden");
+
+	d.suggest_priv("cats"s, sugs);
+	CHECK(sugs == vector<string>{"cat"});
+
+	d.suggest_budget.max_candidates = 1;
+	CHECK(first("vacacation") == "");
+	d.suggest_budget.max_candidates = 0;
+
+	// with the delete index, the edits of characters are looked up in it
+	d.build_delete_index(1, true);
+	CHECK(d.get_delete_index<char>().size() == 8);
+	CHECK(first("teh") == "the");
+	CHECK(first("Teh") == "The");
+	CHECK(first("berrie") == "berries");
+	CHECK(first("vacatoin") == "vacation");
+	CHECK(first("forbiden") == "");
+
+	// n-gram suggestions only if no edit is a valid word
+	CHECK(first("vacashion") == "");
+	d.build_ngram_index();
+	CHECK(first("vacashion") == "vacation");
+	CHECK(first("Vacashion") == "Vacation");
+	CHECK(first("teh") == "the");
+}
+
+TEST_CASE("suggest with KEY", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("bat", u"");
+	d.words.emplace("gas", u"");
+	d.words.emplace("has", u"");
+	d.structures.keyboard_table = "qwertyuiop|asdfghjkl|zxcvbnm";
+
+	auto sugs = vector<string>();
+	d.suggest_priv("bst"s, sugs);
+	CHECK(sugs == vector<string>{"bat"});
+	d.suggest_priv("bdt"s, sugs);
+	CHECK(sugs == vector<string>{"bat"});
+	d.suggest_priv("gs"s, sugs);
+	CHECK(sugs == vector<string>{"gas"});
+	// the nearer key first
+	d.suggest_priv("jas"s, sugs);
+	CHECK(sugs == vector<string>{"has", "gas"});
+}
+
+TEST_CASE("suggest with deadline", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("the", u"");
+	d.words.emplace("tea", u"");
+	d.structures.try_chars = "aeht";
+
+	using clock = chrono::steady_clock;
+	auto sugs = vector<string>();
+	auto report = d.suggest_priv("teh"s, sugs);
+	CHECK(sugs == vector<string>{"the", "tea"});
+	CHECK(!report.timed_out);
+	CHECK(report.candidates > 2);
+	for (auto c : report.completed)
+		CHECK(c);
+
+	report = d.suggest_priv("teh"s, sugs, clock::now());
+	CHECK(sugs.empty());
+	CHECK(report.timed_out);
+	CHECK(!report.completed[SUGGEST_CASE]);
+	CHECK(!report.completed[SUGGEST_TWO_WORDS]);
+
+	// enough suggestions in the middle of the swaps
+	d.suggest_budget.max_suggestions = 1;
+	report = d.suggest_priv("teh"s, sugs, clock::now() + chrono::hours(1));
+	CHECK(sugs == vector<string>{"the"});
+	CHECK(!report.timed_out);
+	CHECK(report.completed[SUGGEST_REP]);
+	CHECK(!report.completed[SUGGEST_SWAP]);
+	CHECK(!report.completed[SUGGEST_KEY]);
+	CHECK(!report.completed[SUGGEST_TWO_WORDS]);
+
+	CHECK(suggest_strategy_name(SUGGEST_CASE) == "case"s);
+	CHECK(suggest_strategy_name(SUGGEST_PHONETIC) == "phonetic"s);
+}
+
+TEST_CASE("suggest in parallel", "[dictionary]")
+{
+	boost::locale::generator gen;
+	auto d = Dictionary();
+	d.set_encoding_and_language("UTF-8");
+
+	auto words = {"the",    "then",  "than",     "they",  "them",
+	              "there",  "these", "through",  "thorough",
+	              "though", "thou",  "thought",  "tough", "cough",
+	              "rough",  "trough", "vacation", "station"};
+	for (auto w : words)
+		d.words.emplace(w, u"");
+	d.wide_structures.try_chars = L"abcdefghijklmnopqrstuvwxyz";
+	d.suggest_budget.max_suggestions = 0;
+
+	auto wrong = vector<string>{"teh",     "thuogh", "thorugh", "torugh",
+	                            "vacasion", "stasion", "tehre",  "xyz"};
+	auto loc = gen("en_US.UTF-8");
+	d.suggest_threads = 3;
+	auto batch = vector<vector<string>>();
+	d.suggest_batch(wrong, batch, loc);
+	REQUIRE(batch.size() == wrong.size());
+	auto sugs = vector<string>();
+	for (size_t i = 0; i != wrong.size(); ++i) {
+		d.suggest(wrong[i], sugs, loc);
+		CHECK(batch[i] == sugs);
+	}
+	CHECK(batch[0][0] == "the");
+}
+
+TEST_CASE("suggest with word trie", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("berry", u"T");
+	d.words.emplace("the", u"");
+	d.words.emplace("vacation", u"");
+	d.words.emplace("forbidden", u"F");
+	d.forbiddenword_flag = u'F';
+	d.structures.suffixes.emplace(u'T', true, "y"s, "ies"s, Flag_Set(),
+	                              ".[^aeiou]y"s);
+
+	auto sugs = vector<string>();
+	d.build_word_trie(1, true);
+	CHECK(d.get_word_trie<char>().size() == 4);
+	d.suggest_priv("Teh"s, sugs);
+	CHECK(sugs == vector<string>{"The"});
+	d.suggest_priv("berrie"s, sugs);
+	CHECK(sugs == vector<string>{"berries"});
+	d.suggest_priv("vacatoin"s, sugs);
+	CHECK(sugs == vector<string>{"vacation"});
+	d.suggest_priv("forbiden"s, sugs);
+	CHECK(sugs.empty());
+}
+
+TEST_CASE("suggest with phonetic index", "[dictionary]")
+{
+	auto d = Dictionary();
+	d.set_encoding_and_language("ISO8859-1");
+
+	d.words.emplace("phone", u"");
+	d.words.emplace("night", u"");
+	d.words.emplace("fen", u"N");
+	d.nosuggest_flag = u'N';
+	d.structures.phonetic_table = vector<pair<string, string>>{
+	    {"F", "F"},  {"GH", "_"}, {"N", "N"}, {"PH", "F"},
+	    {"T", "T"}, {"W", "_"}};
+
+	auto sugs = vector<string>();
+	d.suggest_priv("fone"s, sugs);
+	CHECK(sugs.empty());
+	d.build_phonetic_index();
+	CHECK(d.get_phonetic_index<char>().size() == 2);
+	d.suggest_priv("fone"s, sugs);
+	CHECK(sugs == vector<string>{"phone"});
+	d.suggest_priv("Fone"s, sugs);
+	CHECK(sugs == vector<string>{"Phone"});
+	d.suggest_priv("nite"s, sugs);
+	CHECK(sugs == vector<string>{"night"});
+}
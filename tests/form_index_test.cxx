@@ -0,0 +1,59 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include "../src/nuspell/form_index.hxx"
+
+using namespace std;
+using namespace std::literals::string_literals;
+using namespace nuspell;
+
+TEST_CASE("class Form_Index", "[form_index]")
+{
+	auto a = Flag_Set(u"AB");
+	auto b = Flag_Set(u"AB");
+	auto c = Flag_Set(u"X");
+	auto forms = vector<pair<string, const Flag_Set*>>{
+	    {"work", &a}, {"works", &b}, {"reworked", &c}, {"work", &c}};
+	auto index = Form_Index<char>();
+	CHECK(index.empty());
+	CHECK(index.lookup("work") == nullptr);
+	index.build(forms);
+	CHECK(index.size() == 3);
+	CHECK(index.memory_usage() > 0);
+
+	REQUIRE(index.lookup("work") != nullptr);
+	CHECK(*index.lookup("work") == a);
+	CHECK(index.lookup("works") == index.lookup("work"));
+	REQUIRE(index.lookup("reworked") != nullptr);
+	CHECK(*index.lookup("reworked") == c);
+	CHECK(index.lookup("wor") == nullptr);
+	CHECK(index.lookup("workss") == nullptr);
+	CHECK(index.lookup("") == nullptr);
+
+	index.clear();
+	CHECK(index.empty());
+	CHECK(index.lookup("work") == nullptr);
+
+	auto wide = Form_Index<wchar_t>();
+	wide.build({{L"größe", &a}, {L"grüße", &c}});
+	REQUIRE(wide.lookup(L"grüße") != nullptr);
+	CHECK(*wide.lookup(L"grüße") == c);
+	CHECK(wide.lookup(L"grosse") == nullptr);
+}
@@ -0,0 +1,212 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
+#include "../src/nuspell/aff_data.hxx"
+#include "../src/nuspell/hzip.hxx"
+
+using namespace std;
+using namespace std::literals::string_literals;
+using namespace nuspell;
+
+namespace {
+auto plain_text = "9\nwork/AB\nworking\nwalking\ntalking\ne-mail/S\nU.S.\n(x)\n"
+                  "po\tpos:noun\npo\tpos:noun\n"
+                  "internationalizationalization/A\n"
+                  "internationalizationalizations\n"
+                  "Z\xC3\xBCrich\nlast line"s;
+
+// plain_text compressed with hzip
+auto hzipped = string(
+    "\x68\x7A\x30\x00\x31\x29\x00\x06\xB4\x2E\x00\x06\xB0\x39\x00\x06"
+    "\xAC\x42\x00\x06\xA8\x6E\x00\x06\xA4\x23\x01\x06\xA0\x67\x04\x06"
+    "\x9C\x53\x1F\x06\x98\x78\x1F\x06\x94\x74\x20\x06\x90\x74\x25\x06"
+    "\x8C\x1F\x28\x06\x88\x1F\x2D\x06\x84\x1F\x2E\x06\x80\x2F\x41\x05"
+    "\x78\x2F\x53\x06\x74\x00\x55\x06\x70\x1D\x5A\x06\x6C\x6D\x61\x06"
+    "\x68\x6E\x61\x05\x60\x7A\x61\x06\x5C\x00\x65\x06\x58\x6E\x65\x06"
+    "\x54\x63\x68\x06\x50\x0B\x69\x06\x4C\x6C\x69\x05\x40\x72\x69\x06"
+    "\x48\x74\x69\x05\x38\x72\x6B\x06\x34\x00\x6C\x06\x30\x61\x6C\x05"
+    "\x28\x69\x6C\x06\x24\x3A\x6E\x06\x20\x69\x6E\x06\x1C\x6F\x6E\x05"
+    "\x10\x69\x6F\x06\x18\x70\x6F\x06\x0C\x77\x6F\x06\x08\x09\x70\x06"
+    "\x04\x65\x72\x06\x00\x00\x73\x05\xF8\x61\x73\x05\xF0\x6F\x73\x05"
+    "\xE8\x61\x74\x05\xE0\x6E\x74\x05\xD8\x6F\x75\x05\xD0\x69\x7A\x05"
+    "\xC8\xC3\xBC\x05\xC0\x00\x00\x05\xB8\xAC\x23\x5F\x50\xF3\x96\x88"
+    "\xD6\x85\xA2\x5D\x72\x09\xAC\x8A\x5B\x43\x07\xA4\x6A\x94\xF6\x03"
+    "\x0E\x22\xE7\x83\x31\x0B\x9C\x4F\xFB\x78\x49\x43\x3D\x22\x15\xB8",
+    240);
+
+// plain_text compressed with hzip -P secret
+auto hzipped_secret = string(
+    "\x68\x7A\x31\x16\x73\x54\x4A\x72\x63\xC0\x5D\x65\x65\xC2\x5C\x74"
+    "\x75\xC9\x21\x72\x63\xDC\x1D\x65\x65\xD6\x46\x75\x75\xC5\x04\x76"
+    "\x63\xE8\x20\x7A\x65\xEA\x1D\x6B\x75\xF1\x17\x52\x63\xE4\x07\x40"
+    "\x65\xFE\x7A\x5C\x75\xED\x7C\x5F\x63\xF0\x6C\x4B\x65\xF2\x4A\x35"
+    "\x76\x1D\x4C\x21\x63\x00\x73\x30\x65\x02\x78\x2E\x75\x09\x0E\x13"
+    "\x63\x1C\x1D\x04\x66\x12\x1F\x15\x75\x39\x63\x17\x63\x2C\x1D\x00"
+    "\x65\x26\x06\x1C\x75\x35\x68\x1B\x63\x38\x1F\x0C\x66\x32\x17\x1D"
+    "\x75\x2D\x17\x1B\x60\x4C\x01\x0E\x65\x46\x65\x18\x75\x55\x02\x1E"
+    "\x60\x5C\x1A\x09\x65\x56\x5F\x1A\x75\x45\x0A\x1C\x63\x68\x1C\x0B"
+    "\x66\x62\x0C\x1B\x75\x7D\x13\x1D\x63\x78\x04\x0A\x65\x7A\x6C\x04"
+    "\x75\x61\x06\x00\x63\x74\x73\x16\x66\x8A\x04\x07\x76\x95\x0C\x01"
+    "\x60\x9C\x12\x11\x66\x92\x0B\x00\x76\xBD\x0C\x07\x60\xA4\x1A\x1F"
+    "\x66\xBA\xA6\xC8\x76\xA5\x63\x72\x60\xCC\xAC\x23\x5F\x50\xF3\x96"
+    "\x88\xD6\x85\xA2\x5D\x72\x09\xAC\x8A\x5B\x43\x07\xA4\x6A\x94\xF6"
+    "\x03\x0E\x22\xE7\x83\x31\x0B\x9C\x4F\xFB\x78\x49\x43\x3D\x22\x15"
+    "\xB8",
+    241);
+
+auto decompress(const string& data, const string& key = "")
+{
+	auto in = istringstream(data);
+	Hzip_Istream hz(in, key);
+	REQUIRE_FALSE(hz.fail());
+	return string(istreambuf_iterator<char>(hz), {});
+}
+
+/**
+ * @brief Huffman codes the prefix compressed text with unary codes.
+ *
+ * Symbol i gets code of i ones followed by zero, so the codes get longer
+ * than the lookup table of the decoder.
+ */
+auto hz_encode_unary(const string& raw)
+{
+	auto symbols = vector<string>();
+	for (size_t i = 0; i + 1 < raw.size(); i += 2) {
+		auto s = raw.substr(i, 2);
+		if (find(begin(symbols), end(symbols), s) == end(symbols))
+			symbols.push_back(s);
+	}
+	symbols.push_back(raw.size() % 2 ? "\1"s + raw.back() : "\0\0"s);
+	auto n = symbols.size();
+	REQUIRE(n < 256);
+	auto code_size = [&](size_t i) { return i + 1 == n ? i : i + 1; };
+
+	auto out = "hz0"s;
+	out += char(n >> 8);
+	out += char(n & 0xFF);
+	for (size_t i = 0; i != n; ++i) {
+		auto code = string(code_size(i) / 8 + 1, '\0');
+		for (size_t j = 0; j != i; ++j)
+			code[j / 8] |= 0x80 >> j % 8;
+		out += symbols[i];
+		out += char(code_size(i));
+		out += code;
+	}
+	auto bits = vector<bool>();
+	auto put = [&](size_t i) {
+		for (size_t j = 0; j != code_size(i); ++j)
+			bits.push_back(j < i);
+	};
+	for (size_t i = 0; i + 1 < raw.size(); i += 2) {
+		auto it = find(begin(symbols), end(symbols), raw.substr(i, 2));
+		put(it - begin(symbols));
+	}
+	put(n - 1);
+	auto data = string((bits.size() + 7) / 8, '\0');
+	for (size_t i = 0; i != bits.size(); ++i)
+		if (bits[i])
+			data[i / 8] |= 0x80 >> i % 8;
+	return out + data;
+}
+} // namespace
+
+TEST_CASE("Hzip_Istream decompresses hzip output", "[hzip]")
+{
+	CHECK(decompress(hzipped) == plain_text);
+	CHECK(decompress(hzipped_secret, "secret") == plain_text);
+
+	auto in = istringstream(hzipped);
+	Hzip_Istream hz(in);
+	auto lines = vector<string>();
+	for (string line; getline(hz, line);)
+		lines.push_back(line);
+	REQUIRE(lines.size() == 14);
+	CHECK(lines[2] == "working");
+	CHECK(lines[3] == "walking");
+	CHECK(lines[5] == "e-mail/S");
+	CHECK(lines[8] == "po\tpos:noun");
+	CHECK(lines[9] == "po\tpos:noun");
+	CHECK(lines[11] == "internationalizationalizations");
+	CHECK(lines[13] == "last line");
+	CHECK(hz.eof());
+	CHECK_FALSE(hz.bad());
+}
+
+TEST_CASE("Hzip_Istream decodes long codes", "[hzip]")
+{
+	// prefix and suffix compressed lines, the odd byte goes to the end
+	auto raw = "abcdefghijklmnopqrstuvwxyz\0"s
+	           "ing\x21\x04"s
+	           "\x1F-\x1F.x\t y\x1E"s
+	           "tail"s;
+	CHECK(decompress(hz_encode_unary(raw)) ==
+	      "abcdefghijklmnopqrstuvwxyz\nabcdingyz\nabcdingyz-.x\t y\ntail");
+
+	// crosses the input and output chunks of the decoder
+	auto long_raw = string();
+	auto expected = string();
+	for (auto i = 0; i != 10000; ++i) {
+		long_raw += "abcdefghijklmnopqrstuvwxyz\0"s;
+		expected += "abcdefghijklmnopqrstuvwxyz\n";
+	}
+	CHECK(decompress(hz_encode_unary(long_raw)) == expected);
+}
+
+TEST_CASE("Hzip_Istream rejects invalid data", "[hzip]")
+{
+	auto open = [](const string& data, const string& key = "") {
+		auto in = istringstream(data);
+		return !Hzip_Istream(in, key).fail();
+	};
+	CHECK(open(hzipped));
+	CHECK_FALSE(open(""));
+	CHECK_FALSE(open("hz2"));
+	CHECK_FALSE(open(hzipped.substr(0, 100)));
+	CHECK_FALSE(open(hzipped_secret));
+	CHECK_FALSE(open(hzipped_secret, "wrong"));
+	CHECK(open(hzipped_secret, "secret"));
+
+	// truncated compressed text
+	auto in = istringstream(hzipped.substr(0, hzipped.size() - 8));
+	Hzip_Istream hz(in);
+	REQUIRE_FALSE(hz.fail());
+	auto text = string();
+	CHECK_THROWS_AS(text.assign(istreambuf_iterator<char>(hz), {}),
+	                ios_base::failure);
+	for (string line; getline(hz, line);)
+		;
+	CHECK(hz.bad());
+
+	// the .dic loaders catch it and fail
+	auto truncated = hzipped.substr(0, hzipped.size() - 8);
+	auto a = Aff_Data();
+	auto aff = istringstream("SET UTF-8\n");
+	REQUIRE(a.parse_aff(aff));
+	in = istringstream(truncated);
+	Hzip_Istream hz_dic(in);
+	CHECK_FALSE(a.parse_dic(hz_dic));
+	in = istringstream(truncated);
+	Hzip_Istream hz_lazy(in);
+	CHECK_FALSE(a.parse_dic_lazy(hz_lazy));
+}
@@ -172,3 +172,45 @@ TEST_CASE("icu ctype facets", "[locale_utils]")
 	CHECK(toupper('\xE8', loc) == '\xC8'); // ш to Ш
 	CHECK(toupper('\xC8', loc) == '\xC8'); // Ш to Ш
 }
+
+TEST_CASE("case mapping with precomputed tables", "[locale_utils]")
+{
+	boost::locale::generator g;
+	auto loc = g("en_US.UTF-8");
+
+	auto mismatches = vector<int>();
+	for (wchar_t c = 0; c <= 0xFFFF; ++c) {
+		if (0xD800 <= c && c <= 0xDFFF)
+			continue;
+		auto s = wstring(1, c);
+		if (to_upper(s, loc) != boost::locale::to_upper(s, loc) ||
+		    to_lower(s, loc) != boost::locale::to_lower(s, loc) ||
+		    to_title(s, loc) != boost::locale::to_title(s, loc))
+			mismatches.push_back(c);
+	}
+	CHECK(mismatches.empty());
+
+	CHECK(L"TABLE" == to_upper(L"tAble"s, loc));
+	CHECK(L"table" == to_lower(L"TaBLE"s, loc));
+	CHECK(L"Table" == to_title(L"tABLE"s, loc));
+	CHECK(L"" == to_title(L""s, loc));
+	CHECK(L"GRÜSSEN" == to_upper(L"grüßen"s, loc));
+	CHECK(L"ǅemal" == to_title(L"ǆEMAL"s, loc));
+	CHECK(L"ΟΔΟΣ" == to_upper(L"οδος"s, loc));
+	CHECK(L"οδος" == to_lower(L"ΟΔΟΣ"s, loc));
+	CHECK(L"ǅ" == to_title(L"Ǆ"s, loc));
+	CHECK(L"Hello, World" == to_title(L"hello, world"s, loc));
+	CHECK(L"O'neil" == to_title(L"o'NEIL"s, loc));
+	CHECK("ЗДРАВО" == to_upper("здраво"s, loc));
+	CHECK("здраво" == to_lower("ЗДРАВО"s, loc));
+	CHECK("Здраво" == to_title("зДРАВО"s, loc));
+
+	loc = g("tr_TR.UTF-8");
+	CHECK(L"İSTANBUL" == to_upper(L"istanbul"s, loc));
+	CHECK(L"istanbul" == to_lower(L"İSTANBUL"s, loc));
+	CHECK(L"İstanbul" == to_title(L"istanbul"s, loc));
+	CHECK(L"dıyarbakır" == to_lower(L"DIYARBAKIR"s, loc));
+
+	loc = g("en_US.ISO8859-1");
+	CHECK("\xC9\xC9N" == to_upper("\xE9\xE9n"s, loc)); // één to ÉÉN
+}
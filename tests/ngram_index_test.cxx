@@ -0,0 +1,64 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include "../src/nuspell/ngram_index.hxx"
+
+using namespace std;
+using namespace std::literals::string_literals;
+using namespace nuspell;
+
+TEST_CASE("class Ngram_Index", "[ngram_index]")
+{
+	auto words = vector<string>{"necessary", "accessory", "necessity",
+	                            "recess",    "sea",       "necessary"};
+	auto index = Ngram_Index<char>();
+	CHECK(index.empty());
+	index.build(words);
+	CHECK(index.size() == 5);
+	CHECK(index.memory_usage() > 0);
+
+	auto out = vector<string>();
+	index.lookup("nessesary", 2, out);
+	CHECK(out == vector<string>{"necessary", "necessity"});
+	index.lookup("nessesary", 1, out);
+	CHECK(out == vector<string>{"necessary"});
+	index.lookup("necessary", 5, out);
+	CHECK(out == vector<string>{"necessity", "accessory"});
+	index.lookup("xyz", 5, out);
+	CHECK(out.empty());
+	index.lookup("nessesary", 0, out);
+	CHECK(out.empty());
+
+	auto wide = Ngram_Index<wchar_t>();
+	wide.build({L"größe", L"grüße", L"gruss"});
+	auto wout = vector<wstring>();
+	wide.lookup(L"grösse", 1, wout);
+	CHECK(wout == vector<wstring>{L"größe"});
+
+	// the bigrams of the key, e.g. the lower case or a pronunciation
+	auto keyed = Ngram_Index<char>();
+	keyed.build(vector<pair<string, string>>{
+	    {"paris", "Paris"}, {"parris", "Paris"}, {"pairs", "pairs"}});
+	CHECK(keyed.size() == 3);
+	keyed.lookup("parris", 2, out);
+	CHECK(out == vector<string>{"Paris"});
+	keyed.lookup("Paris", 2, out);
+	CHECK(out.empty());
+}
@@ -162,3 +162,91 @@ TEST_CASE("class String_Set", "[structures]")
 		CHECK(ss1 != ss3);
 	}
 }
+
+TEST_CASE("class Phonetic_Table", "[structures]")
+{
+	auto rules = vector<pair<string, string>>{
+	    {"AH(AEIOUY)-^", "*H"}, {"A^", "*"},   {"A(HR)", "_"},
+	    {"BB-", "_"},           {"B", "B"},    {"CH", "X"},
+	    {"C(EIY)-", "S"},       {"CK", "K"},   {"CC<", "C"},
+	    {"C", "K"},             {"F", "F"},    {"GH(AEIOUY)-", "K"},
+	    {"GH", "_"},            {"G", "K"},    {"ING6", "N"},
+	    {"I^", "*"},            {"LL-", "_"},  {"L", "L"},
+	    {"PH", "F"},            {"P", "P"},    {"S", "S"},
+	    {"T", "T"},             {"E^", "*"},   {"MB$", "M"},
+	    {"M", "M"},             {"N", "N"},    {"O^", "*"},
+	    {"R", "R"},             {"U^", "*"},   {"Y(AEIOU)-", "Y"}};
+	auto table = Phonetic_Table<char>(rules);
+	CHECK(table.size() == rules.size());
+	CHECK(table.phonetic_code("PHONE") == "FN");
+	CHECK(table.phonetic_code("FONE") == "FN");
+	CHECK(table.phonetic_code("PHILLIP") == "FLP");
+	CHECK(table.phonetic_code("SINGING") == "SNN");
+	CHECK(table.phonetic_code("LAMB") == "LM");
+	CHECK(table.phonetic_code("BOBBY") == "BB");
+	CHECK(table.phonetic_code("ACCENT") == "*KSNT");
+	CHECK(table.phonetic_code("CHECK") == "XK");
+	CHECK(table.phonetic_code("GHOST") == "KST");
+	CHECK(table.phonetic_code("AHEAD") == "*H");
+	CHECK(table.phonetic_code("ARCH") == "*RX");
+	CHECK(table.phonetic_code("NIGHT") == "NT");
+	CHECK(table.phonetic_code("") == "");
+
+	auto wide = Phonetic_Table<wchar_t>({{L"SS", L"S"}, {L"ß", L"S"}});
+	CHECK(wide.phonetic_code(L"GROSS") == L"S");
+	CHECK(wide.phonetic_code(L"GROß") == L"S");
+	CHECK(Phonetic_Table<char>().empty());
+}
+
+TEST_CASE("class Keyboard_Table", "[structures]")
+{
+	auto table = Keyboard_Table<char>("qwert|asdf|aq");
+	auto neighbours = [&](char key) {
+		auto ret = vector<pair<char, int>>();
+		for (auto& n : table.neighbours(key))
+			ret.emplace_back(n.neighbour, n.distance);
+		return ret;
+	};
+	using V = vector<pair<char, int>>;
+	CHECK(neighbours('w') == V{{'q', 1}, {'e', 1}, {'r', 2}});
+	CHECK(neighbours('e') == V{{'w', 1}, {'r', 1}, {'q', 2}, {'t', 2}});
+	CHECK(neighbours('a') == V{{'s', 1}, {'q', 1}, {'d', 2}});
+	CHECK(neighbours('q') == V{{'w', 1}, {'a', 1}, {'e', 2}});
+	CHECK(neighbours('z').empty());
+	CHECK(Keyboard_Table<char>("").empty());
+	CHECK(Keyboard_Table<char>("|x|").empty());
+
+	auto wide = Keyboard_Table<wchar_t>(L"öüó");
+	CHECK(wide.neighbours(L'ü').size() == 2);
+}
+
+TEST_CASE("class Replacement_Table", "[structures]")
+{
+	auto table = Replacement_Table<char>({{"a", "b"},
+	                                      {"aa", "c"},
+	                                      {"^a", "d"},
+	                                      {"a$", "e"},
+	                                      {"^aa$", "f"},
+	                                      {"ba", "g"},
+	                                      {"^", "h"},
+	                                      {"a", "i"}});
+	CHECK(table.size() == 7);
+	auto out = vector<string>();
+	table.replace_each("aa", out);
+	CHECK(out == vector<string>{"ba", "ab", "c", "da", "ae", "f", "ia",
+	                            "ai"});
+	table.replace_each("bab", out);
+	CHECK(out == vector<string>{"bbb", "gb", "bib"});
+	table.replace_each("xyz", out);
+	CHECK(out.empty());
+	table.replace_each("", out);
+	CHECK(out.empty());
+
+	// patterns that are suffixes of other patterns
+	auto suffixes = Replacement_Table<wchar_t>(
+	    {{L"ösz", L"1"}, {L"sz", L"2"}, {L"z", L"3"}, {L"szö", L"4"}});
+	auto wide = vector<wstring>();
+	suffixes.replace_each(L"öszö", wide);
+	CHECK(wide == vector<wstring>{L"1ö", L"ö2ö", L"ös3ö", L"ö4"});
+	CHECK(Replacement_Table<char>().empty());
+}
@@ -73,11 +73,14 @@ if [[ ! -f "$in_dict.dic" ]]; then
 	exit 3
 fi
 
+function check_good_and_wrong () {
+local dict="$1"
+
 # Tests good words
 in_file="$in_dict.good"
 
 if [[ -f $in_file ]]; then
-	out=$(hunspell -l -i "$ENCODING" "$@" -d "$in_dict" < "$in_file" \
+	out=$(hunspell -l -i "$ENCODING" "${args[@]}" -d "$dict" < "$in_file" \
 	      | tr -d "$CR")
 	if [[ $? -ne 0 ]]; then exit 2; fi
 	if [[ "$out" != "" ]]; then
@@ -94,7 +97,7 @@ check_valgrind_log "good words"
 in_file="$in_dict.wrong"
 
 if [[ -f $in_file ]]; then
-	out=$(hunspell -G -i "$ENCODING" "$@" -d "$in_dict" < "$in_file" \
+	out=$(hunspell -G -i "$ENCODING" "${args[@]}" -d "$dict" < "$in_file" \
 	      | tr -d "$CR") #strip carige return for mingw builds
 	if [[ $? -ne 0 ]]; then exit 2; fi
 	if [[ "$out" != "" ]]; then
@@ -106,14 +109,44 @@ if [[ -f $in_file ]]; then
 fi
 
 check_valgrind_log "bad words"
+}
 
-exit 0 # XXXX DISABLES TESTING SUGGESTIONS. remove when suggestions are implemented
+args=("$@")
+check_good_and_wrong "$in_dict"
+
+# Tests good and bad words with the compiled dictionary
+if [[ "$COMPILE" != "" ]]; then
+	mkdir $TEMPDIR 2> /dev/null || :
+	compiled_dict="$TEMPDIR/$(basename "$NAME").cdic"
+	"$LIBTOOL" --mode=execute "$COMPILE" "$in_dict" "$compiled_dict"
+	if [[ $? -ne 0 ]]; then exit 2; fi
+	# The parser quits early on some malformed dictionaries, then
+	# there is nothing to check, same as with the plain dictionary.
+	if [[ -f "$compiled_dict" ]]; then
+		check_good_and_wrong "$compiled_dict"
+		rm -f "$compiled_dict"
+	fi
+fi
+
+# Tests good and bad words with the dictionary compressed with hzip
+if [[ "$HZIP" != "" ]]; then
+	mkdir $TEMPDIR 2> /dev/null || :
+	hz_dict="$TEMPDIR/$(basename "$NAME")"
+	cp "$in_dict.aff" "$hz_dict.aff" && cp "$in_dict.dic" "$hz_dict.dic"
+	if [[ $? -ne 0 ]]; then exit 2; fi
+	"$LIBTOOL" --mode=execute "$HZIP" "$hz_dict.aff" "$hz_dict.dic"
+	if [[ $? -ne 0 ]]; then exit 2; fi
+	rm -f "$hz_dict.aff" "$hz_dict.dic"
+	check_good_and_wrong "$hz_dict"
+	rm -f "$hz_dict.aff.hz" "$hz_dict.dic.hz"
+fi
 
 # Tests morphological analysis
 in_file="$in_dict.good"
 expected_file="$in_dict.morph"
 
-if [[ -f $expected_file ]]; then
+# the analyze tool is optional
+if [[ -f $expected_file && -x "$ANALYZE" ]]; then
 	#in=$(sed 's/	$//' "$in_file") #passes without this.
 	out=$(analyze "$in_dict.aff" "$in_dict.dic" "$in_file" \
 	      | tr -d "$CR") #strip carige return for mingw builds
@@ -129,18 +162,20 @@ fi
 
 check_valgrind_log "morphological analysis"
 
-# Tests suggestions
+# Tests suggestions, a .nuspell.sug file holds the expected suggestions
+# where they differ from Hunspell's, see v1cmdline/Makefile.am
 in_file=$in_dict.wrong
 expected_file=$in_dict.sug
+[[ -f $in_dict.nuspell.sug ]] && expected_file=$in_dict.nuspell.sug
 
 if [[ -f $expected_file ]]; then
-	out=$(hunspell -i "$ENCODING" "$@" -a -d "$in_dict" <"$in_file" | \
+	out=$(hunspell -i "$ENCODING" "${args[@]}" -d "$in_dict" <"$in_file" | \
 	      { grep -a '^&' || true; } | sed 's/^[^:]*: //')
 	if [[ $? -ne 0 ]]; then exit 2; fi
 	expected=$(<"$expected_file")
 	if [[ "$out" != "$expected" ]]; then
 		echo "============================================="
-		echo "Fail in $NAME.sug. Bad suggestion?"
+		echo "Fail in $expected_file. Bad suggestion?"
 		diff "$expected_file" <(echo "$out")
 		exit 1
 	fi
@@ -0,0 +1,74 @@
+/* Copyright 2018 Dimitrij Mijoski
+ *
+ * This file is part of Nuspell.
+ *
+ * Nuspell is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nuspell is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuspell.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include "../src/nuspell/delete_index.hxx"
+#include "../src/nuspell/word_trie.hxx"
+
+using namespace std;
+using namespace std::literals::string_literals;
+using namespace nuspell;
+
+TEST_CASE("class Word_Trie", "[word_trie]")
+{
+	auto words = vector<string>{"the", "then", "than", "hello", "help",
+	                            "the", "cat",  "act"};
+	auto trie = Word_Trie<char>();
+	CHECK(trie.empty());
+	trie.build(words, 2);
+	CHECK(trie.size() == 7);
+	CHECK(trie.node_count() == 19);
+	CHECK(trie.max_distance() == 2);
+	CHECK(trie.memory_usage() > 0);
+	CHECK(trie.build_seconds() >= 0);
+
+	auto out = vector<string>();
+	trie.lookup("teh", 1, out);
+	CHECK(out == vector<string>{"the"});
+	trie.lookup("teh", out);
+	CHECK(out == vector<string>{"the", "then"});
+	trie.lookup("the", 1, out);
+	CHECK(out == vector<string>{"then"});
+	trie.lookup("helo", 1, out);
+	CHECK(out == vector<string>{"hello", "help"});
+	trie.lookup("tac", 1, out);
+	CHECK(out.empty());
+	trie.lookup("tac", 2, out);
+	CHECK(out == vector<string>{"act", "cat", "than", "the"});
+	trie.lookup("", 2, out);
+	CHECK(out.empty());
+
+	// same results as the delete index
+	auto index = Delete_Index<char>();
+	index.build(words, 2);
+	auto expected = vector<string>();
+	for (auto w : {"thn", "hepl", "xyz", "cta", "thenn", "hellp", "a"}) {
+		trie.lookup(w, out);
+		index.lookup(w, expected);
+		CHECK(out == expected);
+	}
+
+	auto wide = Word_Trie<wchar_t>();
+	wide.build({L"größe", L"grüße", L"gruß"}, 1);
+	auto wout = vector<wstring>();
+	wide.lookup(L"grüse", wout);
+	CHECK(wout == vector<wstring>{L"grüße"});
+	wide.clear();
+	CHECK(wide.empty());
+}